@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Append-only archive of fetched pages.
+//
+// <path>       records, each one a fixed header followed by the requested
+//              url, the final url, the raw response headers and the
+//              zlib compressed body. the header tells what the fetch was
+//              for, so only pages are read back as pages.
+// <path>.idx   fixed size {url hash, offset, size} entries, one for the
+//              requested url and one for the final url when it differs.
+//
+// Both files are only ever appended to, and an index entry is written after
+// its record, so a crawl killed midway leaves a readable archive.
+
+// What a fetch was made for
+enum class RecordKind : std::uint8_t
+{
+  page,
+  robots,  // robots.txt
+  sitemap,
+  head,    // a redirect resolved without a body
+};
+
+struct ArchiveRecord
+{
+  std::string url;       // as requested
+  std::string final_url; // after redirects
+  long status{};
+  std::string headers;
+  std::string body;
+  RecordKind kind = RecordKind::page;
+};
+
+class ArchiveWriter
+{
+public:
+  explicit ArchiveWriter(std::filesystem::path const& path);
+
+  void append(ArchiveRecord const& record);
+  auto path() const -> std::filesystem::path const& { return m_path; }
+
+private:
+  std::filesystem::path m_path;
+  std::ofstream m_data;
+  std::ofstream m_index;
+  std::uint64_t m_offset{};
+  std::string m_compressed; // reused between appends
+  std::mutex m_mutex;
+};
+
+class ArchiveReader
+{
+public:
+  explicit ArchiveReader(std::filesystem::path const& path);
+  ~ArchiveReader();
+  ArchiveReader(ArchiveReader const&) = delete;
+  ArchiveReader& operator=(ArchiveReader const&) = delete;
+
+  // latest record fetched as, or redirected to, {url}
+  auto find(std::string_view url) const -> std::optional<ArchiveRecord>;
+
+  // every record in append order, safe to read from several threads
+  auto size() const -> std::size_t { return m_records.size(); }
+  auto record(std::size_t i) const -> ArchiveRecord { return read(m_records.at(i)); }
+
+private:
+  struct Span
+  {
+    std::uint64_t offset;
+    std::uint64_t size;
+  };
+
+  auto read(Span span) const -> ArchiveRecord; // throws on a record that does not fit its span
+  auto entry(std::uint32_t position) const -> Span;
+
+  struct Mapping
+  {
+    void* data = nullptr;
+    std::size_t size = 0;
+  };
+
+  Mapping m_data;
+  Mapping m_index;
+  std::vector<Span> m_records;
+  std::vector<std::uint32_t> m_by_hash; // positions of the valid entries of the mapped index, by url hash
+};
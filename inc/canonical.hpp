@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// How urls of a host are reduced to a canonical form. Two urls with the
+// same canonical form are assumed to be the same page and fetched once.
+struct CanonicalRules
+{
+  bool lowercase_host = true;
+  bool strip_default_port = true;
+  bool strip_www = false;
+  bool strip_trailing_slash = true;
+  bool decode_unreserved = true; // %41 -> A, and uppercase the remaining escapes
+
+  bool keep_query = true;
+  bool sort_query = true;
+  std::vector<std::string> keep_params; // when not empty, only these are kept
+  std::vector<std::string> drop_params; // a trailing '*' matches a prefix, e.g. "utm_*"
+
+  std::vector<std::string> index_files{"index.html", "index.htm"};
+
+  // tracking and session parameters, which never select content
+  static auto default_drop_params() -> std::vector<std::string>;
+};
+
+class Canonicalizer
+{
+public:
+  Canonicalizer();
+  explicit Canonicalizer(CanonicalRules defaults);
+
+  // rules for {host} and its subdomains, the most specific host wins
+  void set_rules(std::string host, CanonicalRules rules);
+  auto rules_for(std::string_view host) const -> CanonicalRules const&;
+
+  // writes the canonical form of {url} into {out} and returns its 64 bit
+  // fingerprint, fnv1a64 of {out}, computed while writing it.
+  // urls without an authority are copied as they are.
+  auto canonicalize(std::string_view url, std::string& out) const -> std::uint64_t;
+  auto canonicalize(std::string_view url) const -> std::string;
+
+  // shared instance with the default rules
+  auto static defaults() -> Canonicalizer const&;
+
+private:
+  struct HostHash
+  {
+    using is_transparent = void;
+    auto operator()(std::string_view host) const -> std::size_t { return std::hash<std::string_view>{}(host); }
+  };
+
+  CanonicalRules m_defaults;
+  std::unordered_map<std::string, CanonicalRules, HostHash, std::equal_to<>> m_hosts;
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Groups of pages drawn as one node in an overview of a big crawl
+struct Clusters
+{
+  struct Edge
+  {
+    int from{};
+    int to{};
+    int weight{}; // links between the two clusters
+  };
+
+  std::vector<int> of;                  // cluster of every node
+  std::vector<std::vector<int>> members; // nodes of every cluster, ascending
+  std::vector<Edge> edges;              // between clusters, one per ordered pair
+
+  auto size() const -> std::size_t { return members.size(); }
+};
+
+struct ClusterOptions
+{
+  int max_rounds = 20;
+  std::size_t min_size = 3;    // smaller communities are pooled per host
+  std::size_t max_size = 2000; // bigger ones are split per host, then until they fit
+  std::uint64_t seed = 1;
+};
+
+// Label propagation on the undirected link graph: every node repeatedly
+// takes the label most of its links carry, until nothing changes. Near
+// linear in the number of links. Returns a label per node, not dense.
+auto propagate_labels(std::size_t nodes, std::vector<std::pair<int, int>> const& edges,
+  int max_rounds = 20, std::uint64_t seed = 1) -> std::vector<int>;
+
+// Communities from propagate_labels(), with the stragglers and the giants
+// web graphs tend to produce regrouped by host. A host still too big is
+// split by the communities of its own links, and at worst into runs of
+// consecutive pages. {hosts} holds a host hash per node.
+auto cluster_graph(std::vector<std::uint64_t> const& hosts, std::vector<std::pair<int, int>> const& edges,
+  ClusterOptions const& options = {}) -> Clusters;
@@ -0,0 +1,837 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+//
+#include <fmt/color.h>
+#include <fmt/core.h>
+//
+#include <archive.hpp>
+#include <frontier.hpp>
+#include <link_buffer.hpp>
+#include <page_cache.hpp>
+#include <retry.hpp>
+#include <robots.hpp>
+#include <scope.hpp>
+#include <shard.hpp>
+#include <simhash.hpp>
+#include <url.hpp>
+
+// Totals of the current crawl
+struct CrawlStats
+{
+  std::size_t pages_fetched{};
+  std::size_t bytes_fetched{};
+  std::size_t merged{}; // pages merged into one they duplicate
+  std::size_t not_modified{}; // answered 304, links taken from the cache
+  std::size_t unchanged{};    // downloaded again, but the same as last time
+  std::size_t disallowed{};   // kept out by robots.txt
+  std::size_t extra_fetched{}; // robots.txt files and sitemaps, counted as pages by the budget
+};
+
+// What became of a page, as far as the crawl got
+enum class PageStatus : std::uint8_t
+{
+  found,     // in the graph, not fetched (yet)
+  fetched,
+  unchanged, // fetched, links taken from the page cache
+  retrying,
+  failed,
+  merged,     // a duplicate of another page
+  disallowed, // by robots.txt
+};
+
+// Told about the graph as the crawl grows it, on the crawling thread. Calls
+// come for every page and link, so they must return quickly.
+class CrawlListener
+{
+public:
+  virtual ~CrawlListener() = default;
+  virtual void page_added(int index, std::string_view url, int depth) = 0;
+  virtual void page_status(int index, PageStatus) = 0;
+  virtual void link_added(int from, int to) = 0;
+};
+
+// The crawl loop, put together from policies at compile time:
+//
+//   Fetcher        fetch(url, Response&) fills {final url, content} or throws
+//                  FetchError / std::runtime_error. optional: effective_url(url),
+//                  prefetch(host), live(), false to skip politeness waits, and
+//                  fetch(url, Response&, Validators) -> bool with validators(),
+//                  conditional GETs for the page cache, and fetch(url, Response&,
+//                  RecordKind) for robots.txt and sitemaps, so an archive
+//                  tells them from pages.
+//   LinkExtractor  parse(base, content, LinkBuffer&). optional: fingerprint(),
+//                  for duplicate detection. built from the Canonicalizer if it can be.
+//   Canonicalizer  canonicalize(url, std::string&) and canonicalize(url).
+//   GraphStore     add_node, find, get_url, add_link, reserve_links, merge,
+//                  raise_depth, see PageGraph. rebuild() also needs Edges,
+//                  intern and commit.
+//
+// The per link path is all in this header, so it inlines, and tests can
+// run the whole loop against an in-memory web without a virtual call.
+template<typename Fetcher, typename LinkExtractor, typename Canonicalizer, typename GraphStore>
+class Crawler
+{
+public:
+  using Index = int;
+  using Response = typename Fetcher::Response;
+
+  Crawler() :
+    m_extractor(make_extractor(m_canonicalizer))
+  {
+  }
+
+  Crawler(Crawler const&) = delete;
+  Crawler& operator=(Crawler const&) = delete;
+
+  // resolves the root, queues it with its sitemap pages and crawls {depth} levels
+  void crawl(std::string const& url, int depth);
+  // crawls this shard's part of the web from {url}, trading links with the
+  // other shards through the spool until every shard is done
+  void crawl_shard(std::string const& url, int depth);
+  void start(int depth); // resets the budget counters
+  void enqueue(Index, int depth);
+  auto add_page(std::string const& url, int depth) -> Index; // into the graph, told to the listener
+  void crawl_frontier();                                     // visits queued pages, best first, within budget
+  auto visit_page(Index, int depth, int attempt = 0) -> bool; // fetches one page and queues its links
+  auto budget_exhausted() const -> bool;
+  auto normalize_url(std::string_view url) const -> std::string { return m_canonicalizer.canonicalize(url); }
+
+  auto robots_for(std::string_view url) -> RobotsRules const&; // fetched once per origin
+  auto robots_allow(std::string_view url) -> bool { return robots_for(url).allowed(url_target(url)); }
+  auto seed_sitemaps(std::string const& root_url, int depth) -> int;
+  // the graph of the pages in {archive}, parsed on {threads} threads. pages
+  // get their ids in archive order, robots.txt and sitemaps are left out
+  auto rebuild(ArchiveReader const& archive, int threads) -> int; // pages added
+
+  auto fetcher() -> Fetcher& { return m_fetcher; }
+  auto extractor() -> LinkExtractor& { return m_extractor; }
+  auto canonicalizer() -> Canonicalizer& { return m_canonicalizer; } // per host url rules
+  auto graph() -> GraphStore& { return m_graph; }
+  auto graph() const -> GraphStore const& { return m_graph; }
+  auto scope() -> CrawlScope& { return m_scope; }     // which links get queued
+  auto frontier() -> Frontier& { return m_frontier; } // crawl order, see Frontier::set_scorer
+  auto budget() -> CrawlBudget& { return m_budget; }
+  auto retries() -> RetryQueue& { return m_retries; }
+  auto robots() -> RobotsCache& { return m_robots; }
+  auto hosts() -> HostScheduler& { return m_hosts; }            // politeness delay per host
+  auto duplicates() -> SimHashIndex& { return m_duplicates; }   // pages seen, by content
+  auto stats() const -> CrawlStats const& { return m_stats; }
+  void set_respect_robots(bool enabled) { m_respect_robots = enabled; }
+  void set_verbose(bool enabled) { m_verbose = enabled; } // progress output
+  void set_spool(std::unique_ptr<ShardSpool> spool) { m_spool = std::move(spool); }
+  void set_cache(std::unique_ptr<PageCache> cache) { m_cache = std::move(cache); }
+  auto cache() -> PageCache* { return m_cache.get(); } // set for incremental re-crawls
+  auto spool() -> ShardSpool* { return m_spool.get(); } // set when crawling as one shard of many
+  void set_listener(CrawlListener* listener) { m_listener = listener; } // not owned, nullptr to stop
+  void set_max_sitemap_pages(std::size_t pages) { m_max_sitemap_pages = pages; } // seeded per crawl
+
+private:
+  static constexpr bool has_effective_url = requires(Fetcher& f, std::string const& url) {
+    { f.effective_url(url) } -> std::convertible_to<std::optional<std::string>>;
+  };
+  static constexpr bool has_prefetch = requires(Fetcher& f, std::string_view host) { f.prefetch(host); };
+  static constexpr bool has_live = requires(Fetcher const& f) {
+    { f.live() } -> std::convertible_to<bool>;
+  };
+  static constexpr bool has_conditional_fetch = requires(Fetcher& f, std::string const& url, Response& out, Validators const& known) {
+    { f.fetch(url, out, known) } -> std::convertible_to<bool>;
+    { f.validators() } -> std::convertible_to<Validators>;
+  };
+  static constexpr bool has_record_kind = requires(Fetcher& f, std::string const& url, Response& out) {
+    f.fetch(url, out, RecordKind::robots);
+  };
+  static constexpr bool has_fingerprint = requires(LinkExtractor const& e) {
+    { e.fingerprint() } -> std::convertible_to<ContentFingerprint>;
+  };
+
+  void add_link(Index from, Index to)
+  {
+    m_graph.add_link(from, to);
+    if(m_listener) {
+      m_listener->link_added(from, to);
+    }
+  }
+
+  // {index} is drawn as {original} from now on, and not expanded
+  void merge_duplicate(Index index, Index original, int distance)
+  {
+    m_graph.merge(index, original);
+    ++m_stats.merged;
+    set_status(index, PageStatus::merged);
+    report(fg(fmt::color::light_gray), "   🪞 Duplicate of {} ({} bits apart), not expanded\n", m_graph.get_url(original), distance);
+  }
+
+  // robots.txt or a sitemap, into m_robots_response
+  void fetch_extra(std::string const& url, RecordKind kind)
+  {
+    if constexpr(has_record_kind) {
+      m_fetcher.fetch(url, m_robots_response, kind);
+    } else {
+      m_fetcher.fetch(url, m_robots_response);
+    }
+  }
+
+  void set_status(Index index, PageStatus status)
+  {
+    if(m_listener) {
+      m_listener->page_status(index, status);
+    }
+  }
+
+  auto static make_extractor(Canonicalizer const& canonicalizer) -> LinkExtractor
+  {
+    if constexpr(std::is_constructible_v<LinkExtractor, Canonicalizer const&>) {
+      return LinkExtractor(canonicalizer);
+    } else {
+      return LinkExtractor();
+    }
+  }
+
+  // when a request to the host of a frontier entry may go
+  auto host_ready_at(std::uint64_t host) const -> HostScheduler::Clock::time_point
+  {
+    return live() ? m_hosts.ready_at(host) : HostScheduler::Clock::time_point{};
+  }
+
+  auto live() const -> bool
+  {
+    if constexpr(has_live) {
+      return m_fetcher.live();
+    } else {
+      return true;
+    }
+  }
+
+  template<typename... Args>
+  void report(fmt::text_style style, fmt::format_string<Args...> format, Args&&... args)
+  {
+    if(m_verbose) {
+      fmt::print(style, "{}", fmt::format(format, std::forward<Args>(args)...));
+    }
+  }
+
+  template<typename... Args>
+  void report_error(fmt::format_string<Args...> format, Args&&... args)
+  {
+    if(m_verbose) {
+      fmt::print(stderr, fg(fmt::color::red), "{}", fmt::format(format, std::forward<Args>(args)...));
+    }
+  }
+
+  Canonicalizer m_canonicalizer;
+  Fetcher m_fetcher;
+  LinkExtractor m_extractor;
+  GraphStore m_graph;
+  std::unique_ptr<ShardSpool> m_spool;
+  std::unique_ptr<PageCache> m_cache;
+  CrawlListener* m_listener = nullptr;
+
+  CrawlScope m_scope;
+  int m_root_depth{}; // depth the crawl started with, links are {m_root_depth - depth} levels away
+  Frontier m_frontier;
+  CrawlBudget m_budget;
+  CrawlStats m_stats;
+  CrawlBudget::Clock::time_point m_crawl_start;
+  RetryQueue m_retries;
+  RobotsCache m_robots;
+  HostScheduler m_hosts;
+  bool m_respect_robots = true;
+  bool m_verbose = true;
+  std::size_t m_max_sitemap_pages = 1000;
+  SimHashIndex m_duplicates;
+
+  // recycled between pages
+  LinkBuffer m_links;
+  Response m_response;
+  std::string m_final_url;
+  Response m_robots_response;
+};
+
+template<typename Fetcher, typename LinkExtractor, typename Canonicalizer, typename GraphStore>
+void Crawler<Fetcher, LinkExtractor, Canonicalizer, GraphStore>::crawl(std::string const& url, int depth)
+{
+  std::string root_url = url;
+  if constexpr(has_effective_url) {
+    std::optional<std::string> effective_url = m_fetcher.effective_url(url);
+    if(!effective_url) {
+      throw std::runtime_error("Failed to get effective url in crawl.");
+    }
+    root_url = std::move(*effective_url);
+  }
+  root_url = normalize_url(root_url);
+
+  // builds root node and crawls {depth} times
+  start(depth);
+  enqueue(add_page(root_url, depth), depth);
+  if(m_respect_robots && depth > 1) {
+    seed_sitemaps(root_url, depth);
+  }
+  crawl_frontier();
+}
+
+template<typename Fetcher, typename LinkExtractor, typename Canonicalizer, typename GraphStore>
+void Crawler<Fetcher, LinkExtractor, Canonicalizer, GraphStore>::crawl_shard(std::string const& url, int depth)
+{
+  // keeps idle shards from spinning on the spool files
+  constexpr std::chrono::milliseconds poll_interval{250};
+
+  if(!m_spool) {
+    throw std::runtime_error("crawl_shard() requires a spool.");
+  }
+
+  // every shard resolves the root, only its owner crawls it
+  std::string root_url = url;
+  if constexpr(has_effective_url) {
+    std::optional<std::string> effective_url = m_fetcher.effective_url(url);
+    if(!effective_url) {
+      throw std::runtime_error("Failed to get effective url in crawl_shard.");
+    }
+    root_url = std::move(*effective_url);
+  }
+  root_url = normalize_url(root_url);
+
+  start(depth);
+  if(m_spool->owns(root_url)) {
+    enqueue(add_page(root_url, depth), depth);
+  }
+
+  // crawl whatever the other shards forward until everyone is done
+  while(true) {
+    crawl_frontier();
+    m_spool->flush();
+
+    std::vector<ShardLink> links = m_spool->receive();
+    if(links.empty()) {
+      if(m_spool->finished()) {
+        break;
+      }
+      std::this_thread::sleep_for(poll_interval);
+      continue;
+    }
+
+    for(ShardLink const& link : links) {
+      if(m_graph.find(link.url)) {
+        continue;
+      }
+      enqueue(add_page(link.url, link.depth), link.depth);
+    }
+  }
+}
+
+template<typename Fetcher, typename LinkExtractor, typename Canonicalizer, typename GraphStore>
+void Crawler<Fetcher, LinkExtractor, Canonicalizer, GraphStore>::start(int depth)
+{
+  m_root_depth = depth;
+  m_stats = CrawlStats{};
+  m_crawl_start = CrawlBudget::Clock::now();
+}
+
+template<typename Fetcher, typename LinkExtractor, typename Canonicalizer, typename GraphStore>
+void Crawler<Fetcher, LinkExtractor, Canonicalizer, GraphStore>::enqueue(Index index, int depth)
+{
+  if(depth > 0) {
+    std::string_view host = url_host(m_graph.get_url(index));
+    m_frontier.push(index, depth, host);
+    if constexpr(has_prefetch) {
+      m_fetcher.prefetch(host); // resolved long before the page is fetched
+    }
+  }
+}
+
+template<typename Fetcher, typename LinkExtractor, typename Canonicalizer, typename GraphStore>
+auto Crawler<Fetcher, LinkExtractor, Canonicalizer, GraphStore>::add_page(std::string const& url, int depth) -> Index
+{
+  Index index = m_graph.add_node(url, depth);
+  if(m_listener) {
+    m_listener->page_added(index, url, depth);
+  }
+  return index;
+}
+
+template<typename Fetcher, typename LinkExtractor, typename Canonicalizer, typename GraphStore>
+auto Crawler<Fetcher, LinkExtractor, Canonicalizer, GraphStore>::budget_exhausted() const -> bool
+{
+  return m_budget.exhausted(m_stats.pages_fetched + m_stats.extra_fetched, m_stats.bytes_fetched, CrawlBudget::Clock::now() - m_crawl_start);
+}
+
+template<typename Fetcher, typename LinkExtractor, typename Canonicalizer, typename GraphStore>
+void Crawler<Fetcher, LinkExtractor, Canonicalizer, GraphStore>::crawl_frontier()
+{
+  // how far down the frontier to look for a host that may be fetched now
+  constexpr std::size_t host_lookahead = 64;
+
+  using Clock = HostScheduler::Clock;
+
+  while(!m_frontier.empty() || !m_retries.empty()) {
+    if(budget_exhausted()) {
+      report(fg(fmt::color::yellow), "\n💰 Crawl budget spent, {} pages left in the frontier\n", m_frontier.size() + m_retries.size());
+      return;
+    }
+
+    // failed pages come back once their backoff has passed, and their host is ready
+    Clock::time_point now = Clock::now();
+    if(std::optional<RetryEntry> retry = m_retries.pop_ready(now)) {
+      Clock::time_point ready = host_ready_at(fnv1a64(url_host(m_graph.get_url(retry->index))));
+      if(ready > now) {
+        m_retries.defer(*retry, ready);
+      } else {
+        visit_page(retry->index, retry->depth, retry->attempt);
+      }
+      continue;
+    }
+
+    // the best page whose host may be fetched now. a host waiting out its
+    // delay does not hold up the others
+    Clock::time_point wake = Clock::time_point::max();
+    std::optional<FrontierEntry> entry = m_frontier.pop_ready([&](FrontierEntry const& candidate) {
+      Clock::time_point ready = host_ready_at(candidate.host);
+      wake = std::min(wake, ready);
+      return ready <= now;
+    }, host_lookahead);
+    if(entry) {
+      // robots.txt is read on the first visit to an origin, so only the shard
+      // that owns a host ever asks for it. the page then waits its turn
+      // again, with the links it has gathered
+      std::string const& url = m_graph.get_url(entry->index);
+      if(m_respect_robots && live() && !m_robots.find(url_origin(url))) {
+        robots_for(url);
+        m_frontier.defer(*entry);
+        continue;
+      }
+      visit_page(entry->index, entry->depth);
+      continue;
+    }
+
+    // every host in sight is waiting
+    if(std::optional<RetryEntry::Clock::time_point> retry = m_retries.next_ready()) {
+      wake = std::min(wake, *retry);
+    }
+    std::this_thread::sleep_until(wake);
+  }
+}
+
+template<typename Fetcher, typename LinkExtractor, typename Canonicalizer, typename GraphStore>
+auto Crawler<Fetcher, LinkExtractor, Canonicalizer, GraphStore>::visit_page(Index index, int depth, int attempt) -> bool
+{
+  std::string const& url = m_graph.get_url(index);
+
+  // we've gone far enough
+  if(depth == 0) {
+    return false;
+  }
+
+  // only pages this crawl owns get here, see crawl_frontier()
+  if(m_respect_robots && !robots_allow(url)) {
+    ++m_stats.disallowed;
+    report(fg(fmt::color::light_gray), "🤖 Disallowed by robots.txt → {}\n", url);
+    set_status(index, PageStatus::disallowed);
+    return false;
+  }
+
+  report(fg(fmt::color::cyan) | fmt::emphasis::bold,
+    "\n🔍 Crawling (depth {}, {} queued) → {}\n", depth, m_frontier.size(), url);
+
+  auto const& [raw_final_url, content] = m_response;
+  CachedPage const* cached = m_cache ? m_cache->find(url) : nullptr;
+  bool modified = true;
+
+  try {
+    // crawl_frontier() only picks pages whose host is ready
+    if(live()) {
+      m_hosts.visited(url_host(url), HostScheduler::Clock::now());
+    }
+    if constexpr(has_conditional_fetch) {
+      if(cached && !cached->validators.empty()) {
+        modified = m_fetcher.fetch(url, m_response, cached->validators);
+      } else {
+        m_fetcher.fetch(url, m_response);
+      }
+    } else {
+      m_fetcher.fetch(url, m_response);
+    }
+  }
+  catch(const FetchError& e) {
+    // timeouts and server errors get another go later, the crawl moves on
+    if(e.retryable() && m_retries.schedule(index, depth, attempt + 1, RetryQueue::Clock::now())) {
+      report(fg(fmt::color::orange), "🔁 {}, retrying later (attempt {})\n", e.what(), attempt + 2);
+      set_status(index, PageStatus::retrying);
+      return false;
+    }
+    report(fg(fmt::color::red), "❌ Error fetching {}: {}\n", url, e.what());
+    set_status(index, PageStatus::failed);
+    return false;
+  }
+  catch(const std::exception& e) {
+    report(fg(fmt::color::red), "❌ Error fetching {}: {}\n", url, e.what());
+    set_status(index, PageStatus::failed);
+    return false;
+  }
+
+  ++m_stats.pages_fetched;
+  m_stats.bytes_fetched += content.size();
+  LinkBuffer& children = m_links;
+  std::uint64_t content_hash = m_cache && modified ? fnv1a64(content) : 0;
+
+  // a page that did not change keeps the links it had last time, unparsed
+  if(cached && (!modified || cached->content_hash == content_hash)) {
+    if(modified) {
+      ++m_stats.unchanged;
+      // the same body under new validators, which the next crawl should send
+      if constexpr(has_conditional_fetch) {
+        Validators validators = m_fetcher.validators();
+        if(validators.etag != cached->validators.etag || validators.last_modified != cached->validators.last_modified) {
+          CachedPage page = *cached;
+          page.validators = std::move(validators);
+          m_cache->store(url, std::move(page));
+          cached = m_cache->find(url);
+        }
+      }
+    } else {
+      ++m_stats.not_modified;
+    }
+
+    // still the copy it was, or a copy of a page met earlier in this crawl
+    if(!cached->duplicate_of.empty()) {
+      std::optional<Index> original = m_graph.find(cached->duplicate_of);
+      if(original && *original != index) {
+        merge_duplicate(index, *original, 0);
+        return false;
+      }
+    }
+    if constexpr(has_fingerprint) {
+      if(cached->fingerprint.exact != 0) {
+        if(std::optional<SimHashIndex::Match> original = m_duplicates.find(cached->fingerprint)) {
+          if(original->id != index) {
+            merge_duplicate(index, original->id, original->distance);
+            return false;
+          }
+        }
+        m_duplicates.insert(cached->fingerprint, index);
+      }
+    }
+
+    m_final_url = cached->final_url;
+    children.clear();
+    for(std::string const& link : cached->links) {
+      children.next() = link;
+      children.commit();
+    }
+    report(fg(fmt::color::light_gray), "   💤 Unchanged since the last crawl\n");
+    set_status(index, PageStatus::unchanged);
+  } else {
+    m_canonicalizer.canonicalize(raw_final_url, m_final_url);
+
+    // Building blocks
+    try {
+      m_extractor.parse(m_final_url, content, children);
+    }
+    catch(const std::exception& e) {
+      report(fg(fmt::color::red), "❌ {}\n", e.what());
+      set_status(index, PageStatus::failed);
+      return false;
+    }
+
+    // mirrors, print views and the like join the page they copy, unexpanded.
+    // a copy is cached too, so the next crawl merges it without parsing
+    std::optional<SimHashIndex::Match> original;
+    ContentFingerprint fingerprint;
+    if constexpr(has_fingerprint) {
+      fingerprint = m_extractor.fingerprint();
+      original = m_duplicates.find(fingerprint);
+      if(original && original->id == index) {
+        original.reset();
+      }
+      if(!original) {
+        m_duplicates.insert(fingerprint, index);
+      }
+    }
+
+    if(m_cache) {
+      CachedPage page{
+        .final_url = m_final_url,
+        .content_hash = content_hash,
+        .fingerprint = fingerprint,
+        .duplicate_of = original ? m_graph.get_url(original->id) : std::string{},
+        .links = {children.begin(), children.end()},
+      };
+      if constexpr(has_conditional_fetch) {
+        page.validators = m_fetcher.validators();
+      }
+      m_cache->store(url, std::move(page));
+    }
+
+    if(original) {
+      merge_duplicate(index, original->id, original->distance);
+      return false;
+    }
+    set_status(index, PageStatus::fetched);
+  }
+
+  if(children.empty()) {
+    report_error("📉 Failed to extract links from: {}\n", m_final_url);
+  }
+  m_graph.reserve_links(index, children.size());
+
+  report(fg(fmt::color::green), "   ↳ Found {} links\n", children.size());
+
+  // children
+  int ended = 0;
+  int added = 0;
+  int duplicates = 0;
+  int linked = 0;
+  int forwarded = 0;
+  int out_of_scope = 0;
+
+  int level = m_root_depth - depth + 1;
+  for(std::string const& child_url : children) {
+    // off target links never reach the graph
+    if(!m_scope.allows(child_url, level)) {
+      ++out_of_scope;
+      continue;
+    }
+
+    // avoids crawling the same page twice, but still counts the link
+    if(std::optional<Index> known = m_graph.find(child_url)) {
+      add_link(index, *known);
+      if(m_frontier.contains(*known)) {
+        m_frontier.add_in_link(*known, depth - 1);
+        m_graph.raise_depth(*known, depth - 1); // what the frontier will crawl it with
+      }
+      ++linked;
+      ++duplicates;
+      continue;
+    }
+
+    Index child_index = add_page(child_url, depth - 1);
+    add_link(index, child_index);
+    ++added;
+    ++linked;
+
+    // owned by another shard, which crawls it for us
+    if(m_spool && !m_spool->owns(child_url)) {
+      if(depth - 1 > 0) {
+        m_spool->forward(child_url, depth - 1);
+        ++forwarded;
+      }
+      continue;
+    }
+
+    if(depth - 1 > 0) {
+      enqueue(child_index, depth - 1);
+    } else {
+      ++ended;
+    }
+  }
+
+  report(fg(fmt::color::medium_sea_green), "   🕷️ Crawled → {}\n", url);
+
+  if(added > 0) {
+    report(fg(fmt::color::blue), "      ➕ Added {} new nodes\n", added);
+  }
+
+  if(ended > 0) {
+    report(fg(fmt::color::light_gray), "      ⏹️  {} branches ended at this depth\n", ended);
+  }
+
+  if(duplicates > 0) {
+    report(fg(fmt::color::light_gray), "      ♻️  {} duplicates skipped\n", duplicates);
+  }
+
+  if(linked > 0) {
+    report(fg(fmt::color::light_gray), "      🔗  {} nodes linked\n", linked);
+  }
+
+  if(out_of_scope > 0) {
+    report(fg(fmt::color::light_gray), "      🚧  {} links out of scope\n", out_of_scope);
+  }
+
+  if(forwarded > 0) {
+    report(fg(fmt::color::light_gray), "      📤  {} links forwarded to other shards\n", forwarded);
+  }
+
+  return true;
+}
+
+template<typename Fetcher, typename LinkExtractor, typename Canonicalizer, typename GraphStore>
+auto Crawler<Fetcher, LinkExtractor, Canonicalizer, GraphStore>::robots_for(std::string_view url) -> RobotsRules const&
+{
+  // token looked up in robots.txt groups
+  constexpr std::string_view agent = "crawler";
+
+  std::string_view origin = url_origin(url);
+  if(RobotsRules const* rules = m_robots.find(origin)) {
+    return *rules;
+  }
+
+  // a missing robots.txt allows everything. a failing server keeps us out,
+  // as RFC 9309 asks, since it probably cannot take the crawl anyway
+  RobotsRules rules;
+  std::string robots_url = std::string(origin) + "/robots.txt";
+  try {
+    ++m_stats.extra_fetched;
+    if(live()) {
+      m_hosts.visited(url_host(origin), HostScheduler::Clock::now());
+    }
+    fetch_extra(robots_url, RecordKind::robots);
+    m_stats.bytes_fetched += m_robots_response.second.size();
+    rules = RobotsRules::parse(m_robots_response.second, agent);
+  }
+  catch(const FetchError& e) {
+    if(e.status() >= 500) {
+      rules = RobotsRules::disallow_all();
+    }
+  }
+  catch(const std::exception&) {
+  }
+
+  if(rules.crawl_delay()) {
+    m_hosts.set_delay(url_host(origin), *rules.crawl_delay());
+  }
+
+  return m_robots.insert(origin, std::move(rules));
+}
+
+template<typename Fetcher, typename LinkExtractor, typename Canonicalizer, typename GraphStore>
+auto Crawler<Fetcher, LinkExtractor, Canonicalizer, GraphStore>::seed_sitemaps(std::string const& root_url, int depth) -> int
+{
+  // enough for any real site, and keeps a runaway index in check. the
+  // pages they list are capped separately, by m_max_sitemap_pages
+  constexpr std::size_t max_sitemaps = 64;
+
+  std::vector<std::string> pending = robots_for(root_url).sitemaps();
+  std::unordered_set<std::string> seen(pending.begin(), pending.end());
+  std::size_t fetched = 0;
+  int seeded = 0;
+
+  std::optional<Index> root = m_graph.find(root_url);
+  while(!pending.empty() && fetched < max_sitemaps && static_cast<std::size_t>(seeded) < m_max_sitemap_pages) {
+    std::string sitemap_url = std::move(pending.back());
+    pending.pop_back();
+    ++fetched;
+
+    Sitemap sitemap;
+    try {
+      ++m_stats.extra_fetched;
+      fetch_extra(sitemap_url, RecordKind::sitemap);
+      m_stats.bytes_fetched += m_robots_response.second.size();
+      sitemap = parse_sitemap(gunzip(m_robots_response.second));
+    }
+    catch(const std::exception& e) {
+      report(fg(fmt::color::red), "❌ Error reading sitemap {}: {}\n", sitemap_url, e.what());
+      continue;
+    }
+
+    for(std::string& nested : sitemap.sitemaps) {
+      if(seen.insert(nested).second) {
+        pending.push_back(std::move(nested));
+      }
+    }
+
+    // sitemap pages count as one link away from the root, and are drawn so.
+    // robots.txt is checked when they are visited
+    for(std::string const& loc : sitemap.urls) {
+      if(static_cast<std::size_t>(seeded) >= m_max_sitemap_pages) {
+        break;
+      }
+      std::string url = normalize_url(loc);
+      if(m_graph.find(url) || !m_scope.allows(url, 1)) {
+        continue;
+      }
+      Index page = add_page(url, depth - 1);
+      if(root) {
+        add_link(*root, page);
+      }
+      enqueue(page, depth - 1);
+      ++seeded;
+    }
+  }
+
+  if(seeded > 0) {
+    report(fg(fmt::color::blue), "🗺️  Seeded {} pages from {} sitemaps\n", seeded, fetched);
+  }
+  return seeded;
+}
+
+template<typename Fetcher, typename LinkExtractor, typename Canonicalizer, typename GraphStore>
+auto Crawler<Fetcher, LinkExtractor, Canonicalizer, GraphStore>::rebuild(ArchiveReader const& archive, int threads) -> int
+{
+  // parsing is independent per page, so a window of records is spread over
+  // the cores. the pages are then added in archive order, so a page gets
+  // the same id however the threads ran
+  constexpr std::size_t window = 1024;
+
+  struct Parsed
+  {
+    bool ok = false;
+    std::string url;
+    LinkBuffer links;
+  };
+
+  std::vector<Parsed> parsed(std::min(window, archive.size()));
+  std::unordered_set<std::string> expanded; // pages archived more than once are expanded once, the first time
+  typename GraphStore::Edges edges;
+  int pages = 0;
+
+  for(std::size_t begin = 0; begin < archive.size(); begin += window) {
+    std::size_t end = std::min(begin + window, archive.size());
+    std::atomic<std::size_t> next{begin};
+    auto worker = [&]() {
+      LinkExtractor parser = make_extractor(m_canonicalizer);
+      for(std::size_t i = next++; i < end; i = next++) {
+        Parsed& page = parsed[i - begin];
+        page.ok = false;
+        try {
+          ArchiveRecord record = archive.record(i);
+          if(record.kind != RecordKind::page || record.status >= 400 || record.body.empty()) {
+            continue;
+          }
+          page.url = m_canonicalizer.canonicalize(record.url);
+          parser.parse(m_canonicalizer.canonicalize(record.final_url), record.body, page.links);
+          page.ok = true;
+        }
+        catch(const std::exception& e) {
+          report_error("❌ Error parsing archived page: {}\n", e.what());
+        }
+      }
+    };
+
+    std::vector<std::thread> pool;
+    for(int i = 0; i < std::max(1, threads); ++i) {
+      pool.emplace_back(worker);
+    }
+    for(std::thread& thread : pool) {
+      thread.join();
+    }
+
+    for(std::size_t i = begin; i < end; ++i) {
+      Parsed const& page = parsed[i - begin];
+      if(!page.ok || !expanded.insert(page.url).second) {
+        continue;
+      }
+      Index index = m_graph.intern(page.url, 0, edges);
+      for(std::string const& child_url : page.links) {
+        edges.link(index, m_graph.intern(child_url, 0, edges));
+      }
+      ++pages;
+    }
+    m_graph.commit(edges);
+  }
+
+  return pages;
+}
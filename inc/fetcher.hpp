@@ -0,0 +1,80 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+//
+#include <curl/curl.h>
+//
+#include <archive.hpp>
+#include <latency.hpp>
+#include <page_cache.hpp>
+#include <resolver.hpp>
+#include <retry.hpp>
+
+// Fetches pages over http with one recycled curl handle, the default
+// Fetcher of Crawler. Timeouts follow each host's latency, slow requests
+// can be hedged, addresses come from the DNS prefetcher, and pages can be
+// archived or replayed from an archive instead of the network.
+//
+// Failures throw: FetchError for http and transfer errors, telling
+// whether a retry could help, std::runtime_error for anything else.
+class CurlFetcher
+{
+public:
+  using Response = std::pair<std::string, std::string>; // final url, content
+
+  CurlFetcher();
+  ~CurlFetcher();
+  CurlFetcher(CurlFetcher const&) = delete;
+  CurlFetcher& operator=(CurlFetcher const&) = delete;
+
+  auto fetch(std::string const& url) -> Response;
+  void fetch(std::string const& url, Response& out); // reuses the buffers of {out}
+  void fetch(std::string const& url, Response& out, RecordKind kind); // archived as {kind}, not as a page
+  // conditional GET, false when the page has not changed since {known},
+  // {out} then only holds the final url
+  auto fetch(std::string const& url, Response& out, Validators const& known) -> bool;
+  auto validators() const -> Validators { return parse_validators(m_headers); } // of the last response
+  auto effective_url(std::string const& url) -> std::optional<std::string>; // follows redirects, no body
+  void prefetch(std::string_view host);                                      // dns, ahead of the first request
+  auto live() const -> bool { return !m_replay; }                            // false while replaying
+
+  auto latency() -> LatencyTracker& { return m_latency; } // per host timeouts
+  void set_hedging(bool enabled) { m_hedging = enabled; } // duplicate requests that run long
+  auto hedging() const -> bool { return m_hedging; }
+  auto hedged() const -> std::size_t { return m_hedged; }
+  auto resolver() -> DnsResolver* { return m_resolver.get(); } // null without a usable nameserver
+
+  // archive
+  void record_to(std::filesystem::path const&);   // archive every fetched page
+  void replay_from(std::filesystem::path const&); // fetch pages from an archive instead of the network
+  auto replaying() -> ArchiveReader* { return m_replay.get(); }
+
+  auto static write_callback(char* ptr, size_t size, size_t nmemb, void* userdata) -> size_t;
+  auto static header_callback(char* ptr, size_t size, size_t nitems, void* userdata) -> size_t;
+  auto static is_retryable(long status, CURLcode) -> bool;
+
+private:
+  auto transfer(std::string const& url, Response& out, Validators const* known, RecordKind kind) -> long; // the status
+  void replay(std::string const& url, Response& out);
+
+  CURLM* m_multi_handle = nullptr;
+  CURL* m_easy = nullptr;
+  std::unique_ptr<ArchiveWriter> m_archive;
+  std::unique_ptr<ArchiveReader> m_replay;
+  LatencyTracker m_latency;
+  bool m_hedging{};
+  std::size_t m_hedged{}; // duplicate requests sent
+  std::unique_ptr<DnsResolver> m_resolver; // resolves hosts as they are queued
+  std::unordered_set<std::string> m_resolve_entries; // "host:port" handed to curl, until removed
+
+  // recycled between requests
+  std::string m_headers;
+  std::string m_hedge_response;
+  std::string m_hedge_headers;
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// A page waiting to be fetched
+struct FrontierEntry
+{
+  int index{};             // node index in the graph
+  int depth{};             // remaining crawl depth
+  int in_links{};          // links to it discovered so far
+  std::uint64_t host{};    // host hash, for diversity
+  double score{};
+};
+
+// Hard limits on a crawl, whichever is reached first stops it
+struct CrawlBudget
+{
+  using Clock = std::chrono::steady_clock;
+
+  std::size_t max_pages = std::numeric_limits<std::size_t>::max();
+  std::size_t max_bytes = std::numeric_limits<std::size_t>::max();
+  Clock::duration max_time = Clock::duration::max();
+
+  auto exhausted(std::size_t pages, std::size_t bytes, Clock::duration elapsed) const -> bool
+  {
+    return pages >= max_pages || bytes >= max_bytes || elapsed >= max_time;
+  }
+};
+
+// Best-first crawl frontier: an indexed max-heap over node indices, so a
+// queued page can be rescored in O(log n) when another link to it shows up.
+class Frontier
+{
+public:
+  // higher scores are fetched first. a scorer may read the frontier, e.g.
+  // host_fetched(), and is evaluated again when the entry reaches the top.
+  using Scorer = std::function<double(FrontierEntry const&, Frontier const&)>;
+
+  Frontier();
+  explicit Frontier(Scorer scorer);
+
+  // favours pages many others link to, then shallow ones, and spreads
+  // fetches across hosts
+  auto static default_scorer(FrontierEntry const& entry, Frontier const& frontier) -> double;
+
+  void set_scorer(Scorer scorer) { m_scorer = std::move(scorer); }
+
+  // a page already queued gets another in link, and keeps the larger depth
+  void push(int index, int depth, std::string_view host);
+  // no-op unless {index} is queued. a link from a shallower page raises the
+  // depth left to crawl below it, so the subtree does not depend on which
+  // path was seen first
+  void add_in_link(int index, int depth = 0);
+  auto pop() -> std::optional<FrontierEntry>;
+  // puts back an entry popped too early, keeping its in links. it still
+  // counts as fetched from its host, which was asked something
+  void defer(FrontierEntry entry);
+  // the best entry {ready} accepts among the best {lookahead}, or nothing.
+  // the ones passed over stay queued as they were.
+  auto pop_ready(std::function<bool(FrontierEntry const&)> const& ready, std::size_t lookahead) -> std::optional<FrontierEntry>;
+
+  auto contains(int index) const -> bool;
+  auto empty() const -> bool { return m_heap.empty(); }
+  auto size() const -> std::size_t { return m_heap.size(); }
+  void clear();
+
+  // pages popped per host so far
+  auto host_fetched(std::uint64_t host) const -> int;
+
+private:
+  auto less(std::size_t a, std::size_t b) const -> bool { return m_heap[a].score < m_heap[b].score; }
+  void swap(std::size_t a, std::size_t b);
+  void sift_up(std::size_t pos);
+  void sift_down(std::size_t pos);
+  void insert(FrontierEntry const& entry); // keeps its score
+  auto take_top() -> FrontierEntry;        // rescored first if it went stale
+
+  Scorer m_scorer;
+  std::vector<FrontierEntry> m_heap;
+  std::vector<int> m_position; // node index -> heap position, -1 when not queued
+  std::unordered_map<std::uint64_t, int> m_host_fetched;
+  std::vector<FrontierEntry> m_passed; // recycled by pop_ready
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+
+// Per host response time tracking, the way TCP estimates its
+// retransmission timeout: a smoothed mean and mean deviation, updated
+// with every completed request. Hosts never seen use the defaults.
+class LatencyTracker
+{
+public:
+  using Duration = std::chrono::milliseconds;
+
+  struct Limits
+  {
+    Duration default_timeout{10000};
+    Duration min_timeout{2000};
+    Duration max_timeout{10000}; // never past the fixed timeout this replaced
+    Duration default_connect{5000};
+    Duration min_connect{1000};
+    double alpha = 0.125;    // weight of a new sample in the mean
+    double beta = 0.25;      // weight of a new sample in the deviation
+    double k = 4.0;          // timeout = mean + k * deviation
+    double hedge_k = 2.0;    // hedge after mean + hedge_k * deviation
+    int hedge_min_samples = 3;
+  };
+
+  struct Stats
+  {
+    double mean_ms{};
+    double deviation_ms{};
+    int samples{};
+  };
+
+  LatencyTracker() = default;
+  explicit LatencyTracker(Limits limits) :
+    m_limits{limits}
+  {
+  }
+
+  void record(std::string_view host, Duration elapsed);
+  // a sample at the timeout that was hit, with the timeout kept at most there
+  void record_timeout(std::string_view host);
+
+  auto timeout(std::string_view host) const -> Duration;
+  auto connect_timeout(std::string_view host) const -> Duration;
+  // when to send a duplicate request, once the host has enough history
+  auto hedge_delay(std::string_view host) const -> std::optional<Duration>;
+  auto stats(std::string_view host) const -> std::optional<Stats>;
+
+private:
+  auto find(std::string_view host) const -> Stats const*;
+
+  Limits m_limits;
+  std::unordered_map<std::uint64_t, Stats> m_hosts; // keyed by host hash
+};
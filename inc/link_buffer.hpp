@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Deduplicated list of urls, in insertion order. Clearing keeps the
+// vector, the strings and the hash table allocated, so refilling it with
+// a similar page does not touch the heap.
+class LinkBuffer
+{
+public:
+  using const_iterator = std::vector<std::string>::const_iterator;
+
+  auto begin() const -> const_iterator { return m_links.begin(); }
+  auto end() const -> const_iterator { return m_links.begin() + m_size; }
+  auto size() const -> std::size_t { return m_size; }
+  auto empty() const -> bool { return m_size == 0; }
+  auto operator[](std::size_t i) const -> std::string const& { return m_links[i]; }
+
+  void clear();
+
+  // recycled string to write the next link into
+  auto next() -> std::string&;
+  // keeps the link written into next() unless it is already in the buffer
+  auto commit() -> bool;
+  auto commit(std::uint64_t fingerprint) -> bool; // fnv1a64 of the link, when already known
+
+private:
+  void rehash(std::size_t buckets);
+
+  std::vector<std::string> m_links;
+  std::vector<std::uint64_t> m_hashes;
+  std::vector<std::uint32_t> m_table; // open addressing, slot + 1, 0 is empty
+  std::size_t m_size{};
+};
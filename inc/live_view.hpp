@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+//
+#include <crawler.hpp>
+
+// Changes to the page graph, coalesced: a page's status only keeps its
+// latest value, a page added in the same batch carries it directly, and a
+// link is only held once.
+class GraphDeltas
+{
+public:
+  void page(int index, std::string_view url, int depth); // ignored if the page is already held
+  void status(int index, PageStatus);
+  void link(int from, int to);
+  void append(GraphDeltas const& later); // as if {later}'s updates were made here
+
+  auto pages() const -> std::size_t { return m_pages.size(); }
+  auto statuses() const -> std::size_t { return m_statuses.size(); }
+  auto links() const -> std::size_t { return m_links.size(); }
+  auto empty() const -> bool { return m_pages.empty() && m_statuses.empty() && m_links.empty(); }
+  void clear(); // keeps the capacity
+
+  // {"pages":[[index,url,depth,status],..],"status":[[index,status],..],"links":[[from,to],..]}
+  // with statuses as the numbers of PageStatus
+  auto to_json() const -> std::string;
+
+private:
+  struct Page
+  {
+    int index{};
+    std::string url;
+    int depth{};
+    PageStatus status = PageStatus::found;
+  };
+
+  std::vector<Page> m_pages;
+  std::unordered_map<int, std::size_t> m_page_at; // index -> position in m_pages
+  std::vector<std::pair<int, PageStatus>> m_statuses;
+  std::unordered_map<int, std::size_t> m_status_at; // index -> position in m_statuses
+  std::vector<std::pair<int, int>> m_links;
+  std::unordered_set<std::uint64_t> m_link_set; // from << 32 | to, of m_links
+};
+
+// A local web page that draws the graph while it is being crawled.
+//
+// The crawl only appends to a pending GraphDeltas under a mutex. A server
+// thread takes the whole batch every {interval}, adds it to the graph seen
+// so far and sends it as one Server-Sent Event to every open viewer. A new
+// viewer first gets everything seen so far. Sockets never block, and a
+// viewer that falls too far behind is dropped, so the crawl never waits.
+//
+//   GET /        the viewer
+//   GET /events  text/event-stream: a "snapshot" event, then one per batch
+class LiveView : public CrawlListener
+{
+public:
+  struct Options
+  {
+    std::string address = "127.0.0.1";
+    std::uint16_t port = 8080; // 0 picks a free one
+    std::chrono::milliseconds interval{100};
+    std::size_t max_backlog = 64 << 20; // unsent bytes before a viewer is dropped
+  };
+
+  explicit LiveView(Options options); // listens right away, throws if it cannot
+  ~LiveView() override;               // sends what is pending, then closes
+  LiveView(LiveView const&) = delete;
+  LiveView& operator=(LiveView const&) = delete;
+
+  void page_added(int index, std::string_view url, int depth) override;
+  void page_status(int index, PageStatus) override;
+  void link_added(int from, int to) override;
+
+  auto port() const -> std::uint16_t { return m_port; }
+  auto url() const -> std::string;
+  auto viewers() const -> std::size_t { return m_viewers.load(); }
+  auto batches() const -> std::size_t { return m_batches.load(); } // sent so far
+
+private:
+  struct Client
+  {
+    int fd = -1;
+    std::string request;
+    std::string out;
+    std::size_t sent{};
+    bool streaming = false; // subscribed to /events
+    bool closing = false;   // closed once {out} is sent
+  };
+
+  void serve();
+  void accept_clients();
+  void read_request(Client&);
+  void respond(Client&);
+  void write_out(Client&);
+  void static drop(Client&); // closed without sending the rest
+  void flush(); // sends the pending batch to every viewer
+
+  Options m_options;
+  int m_listen_fd = -1;
+  std::uint16_t m_port{};
+  std::thread m_thread;
+  std::atomic<bool> m_stopping{false};
+  std::atomic<std::size_t> m_viewers{0};
+  std::atomic<std::size_t> m_batches{0};
+
+  std::mutex m_mutex;
+  GraphDeltas m_pending; // guarded by m_mutex
+
+  // server thread only
+  GraphDeltas m_batch;
+  GraphDeltas m_seen;
+  std::vector<Client> m_clients;
+};
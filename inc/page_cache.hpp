@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+//
+#include <simhash.hpp>
+
+// What a server said identifies a version of a page, sent back on the next
+// crawl as If-None-Match / If-Modified-Since
+struct Validators
+{
+  std::string etag;
+  std::string last_modified;
+
+  auto empty() const -> bool { return etag.empty() && last_modified.empty(); }
+};
+
+// ETag and Last-Modified out of raw response headers
+auto parse_validators(std::string_view headers) -> Validators;
+
+// A page as the last crawl left it
+struct CachedPage
+{
+  std::string final_url;
+  Validators validators;
+  std::uint64_t content_hash{}; // fnv1a64 of the body
+  ContentFingerprint fingerprint;  // all zero if the extractor gave none
+  std::string duplicate_of;        // the page it was merged into, if it was
+  std::vector<std::string> links;
+};
+
+// Per url metadata kept between crawls, so a re-crawl only downloads and
+// parses the pages that changed. Saved as text:
+//
+//   <pages>
+//   <url> \t <final url> \t <etag> \t <last modified> \t <hash>
+//         \t <exact> \t <simhash> \t <words> \t <duplicate of> \t <links>
+//   <link>
+//   ...
+class PageCache
+{
+public:
+  explicit PageCache(std::filesystem::path path); // loads {path} if it exists
+
+  auto find(std::string const& url) const -> CachedPage const*;
+  void store(std::string const& url, CachedPage page);
+  // through a temporary file, so an interrupted save keeps the old cache
+  void save() const;
+
+  auto size() const -> std::size_t { return m_pages.size(); }
+  auto path() const -> std::filesystem::path const& { return m_path; }
+
+private:
+  void load();
+
+  std::filesystem::path m_path;
+  std::unordered_map<std::string, CachedPage> m_pages;
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+//
+#include <shard.hpp>
+#include <url_table.hpp>
+
+class PageNode
+{
+public:
+  using Index = int;
+
+  PageNode(int index, int depth) :
+    m_links{}, m_index{index}, m_depth{depth}
+  {
+  }
+
+  ~PageNode()
+  {
+  }
+
+  void add_link(int link) { m_links.push_back(link); }
+  void reserve(std::size_t size) { m_links.reserve(size); };
+  auto children() const -> std::vector<int> const& { return m_links; }
+  auto index() const -> int const { return m_index; }
+  auto depth() const -> int const { return m_depth; }
+  void set_depth(int depth) { m_depth = depth; }
+  void merge_into(int original) { m_duplicate_of = original; }
+  auto duplicate_of() const -> int { return m_duplicate_of; } // -1 unless the page mirrors another
+
+private:
+  int m_index{};
+  int m_depth{};
+  int m_duplicate_of = -1;
+  std::vector<int> m_links;
+};
+
+// Links and new pages found by one thread, waiting to join the graph
+class EdgeBuffer
+{
+public:
+  void link(int from, int to) { m_edges.emplace_back(from, to); }
+  void node(int index, int depth) { m_nodes.emplace_back(index, depth); }
+  auto size() const -> std::size_t { return m_edges.size(); }
+  auto empty() const -> bool { return m_edges.empty() && m_nodes.empty(); }
+  void clear()
+  {
+    m_edges.clear();
+    m_nodes.clear();
+  }
+
+private:
+  friend class PageGraph;
+
+  std::vector<std::pair<int, int>> m_edges; // from, to
+  std::vector<std::pair<int, int>> m_nodes; // index, depth
+};
+
+// The crawled pages and their links, the default GraphStore of Crawler.
+//
+// Urls live in a UrlTable, so parser threads can intern the links they
+// find with intern(), each into its own EdgeBuffer, and commit() the
+// buffer in bulk. Everything else is for one thread at a time, and node
+// reads must not overlap a commit.
+class PageGraph
+{
+public:
+  using Index = PageNode::Index;
+  using Edges = EdgeBuffer;
+
+  auto add_node(std::string const& url, int depth) -> Index; // the existing index if {url} is known
+  auto find(std::string const& url) const -> std::optional<Index> { return m_urls.find(url); }
+  auto exists(std::string const& url) const -> bool { return m_urls.find(url).has_value(); }
+  auto get_index(std::string const& url) const -> Index;
+  auto get_url(Index index) const -> std::string const& { return m_urls.url(index); }
+  auto get_node(Index index) -> PageNode& { return m_nodes.at(index); }
+  auto get_node(Index index) const -> PageNode const& { return m_nodes.at(index); }
+  auto nodes() const -> std::deque<PageNode> const& { return m_nodes; }
+  auto node_count() const -> int { return static_cast<int>(m_nodes.size()); }
+
+  void add_link(Index from, Index to) { m_nodes[from].add_link(to); }
+  void reserve_links(Index index, std::size_t size) { m_nodes[index].reserve(size); }
+  void raise_depth(Index index, int depth) { m_nodes[index].set_depth(std::max(m_nodes[index].depth(), depth)); }
+
+  // thread safe, new pages are only recorded in {buffer} until it is committed
+  auto intern(std::string_view url, int depth, EdgeBuffer& buffer) -> Index;
+  void commit(EdgeBuffer& buffer); // adds its pages and links, then clears it
+
+  // {duplicate} is drawn as {original} from now on, and its url leads there
+  void merge(Index duplicate, Index original);
+  auto resolve_node(Index) const -> Index; // follows merged duplicates
+
+  // sharding
+  auto export_graph() const -> ShardGraph;
+  void load_graph(ShardGraph const&);
+  void clear();
+
+private:
+  void grow(std::size_t size); // nodes up to {size}, for ids handed out by intern()
+
+  UrlTable m_urls;
+  std::deque<PageNode> m_nodes;
+  std::mutex m_commit;
+};
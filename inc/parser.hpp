@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+//
+#include <lexbor/html/interface.h>
+#include <lexbor/html/parser.h>
+//
+#include <canonical.hpp>
+#include <link_buffer.hpp>
+#include <simhash.hpp>
+
+// Extracts the links of html pages, and fingerprints their text on the
+// same walk. Meant to be owned by one worker and reused for every page it
+// parses: the lexbor document (and its parser) is cleaned rather than
+// recreated, and links are resolved into a recycled string.
+class PageParser
+{
+public:
+  explicit PageParser(Canonicalizer const& canonicalizer = Canonicalizer::defaults());
+  ~PageParser();
+  PageParser(PageParser const&) = delete;
+  PageParser& operator=(PageParser const&) = delete;
+
+  // fills {out} with the canonical absolute links of {content}
+  void parse(std::string_view base_url, std::string_view content, LinkBuffer& out);
+  // of the last page parsed
+  auto fingerprint() const -> ContentFingerprint const& { return m_fingerprint; }
+
+private:
+  // {visible} is false under script, style, noscript and template, whose
+  // text stays out of the simhash. their links are still followed
+  void extract_links_rec(lxb_dom_node_t* node, LinkBuffer& out, bool visible = true);
+  auto resolve(const char* href, std::string& out) -> std::optional<std::uint64_t>;
+
+  Canonicalizer const* m_canonicalizer;
+  lxb_html_document_t* m_doc = nullptr;
+  std::string m_base_url;
+  std::string m_resolved; // a link made absolute, before canonicalization
+  SimHasher m_simhash;
+  ContentFingerprint m_fingerprint;
+};
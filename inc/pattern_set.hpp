@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A set of regular expressions compiled into one DFA.
+//
+// search() walks the text once, one table lookup per byte, and stops at
+// the first match of any pattern, so its cost never depends on the
+// patterns themselves. The syntax is the subset of ECMAScript that has a
+// DFA: literals and escapes, '.', [classes] with ranges and negation,
+// \d \w \s and their negations, groups, '|', * + ? and {m,n} (lazy forms
+// match the same), and ^ $ anchors. Anything else, backreferences and
+// lookarounds included, is rejected by add().
+class PatternSet
+{
+public:
+  static constexpr std::size_t max_states = 4096;
+  static constexpr int max_repeat = 100; // upper bound of {m,n}
+
+  // throws std::runtime_error on a pattern it cannot compile, and then
+  // leaves the set as it was
+  void add(std::string_view pattern);
+  // whether any pattern matches somewhere in {text}
+  auto search(std::string_view text) const -> bool;
+  auto empty() const -> bool { return m_patterns.empty(); }
+  auto states() const -> std::size_t { return m_accepts.size(); }
+
+private:
+  std::vector<std::string> m_patterns;
+  std::vector<std::uint32_t> m_next; // 256 per state
+  std::vector<std::uint8_t> m_accepts; // matched already
+  std::vector<std::uint8_t> m_accepts_at_end; // matched if the text ends here
+};
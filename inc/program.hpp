@@ -7,6 +7,7 @@
 #include <memory>
 #include <deque>
 #include <optional>
+#include <filesystem>
 //
 #include <curl/curl.h>
 #include <lexbor/dom/interfaces/element.h>
@@ -15,74 +16,61 @@
 #include <lexbor/html/parser.h>
 //
 #include <pybind11/embed.h>
+//
+#include <archive.hpp>
+#include <canonical.hpp>
+#include <crawler.hpp>
+#include <fetcher.hpp>
+#include <live_view.hpp>
+#include <page_graph.hpp>
+#include <parser.hpp>
+#include <shard.hpp>
 
-
-class PageNode
-{
-public:
-  using Index = int;
-
-  PageNode(int index, int depth) :
-    m_links{}, m_index{index}, m_depth{depth}
-  {
-  }
-
-  ~PageNode()
-  {
-  }
-
-  void add_link(int link) { m_links.push_back(link); }
-  void reserve(std::size_t size) { m_links.reserve(size); };
-  auto children() const -> std::vector<int> const& { return m_links; }
-  auto index() const -> int const { return m_index; }
-  auto depth() const -> int const { return m_depth; }
-
-private:
-  int m_index{};
-  int m_depth{};
-  std::vector<int> m_links;
-};
+// the crawler the program runs, over the network
+using WebCrawler = Crawler<CurlFetcher, PageParser, Canonicalizer, PageGraph>;
 
 class Program
 {
-  using FinalURL = std::string;
 public:
   using PageContent = std::string;
   using URL = std::string;
-  using Response = std::pair<FinalURL, PageContent>;
+  using Response = CurlFetcher::Response;
 
   Program();
   ~Program();
   void run();
+  void run(std::string const& root_url, int depth);
+  void run_shard(ShardConfig const&, std::string const& root_url, int depth);
+  void run_merge(ShardConfig const&);
+  void run_rebuild(std::filesystem::path const& archive, int threads);
 
   // flow
   void static print_header();
   auto static request_input() -> std::string;
   auto static request_depth() -> int;
-  auto request_html(std::string const& url) -> Response;
-  auto static parse_url(std::string url, std::string const& content) -> std::unordered_set<FinalURL>;
-  void crawl_page(std::string const& url, int depth);
+  void request_scope(std::string const& root_url);
+  void request_budget();
+  auto static parse_url(std::string url, std::string const& content) -> std::unordered_set<URL>;
 
   // helpers
-  auto static write_callback(char* ptr, size_t size, size_t nmemb, void* userdata) -> size_t; // used by request_html
-  void static extract_links_rec(lxb_dom_node_t* node, std::unordered_set<FinalURL>& out, std::string const&);
-  auto crawl_page_rec(PageNode&, int depth)-> std::optional<PageNode::Index>;
   bool static is_valid_url(std::string url);
   auto static resolve_url(const std::string& base_url, const std::string& href) -> std::optional<std::string>;
   auto graph() -> int;
+  auto graph_clusters() -> int; // an overview of clusters plus a view per cluster, for big graphs
+  void set_cluster_threshold(std::size_t nodes) { m_cluster_threshold = nodes; } // above it graph() clusters
+  auto crawler() -> WebCrawler& { return m_crawler; } // fetching, scope, budget and the page graph
+
+  // archive
+  void record_to(std::filesystem::path const&);   // archive every fetched page
+  void replay_from(std::filesystem::path const&); // fetch pages from an archive instead of the network
+  auto rebuild_from_archive(int threads) -> int; // pages get their ids in archive order
+  void use_cache(std::filesystem::path const&); // re-crawl incrementally, saved after each crawl
 
-  auto get_node(PageNode::Index) -> PageNode&;
-  auto add_node(std::string const&, int depth) -> PageNode::Index;
-  auto node_count() -> int { return m_nodes.size(); };
-  auto exists(std::string const& url) -> bool;
-  auto get_url(PageNode::Index index) -> URL { return m_index_to_url.at(index); }
-  auto get_index(std::string const& url) -> PageNode::Index { return m_url_to_index.at(url); }
-  auto get_effective_url(std::string const&) -> std::optional<std::string>;
-  auto static normalize_url(std::string_view url) -> std::string;
+  // live view
+  void serve_live(std::uint16_t port); // streams the graph to a browser while crawling
 
 private:
-  CURLM* m_multi_handle = nullptr;
-  std::unordered_map<std::string, int> m_url_to_index;
-  std::unordered_map<int, std::string> m_index_to_url;
-  std::deque<PageNode> m_nodes;
+  WebCrawler m_crawler;
+  std::size_t m_cluster_threshold = 2000;
+  std::unique_ptr<LiveView> m_live;
 };
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Resolves hosts ahead of their first request, so transfers find the
+// address ready instead of blocking on DNS.
+//
+// A few worker threads ask one nameserver for the A and AAAA records of
+// a host over UDP, falling back to TCP for truncated answers, and keep
+// the addresses for their TTL. Names are tried with the search domains
+// of resolv.conf the way the system resolver does, by ndots. Answers
+// must echo the question that was asked. Hosts that do not exist are
+// remembered for a while too. Anything the resolver cannot answer is
+// left to curl's own resolver, and so are the names in the hosts file,
+// which the nameserver knows nothing about.
+class DnsResolver
+{
+public:
+  using Clock = std::chrono::steady_clock;
+  using Addresses = std::vector<std::string>; // empty: the host does not exist
+
+  struct Options
+  {
+    std::string server;   // ipv4 address of the nameserver
+    std::uint16_t port = 53;
+    std::chrono::milliseconds timeout{1000}; // per attempt
+    int attempts = 2;
+    int workers = 4;
+    std::chrono::seconds min_ttl{30};
+    std::chrono::seconds max_ttl{3600};
+    std::chrono::seconds negative_ttl{300};
+    std::string hosts_file = "/etc/hosts"; // names left to curl, empty for none
+    std::vector<std::string> search; // domains tried after short names
+    int ndots = 1; // names with fewer dots try the search domains first
+  };
+
+  explicit DnsResolver(Options options);
+  ~DnsResolver();
+  DnsResolver(DnsResolver const&) = delete;
+  DnsResolver& operator=(DnsResolver const&) = delete;
+
+  // the first ipv4 nameserver of {path}, with its search domains and
+  // ndots, if it has such a nameserver
+  auto static system_options(std::string const& path = "/etc/resolv.conf") -> std::optional<Options>;
+
+  // queues {host} unless it is cached, queued or an ip literal. never blocks.
+  void prefetch(std::string_view host);
+  // a cached, unexpired answer
+  auto lookup(std::string_view host) const -> std::optional<Addresses>;
+  // the cached answer, or queries right away
+  auto resolve(std::string_view host) -> std::optional<Addresses>;
+  // "+host:port:addr,[addr6]" for CURLOPT_RESOLVE, if an address is
+  // cached. the + lets curl expire it like any other address it resolved
+  auto curl_resolve_entry(std::string_view host, int port) const -> std::optional<std::string>;
+
+  auto queries() const -> std::size_t { return m_queries.load(); } // sent to the nameserver so far
+
+private:
+  struct Entry
+  {
+    Addresses addresses;
+    Clock::time_point expires;
+  };
+
+  struct HostHash
+  {
+    using is_transparent = void;
+    auto operator()(std::string_view host) const -> std::size_t { return std::hash<std::string_view>{}(host); }
+  };
+
+  void work();
+  auto query(std::string const& host) -> std::optional<Entry>;
+  auto ask(std::string const& name) -> std::optional<Entry>; // one name, no search domains
+  void store(std::string const& host, Entry entry);
+  auto local(std::string_view host) const -> bool { return m_local.contains(host); }
+
+  Options m_options;
+  mutable std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::unordered_map<std::string, Entry, HostHash, std::equal_to<>> m_cache;
+  std::unordered_set<std::string, HostHash, std::equal_to<>> m_pending;
+  std::unordered_set<std::string, HostHash, std::equal_to<>> m_local; // from the hosts file, read once
+  std::deque<std::string> m_queue;
+  std::vector<std::thread> m_workers;
+  std::atomic<std::size_t> m_queries{};
+  bool m_stop{};
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// A failed fetch, telling whether trying again later could help
+class FetchError : public std::runtime_error
+{
+public:
+  FetchError(std::string const& what, long status, bool retryable) :
+    std::runtime_error(what), m_status{status}, m_retryable{retryable}
+  {
+  }
+
+  auto status() const -> long { return m_status; }
+  auto retryable() const -> bool { return m_retryable; }
+
+private:
+  long m_status{};
+  bool m_retryable{};
+};
+
+struct RetryPolicy
+{
+  int max_attempts = 4; // including the first one
+  std::chrono::milliseconds base_delay{1000};
+  std::chrono::milliseconds max_delay{60000};
+  double jitter = 0.2; // +-20%, so retries of one host do not line up
+};
+
+struct RetryEntry
+{
+  using Clock = std::chrono::steady_clock;
+
+  int index{};
+  int depth{};
+  int attempt{}; // attempts already made
+  Clock::time_point ready;
+};
+
+// Pages waiting to be fetched again, with exponential backoff
+class RetryQueue
+{
+public:
+  using Clock = RetryEntry::Clock;
+
+  RetryQueue() = default;
+  explicit RetryQueue(RetryPolicy policy, unsigned seed = std::random_device{}()) :
+    m_policy{policy}, m_rng{seed}
+  {
+  }
+
+  // queues another attempt, or returns false once attempts are used up
+  auto schedule(int index, int depth, int attempt, Clock::time_point now) -> bool;
+  auto pop_ready(Clock::time_point now) -> std::optional<RetryEntry>;
+  void defer(RetryEntry entry, Clock::time_point until); // back in the queue, same attempt
+  auto next_ready() const -> std::optional<Clock::time_point>;
+
+  auto delay(int attempt) -> Clock::duration;
+  auto empty() const -> bool { return m_queue.empty(); }
+  auto size() const -> std::size_t { return m_queue.size(); }
+
+private:
+  struct Later
+  {
+    auto operator()(RetryEntry const& a, RetryEntry const& b) const -> bool { return a.ready > b.ready; }
+  };
+
+  RetryPolicy m_policy;
+  std::mt19937 m_rng{std::random_device{}()};
+  std::priority_queue<RetryEntry, std::vector<RetryEntry>, Later> m_queue;
+};
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// The rules of one robots.txt that apply to us, compiled for matching.
+//
+// Plain path prefixes go into a trie that is walked once per url; the few
+// patterns using '*' or '$' are matched one by one. As in RFC 9309 the
+// longest matching rule wins and allow wins ties.
+class RobotsRules
+{
+public:
+  // picks the group naming {agent}, or the '*' group when there is none
+  auto static parse(std::string_view text, std::string_view agent) -> RobotsRules;
+  auto static disallow_all() -> RobotsRules;
+
+  // {target} is the path and query of a url, see url_target()
+  auto allowed(std::string_view target) const -> bool;
+  auto crawl_delay() const -> std::optional<std::chrono::milliseconds> { return m_crawl_delay; }
+  auto sitemaps() const -> std::vector<std::string> const& { return m_sitemaps; }
+  auto rule_count() const -> int { return m_rule_count; }
+
+  void allow(std::string_view pattern) { add(pattern, true); }
+  void disallow(std::string_view pattern) { add(pattern, false); }
+
+private:
+  enum class Verdict : std::uint8_t
+  {
+    None,
+    Allow,
+    Disallow
+  };
+
+  struct Node
+  {
+    std::vector<std::pair<char, std::uint32_t>> edges;
+    Verdict verdict = Verdict::None;
+  };
+
+  struct Pattern
+  {
+    std::string pattern; // without a trailing '$'
+    bool anchored{};     // ended with '$'
+    bool allow{};
+  };
+
+  void add(std::string_view pattern, bool allow);
+  auto child(std::uint32_t node, char c) const -> std::optional<std::uint32_t>;
+
+  std::vector<Node> m_nodes{Node{}}; // prefix trie, the root is node 0
+  std::vector<Pattern> m_patterns;
+  int m_rule_count{};
+  std::optional<std::chrono::milliseconds> m_crawl_delay;
+  std::vector<std::string> m_sitemaps;
+};
+
+// Compiled robots.txt rules per origin ("https://example.com"),
+// fetched once and kept for the whole crawl
+class RobotsCache
+{
+public:
+  auto find(std::string_view origin) const -> RobotsRules const*;
+  auto insert(std::string_view origin, RobotsRules rules) -> RobotsRules const&;
+  auto size() const -> std::size_t { return m_rules.size(); }
+
+private:
+  std::unordered_map<std::uint64_t, RobotsRules> m_rules; // keyed by origin hash
+};
+
+// Spaces requests to the same host, so a crawl only waits on the host it
+// is about to hit and never on the others
+class HostScheduler
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit HostScheduler(Clock::duration default_delay = std::chrono::milliseconds(300),
+    Clock::duration max_delay = std::chrono::seconds(30)) :
+    m_default_delay{default_delay}, m_max_delay{max_delay}
+  {
+  }
+
+  void set_delay(std::string_view host, Clock::duration delay); // capped at the max delay
+  auto delay(std::string_view host) const -> Clock::duration;
+  auto ready_at(std::string_view host) const -> Clock::time_point; // when the next request may go
+  auto ready_at(std::uint64_t host_hash) const -> Clock::time_point; // by fnv1a64 of the host
+  void visited(std::string_view host, Clock::time_point when);
+
+private:
+  struct Host
+  {
+    std::optional<Clock::duration> delay;
+    std::optional<Clock::time_point> last;
+  };
+
+  Clock::duration m_default_delay;
+  Clock::duration m_max_delay;
+  std::unordered_map<std::uint64_t, Host> m_hosts; // keyed by host hash
+};
+
+// the <loc> entries of a sitemap, or of a sitemap index
+struct Sitemap
+{
+  std::vector<std::string> urls;
+  std::vector<std::string> sitemaps;
+};
+
+auto parse_sitemap(std::string_view xml) -> Sitemap;
+
+// sitemaps are often served as .xml.gz, returns {data} inflated if it is gzip
+auto gunzip(std::string_view data) -> std::string;
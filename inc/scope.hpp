@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+//
+#include <pattern_set.hpp>
+
+// Decides which links are worth queueing, before they ever reach the graph.
+//
+// Hosts and path prefixes live in tries, walked once per link without
+// allocating; hosts are matched label-wise from the right, so a rule for
+// "example.com" also covers "en.example.com" but not "badexample.com".
+// The longest matching rule wins and allow wins ties. Regex rules are
+// compiled into one DFA per verdict (see PatternSet), so checking a link
+// costs one table lookup per character however many rules there are.
+//
+// Urls are expected in canonical form (lowercase scheme and host).
+class CrawlScope
+{
+public:
+  static constexpr int unlimited = std::numeric_limits<int>::max();
+
+  void allow_host(std::string_view host, int max_level = unlimited);
+  void deny_host(std::string_view host);
+  void allow_path(std::string_view prefix);
+  void deny_path(std::string_view prefix);
+  void allow_pattern(std::string const& regex);
+  void deny_pattern(std::string const& regex);
+
+  // true when {url}, found {level} links away from the root, may be queued
+  auto allows(std::string_view url, int level) const -> bool;
+  auto empty() const -> bool { return m_host_rules == 0 && m_path_rules == 0 && m_allow_patterns.empty() && m_deny_patterns.empty(); }
+
+private:
+  enum class Verdict : std::uint8_t
+  {
+    None,
+    Allow,
+    Deny
+  };
+
+  struct Node
+  {
+    std::vector<std::pair<char, std::uint32_t>> edges;
+    Verdict verdict = Verdict::None;
+    int max_level = unlimited;
+  };
+
+  // a trie over characters, the root is node 0
+  struct Trie
+  {
+    std::vector<Node> nodes{Node{}};
+
+    auto child(std::uint32_t node, char c) const -> std::optional<std::uint32_t>;
+    auto insert_reversed(std::string_view key) -> Node&;
+    auto insert(std::string_view key) -> Node&;
+  };
+
+  void add_host(std::string_view host, Verdict verdict, int max_level);
+  void add_path(std::string_view prefix, Verdict verdict);
+  auto match_host(std::string_view host) const -> Node const*;
+  auto match_path(std::string_view path) const -> Verdict;
+
+  Trie m_hosts;
+  Trie m_paths;
+  int m_host_rules{};
+  int m_path_rules{};
+  bool m_has_host_allow{};
+  bool m_has_path_allow{};
+
+  PatternSet m_allow_patterns;
+  PatternSet m_deny_patterns;
+};
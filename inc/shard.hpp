@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Host-sharded crawling.
+//
+// Every crawler process owns the urls whose host hashes to its shard id.
+// Links to hosts owned by another shard are forwarded through spool files
+// in a shared directory:
+//
+//   spool-<to>-<from>.txt   forwarded links, one "<depth>\t<url>" per line
+//   status-<id>.txt         "<idle> <sent> <received>", used for termination
+//   shard-<id>.graph        the url table and adjacency of a finished shard
+//
+// merge_shards() combines the per-shard graphs into a single one.
+
+struct ShardConfig
+{
+  int id = 0;
+  int count = 1;
+  std::filesystem::path dir = "shards";
+};
+
+struct ShardLink
+{
+  std::string url;
+  int depth{};
+};
+
+// url table and edge list of a (partial) crawl graph
+struct ShardGraph
+{
+  std::vector<std::string> urls;
+  std::vector<int> depths;
+  std::vector<std::pair<int, int>> edges;
+  std::vector<std::pair<int, int>> merged; // duplicate, the page it copies
+};
+
+// shard owning {url}, hashed on the lowercase host
+auto shard_of(std::string_view url, int count) -> int;
+
+class ShardSpool
+{
+public:
+  explicit ShardSpool(ShardConfig const& config);
+
+  auto config() const -> ShardConfig const& { return m_config; }
+  auto owns(std::string_view url) const -> bool { return shard_of(url, m_config.count) == m_config.id; }
+
+  // appends {url} to the spool of the shard owning it
+  void forward(std::string const& url, int depth);
+  void flush();
+
+  // returns every complete line appended to our spools since the last call
+  auto receive() -> std::vector<ShardLink>;
+
+  // publishes this shard as idle and returns true once every shard is idle
+  // and all forwarded links were received, for two consecutive checks.
+  auto finished() -> bool;
+  void publish_status(bool idle);
+
+private:
+  auto spool_path(int to, int from) const -> std::filesystem::path;
+  auto status_path(int id) const -> std::filesystem::path;
+
+  ShardConfig m_config;
+  std::vector<std::ofstream> m_out;       // indexed by target shard
+  std::vector<std::streamoff> m_read_pos; // indexed by source shard
+  std::uint64_t m_sent{};
+  std::uint64_t m_received{};
+  std::pair<std::uint64_t, std::uint64_t> m_last_totals{~0ull, ~0ull};
+};
+
+void write_shard_graph(std::filesystem::path const& path, ShardGraph const& graph);
+auto read_shard_graph(std::filesystem::path const& path) -> ShardGraph;
+auto shard_graph_path(ShardConfig const& config, int id) -> std::filesystem::path;
+
+// combines shard-0 .. shard-{count-1} into one graph, deduplicating urls.
+auto merge_shards(std::filesystem::path const& dir, int count) -> ShardGraph;
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// What a page says, for spotting the same content under another url
+struct ContentFingerprint
+{
+  std::uint64_t exact{};   // hash of the whole body
+  std::uint64_t simhash{}; // of the text, close for near identical pages
+  std::size_t words{};
+};
+
+// number of differing bits
+auto hamming(std::uint64_t a, std::uint64_t b) -> int;
+
+// Charikar's SimHash over shingles of consecutive words. Text is fed in
+// pieces as the parser meets it; nothing is allocated along the way.
+class SimHasher
+{
+public:
+  static constexpr std::size_t shingle_size = 3;
+
+  void clear();
+  void add_text(std::string_view text); // a piece ends a word
+  auto value() const -> std::uint64_t;
+  auto words() const -> std::size_t { return m_words; }
+
+private:
+  void add_word(std::uint64_t hash);
+  void add_feature(std::uint64_t hash, std::array<std::int32_t, 64>& weights) const;
+
+  std::array<std::int32_t, 64> m_weights{};
+  std::array<std::uint64_t, shingle_size> m_window{}; // last words, as a ring
+  std::size_t m_words{};
+};
+
+// Finds pages seen before with the same body, or a simhash at most
+// {max_distance} bits away. The 64 bits are split into blocks, one table
+// per block: two hashes that close agree entirely on at least one block,
+// so only the entries sharing a block are compared.
+class SimHashIndex
+{
+public:
+  struct Match
+  {
+    int id{};
+    int distance{}; // 0 for an exact match
+  };
+
+  // pages under {min_words} words only match exactly, their simhash says too little
+  explicit SimHashIndex(int max_distance = 3, std::size_t min_words = 32);
+
+  void insert(ContentFingerprint const&, int id);
+  auto find(ContentFingerprint const&) const -> std::optional<Match>;
+  auto size() const -> std::size_t { return m_exact.size(); }
+
+private:
+  static constexpr int blocks = 4;
+
+  auto static block(std::uint64_t hash, int i) -> std::uint16_t { return static_cast<std::uint16_t>(hash >> (16 * i)); }
+
+  struct Entry
+  {
+    std::uint64_t simhash{};
+    int id{};
+  };
+
+  int m_max_distance{};
+  std::size_t m_min_words{};
+  std::unordered_map<std::uint64_t, int> m_exact;
+  std::vector<Entry> m_entries;
+  std::array<std::unordered_map<std::uint16_t, std::vector<std::uint32_t>>, blocks> m_tables; // block -> entries
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// FNV-1a 64 bit. Stable across processes and runs, unlike std::hash,
+// so it can be used to partition work between crawler instances.
+auto constexpr fnv1a64(std::string_view data, std::uint64_t hash = 14695981039346656037ull) -> std::uint64_t
+{
+  for(char c : data) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+// returns the host part of an absolute url, without userinfo and port.
+// returns an empty view if the url has no authority.
+auto url_host(std::string_view url) -> std::string_view;
+
+// scheme and authority, "https://example.com:8080" in
+// "https://example.com:8080/a?b". empty if the url has no authority.
+auto url_origin(std::string_view url) -> std::string_view;
+
+// path and query, what goes in the request line. "/" when the url has no path.
+auto url_target(std::string_view url) -> std::string_view;
+
+// the explicit port, else the default of the scheme. 0 when neither is known.
+auto url_port(std::string_view url) -> int;
+
+// resolves the link {href} against the absolute url {base} into {out}, as
+// RFC 3986 section 5.2 does, dot segments removed. {href} is trimmed of
+// surrounding whitespace, and tabs and newlines within it are dropped, as
+// browsers do. false if {base} has no scheme. never allocates once {out}
+// is large enough.
+auto resolve_reference(std::string_view base, std::string_view href, std::string& out) -> bool;
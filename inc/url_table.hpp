@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Url -> dense id map that many threads can insert into at once.
+//
+// Urls are spread over lock-striped shards by the high bits of their
+// fnv1a64 hash, each an open addressing table of {hash, key, id} slots,
+// so threads only contend when they hit the same shard. Ids come from one
+// atomic counter and stay dense. Every url is stored once, in segments of
+// doubling size that never move, so url(id) needs no lock.
+//
+// An id is safe to pass to url() once it was handed out by insert() or
+// find(), or by anything synchronised with the thread that got it.
+class UrlTable
+{
+public:
+  using Index = int;
+
+  explicit UrlTable(std::size_t shards = 64); // rounded up to a power of two, at least 2
+  ~UrlTable();
+  UrlTable(UrlTable const&) = delete;
+  UrlTable& operator=(UrlTable const&) = delete;
+
+  // the id of {url}, and whether this call added it
+  auto insert(std::string_view url) -> std::pair<Index, bool>;
+  auto find(std::string_view url) const -> std::optional<Index>;
+  auto url(Index index) const -> std::string const&;
+  // {url} leads to {index} from now on, url({index}) is unchanged
+  void assign(std::string_view url, Index index);
+
+  auto size() const -> std::size_t { return m_next.load(std::memory_order_acquire); }
+  void clear(); // not thread safe
+
+private:
+  static constexpr int first_segment_bits = 10; // 1024 urls in the first segment
+  static constexpr int segment_count = 32 - first_segment_bits;
+
+  struct Slot
+  {
+    std::uint64_t hash{};
+    Index key = -1;   // whose url the slot holds, -1 when empty
+    Index value = -1; // what it maps to, {key} unless reassigned
+  };
+
+  struct alignas(64) Shard
+  {
+    mutable std::mutex mutex;
+    std::vector<Slot> slots;
+    std::size_t used{};
+  };
+
+  auto shard(std::uint64_t hash) const -> Shard& { return m_shards[hash >> m_shift]; }
+  // position of the slot holding {url}, or of the empty slot it would go in
+  auto probe(Shard const&, std::uint64_t hash, std::string_view key) const -> std::size_t;
+  auto static locate(Index) -> std::pair<int, std::size_t>; // segment and offset of an id
+  void grow(Shard&);
+  auto store(Index index) -> std::string&; // allocates the segment on first use
+  void release();
+
+  std::unique_ptr<Shard[]> m_shards;
+  int m_shift{}; // hash bits below the shard number
+  std::atomic<Index> m_next{0};
+  std::array<std::atomic<std::string*>, segment_count> m_segments{};
+};
@@ -0,0 +1,247 @@
+#include <archive.hpp>
+//
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+//
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+//
+#include <zlib.h>
+//
+#include <url.hpp>
+
+namespace {
+
+constexpr char record_magic[4] = {'C', 'R', 'W', '2'}; // 2: the header has a kind
+
+struct RecordHeader
+{
+  char magic[4];
+  std::int32_t status;
+  std::uint32_t url_size;
+  std::uint32_t final_url_size;
+  std::uint32_t headers_size;
+  std::uint32_t body_size; // uncompressed
+  std::uint64_t compressed_size;
+  std::uint32_t kind; // RecordKind
+};
+
+struct IndexEntry
+{
+  std::uint64_t url_hash;
+  std::uint64_t offset;
+  std::uint64_t size;
+};
+
+auto index_path(std::filesystem::path path) -> std::filesystem::path
+{
+  path += ".idx";
+  return path;
+}
+
+auto map_file(std::filesystem::path const& path, std::size_t& size) -> void*
+{
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if(fd < 0) {
+    throw std::runtime_error("Failed to open archive " + path.string());
+  }
+
+  struct stat st{};
+  fstat(fd, &st);
+  size = static_cast<std::size_t>(st.st_size);
+
+  void* data = nullptr;
+  if(size > 0) {
+    data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(data == MAP_FAILED) {
+      ::close(fd);
+      throw std::runtime_error("Failed to map archive " + path.string());
+    }
+  }
+
+  ::close(fd);
+  return data;
+}
+
+auto index_entries(void const* data) -> IndexEntry const*
+{
+  return static_cast<IndexEntry const*>(data);
+}
+
+} // namespace
+
+ArchiveWriter::ArchiveWriter(std::filesystem::path const& path) :
+  m_path{path}
+{
+  if(path.has_parent_path()) {
+    std::filesystem::create_directories(path.parent_path());
+  }
+
+  m_data.open(path, std::ios::binary | std::ios::app);
+  m_index.open(index_path(path), std::ios::binary | std::ios::app);
+  if(!m_data || !m_index) {
+    throw std::runtime_error("Failed to open archive " + path.string());
+  }
+
+  m_offset = std::filesystem::file_size(path);
+}
+
+void ArchiveWriter::append(ArchiveRecord const& record)
+{
+  std::lock_guard lock(m_mutex);
+
+  uLongf compressed_size = compressBound(record.body.size());
+  m_compressed.resize(compressed_size);
+  int rc = compress2(reinterpret_cast<Bytef*>(m_compressed.data()), &compressed_size,
+    reinterpret_cast<const Bytef*>(record.body.data()), record.body.size(), Z_BEST_SPEED);
+  if(rc != Z_OK) {
+    throw std::runtime_error("Failed to compress " + record.url + " for the archive.");
+  }
+
+  RecordHeader header{};
+  std::memcpy(header.magic, record_magic, sizeof(record_magic));
+  header.status = static_cast<std::int32_t>(record.status);
+  header.url_size = record.url.size();
+  header.final_url_size = record.final_url.size();
+  header.headers_size = record.headers.size();
+  header.body_size = record.body.size();
+  header.compressed_size = compressed_size;
+  header.kind = static_cast<std::uint32_t>(record.kind);
+
+  m_data.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  m_data.write(record.url.data(), record.url.size());
+  m_data.write(record.final_url.data(), record.final_url.size());
+  m_data.write(record.headers.data(), record.headers.size());
+  m_data.write(m_compressed.data(), compressed_size);
+  m_data.flush();
+  if(!m_data) {
+    throw std::runtime_error("Failed to write archive " + m_path.string());
+  }
+
+  std::uint64_t size = sizeof(header) + record.url.size() + record.final_url.size() + record.headers.size() + compressed_size;
+
+  IndexEntry entry{fnv1a64(record.url), m_offset, size};
+  m_index.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+  if(record.final_url != record.url) {
+    entry.url_hash = fnv1a64(record.final_url);
+    m_index.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+  }
+  m_index.flush();
+
+  m_offset += size;
+}
+
+ArchiveReader::ArchiveReader(std::filesystem::path const& path)
+{
+  m_data.data = map_file(path, m_data.size);
+  m_index.data = map_file(index_path(path), m_index.size);
+
+  // a trailing partial entry, or one pointing past the data, is an
+  // interrupted append and is ignored
+  std::size_t entries = m_index.size / sizeof(IndexEntry);
+  IndexEntry const* index = index_entries(m_index.data);
+  m_by_hash.reserve(entries);
+
+  for(std::size_t i = 0; i < entries; ++i) {
+    IndexEntry const& entry = index[i];
+    if(entry.size < sizeof(RecordHeader) || entry.size > m_data.size || entry.offset > m_data.size - entry.size) {
+      continue;
+    }
+
+    if(m_records.empty() || m_records.back().offset != entry.offset) {
+      m_records.push_back(Span{entry.offset, entry.size});
+    }
+    m_by_hash.push_back(static_cast<std::uint32_t>(i));
+  }
+
+  // entries stay in the mapping, only their order by hash is kept. stable,
+  // so the entries of one url stay in append order
+  std::stable_sort(m_by_hash.begin(), m_by_hash.end(), [index](std::uint32_t a, std::uint32_t b) {
+    return index[a].url_hash < index[b].url_hash;
+  });
+}
+
+ArchiveReader::~ArchiveReader()
+{
+  if(m_data.data) munmap(m_data.data, m_data.size);
+  if(m_index.data) munmap(m_index.data, m_index.size);
+}
+
+std::optional<ArchiveRecord> ArchiveReader::find(std::string_view url) const
+{
+  IndexEntry const* index = index_entries(m_index.data);
+  std::uint64_t hash = fnv1a64(url);
+  auto first = std::partition_point(m_by_hash.begin(), m_by_hash.end(), [&](std::uint32_t i) { return index[i].url_hash < hash; });
+  auto last = std::partition_point(first, m_by_hash.end(), [&](std::uint32_t i) { return index[i].url_hash == hash; });
+
+  // newest first, and guard against hash collisions. a page fetched as
+  // {url} wins over one that merely redirected there.
+  std::optional<ArchiveRecord> redirected;
+  for(auto position = std::make_reverse_iterator(last); position != std::make_reverse_iterator(first); ++position) {
+    ArchiveRecord record = read(entry(*position));
+    if(record.url == url) {
+      return record;
+    }
+    if(!redirected && record.final_url == url) {
+      redirected = std::move(record);
+    }
+  }
+
+  return redirected;
+}
+
+ArchiveReader::Span ArchiveReader::entry(std::uint32_t position) const
+{
+  IndexEntry const& entry = index_entries(m_index.data)[position];
+  return Span{entry.offset, entry.size};
+}
+
+ArchiveRecord ArchiveReader::read(Span span) const
+{
+  // zlib never compresses better than about 1:1032
+  constexpr std::uint64_t max_ratio = 1032;
+
+  auto corrupt = [&span]() {
+    return std::runtime_error("Corrupt archive record at offset " + std::to_string(span.offset));
+  };
+
+  // spans were checked against the mapping when the index was read
+  auto const* base = static_cast<const char*>(m_data.data) + span.offset;
+
+  RecordHeader header;
+  std::memcpy(&header, base, sizeof(header));
+  if(std::memcmp(header.magic, record_magic, sizeof(record_magic)) != 0) {
+    throw corrupt();
+  }
+
+  // a torn or damaged record must not lead the copies out of its span
+  std::uint64_t fields = std::uint64_t{header.url_size} + header.final_url_size + header.headers_size;
+  if(fields > span.size - sizeof(header) || header.compressed_size != span.size - sizeof(header) - fields ||
+     header.body_size > header.compressed_size * max_ratio + 64 || header.kind > static_cast<std::uint32_t>(RecordKind::head)) {
+    throw corrupt();
+  }
+
+  ArchiveRecord record;
+  const char* cursor = base + sizeof(header);
+  record.status = header.status;
+  record.kind = static_cast<RecordKind>(header.kind);
+  record.url.assign(cursor, header.url_size);
+  cursor += header.url_size;
+  record.final_url.assign(cursor, header.final_url_size);
+  cursor += header.final_url_size;
+  record.headers.assign(cursor, header.headers_size);
+  cursor += header.headers_size;
+
+  record.body.resize(header.body_size);
+  uLongf body_size = header.body_size;
+  int rc = uncompress(reinterpret_cast<Bytef*>(record.body.data()), &body_size,
+    reinterpret_cast<const Bytef*>(cursor), header.compressed_size);
+  if(rc != Z_OK || body_size != header.body_size) {
+    throw std::runtime_error("Failed to decompress archive record for " + record.url);
+  }
+
+  return record;
+}
@@ -0,0 +1,301 @@
+#include <canonical.hpp>
+//
+#include <algorithm>
+#include <utility>
+//
+#include <url.hpp>
+
+namespace {
+
+auto is_unreserved(unsigned char c) -> bool
+{
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '.' || c == '_' || c == '~';
+}
+
+auto hex_value(char c) -> int
+{
+  if(c >= '0' && c <= '9') return c - '0';
+  if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+auto to_lower(char c) -> char
+{
+  return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+auto to_upper(char c) -> char
+{
+  return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+}
+
+auto iequals(std::string_view a, std::string_view b) -> bool
+{
+  return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) { return to_lower(x) == to_lower(y); });
+}
+
+// case insensitive, a trailing '*' matches any suffix
+auto matches_any(std::vector<std::string> const& patterns, std::string_view name) -> bool
+{
+  for(std::string_view pattern : patterns) {
+    if(!pattern.empty() && pattern.back() == '*') {
+      pattern.remove_suffix(1);
+      if(name.size() >= pattern.size() && iequals(name.substr(0, pattern.size()), pattern)) {
+        return true;
+      }
+    } else if(iequals(name, pattern)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// appends to the output and hashes it at the same time, so the
+// fingerprint does not need a second pass over the url
+struct Emitter
+{
+  std::string& out;
+  std::uint64_t hash = fnv1a64({});
+
+  void put(char c)
+  {
+    out.push_back(c);
+    hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+  }
+
+  void put(std::string_view s)
+  {
+    out.append(s);
+    hash = fnv1a64(s, hash);
+  }
+};
+
+struct StringSink
+{
+  std::string& out;
+  void put(char c) { out.push_back(c); }
+};
+
+// copies {part}, decoding escaped unreserved characters and uppercasing
+// the hex digits of the other escapes
+template<typename Sink>
+void put_escaped(Sink& sink, std::string_view part, bool decode)
+{
+  for(std::size_t i = 0; i < part.size(); ++i) {
+    char c = part[i];
+    if(c == '%' && i + 2 < part.size() && hex_value(part[i + 1]) >= 0 && hex_value(part[i + 2]) >= 0) {
+      auto value = static_cast<unsigned char>(hex_value(part[i + 1]) * 16 + hex_value(part[i + 2]));
+      if(decode && is_unreserved(value)) {
+        sink.put(static_cast<char>(value));
+      } else {
+        sink.put('%');
+        sink.put(to_upper(part[i + 1]));
+        sink.put(to_upper(part[i + 2]));
+      }
+      i += 2;
+    } else {
+      sink.put(c);
+    }
+  }
+}
+
+} // namespace
+
+std::vector<std::string> CanonicalRules::default_drop_params()
+{
+  return {"utm_*", "fbclid", "gclid", "dclid", "msclkid", "mc_cid", "mc_eid", "_hsenc", "_hsmi",
+    "phpsessid", "jsessionid", "sessionid", "sid"};
+}
+
+Canonicalizer::Canonicalizer() :
+  Canonicalizer(CanonicalRules{.drop_params = CanonicalRules::default_drop_params()})
+{
+}
+
+Canonicalizer::Canonicalizer(CanonicalRules defaults) :
+  m_defaults{std::move(defaults)}
+{
+}
+
+Canonicalizer const& Canonicalizer::defaults()
+{
+  static const Canonicalizer instance{};
+  return instance;
+}
+
+void Canonicalizer::set_rules(std::string host, CanonicalRules rules)
+{
+  std::transform(host.begin(), host.end(), host.begin(), to_lower);
+  m_hosts.insert_or_assign(std::move(host), std::move(rules));
+}
+
+CanonicalRules const& Canonicalizer::rules_for(std::string_view host) const
+{
+  if(m_hosts.empty()) {
+    return m_defaults;
+  }
+
+  // en.m.wikipedia.org, m.wikipedia.org, wikipedia.org, org
+  while(!host.empty()) {
+    auto it = m_hosts.find(host);
+    if(it != m_hosts.end()) {
+      return it->second;
+    }
+    auto dot = host.find('.');
+    if(dot == std::string_view::npos) {
+      break;
+    }
+    host.remove_prefix(dot + 1);
+  }
+
+  return m_defaults;
+}
+
+std::string Canonicalizer::canonicalize(std::string_view url) const
+{
+  std::string out;
+  canonicalize(url, out);
+  return out;
+}
+
+std::uint64_t Canonicalizer::canonicalize(std::string_view url, std::string& out) const
+{
+  // scratch space, kept per thread so canonicalizing does not allocate
+  thread_local std::string host;
+  thread_local std::string params;
+  thread_local std::vector<std::pair<std::size_t, std::size_t>> spans;
+
+  out.clear();
+  Emitter emit{out};
+
+  // Remove fragment
+  url = url.substr(0, url.find('#'));
+
+  auto scheme_end = url.find("://");
+  if(scheme_end == std::string_view::npos) {
+    emit.put(url);
+    return emit.hash;
+  }
+
+  std::string_view scheme = url.substr(0, scheme_end);
+  std::string_view rest = url.substr(scheme_end + 3);
+  std::size_t authority_end = std::min(rest.find_first_of("/?"), rest.size());
+  std::string_view authority = rest.substr(0, authority_end);
+  rest.remove_prefix(authority_end);
+
+  std::string_view path = rest.substr(0, rest.find('?'));
+  std::string_view query = rest.substr(path.size());
+  if(!query.empty()) {
+    query.remove_prefix(1); // '?'
+  }
+
+  // split the authority into userinfo, host and port
+  std::string_view userinfo;
+  auto at = authority.rfind('@');
+  if(at != std::string_view::npos) {
+    userinfo = authority.substr(0, at + 1);
+    authority.remove_prefix(at + 1);
+  }
+
+  std::size_t host_end = authority.size();
+  if(!authority.empty() && authority.front() == '[') {
+    auto close = authority.find(']');
+    host_end = close == std::string_view::npos ? authority.size() : close + 1;
+  } else {
+    host_end = std::min(authority.find(':'), authority.size());
+  }
+  std::string_view raw_host = authority.substr(0, host_end);
+  std::string_view port = authority.substr(host_end);
+  if(!port.empty()) {
+    port.remove_prefix(1); // ':'
+  }
+
+  host.assign(raw_host);
+  std::transform(host.begin(), host.end(), host.begin(), to_lower);
+  if(!host.empty() && host.back() == '.') {
+    host.pop_back();
+  }
+
+  CanonicalRules const& rules = rules_for(host);
+
+  // scheme://
+  for(char c : scheme) {
+    emit.put(to_lower(c));
+  }
+  emit.put("://");
+  emit.put(userinfo);
+
+  // host[:port]
+  std::string_view canonical_host = rules.lowercase_host ? std::string_view(host) : raw_host;
+  if(rules.strip_www && canonical_host.size() > 4 && iequals(canonical_host.substr(0, 4), "www.")
+     && canonical_host.find('.', 4) != std::string_view::npos) {
+    canonical_host.remove_prefix(4);
+  }
+  emit.put(canonical_host);
+
+  bool default_port = port.empty()
+    || (iequals(scheme, "http") && port == "80")
+    || (iequals(scheme, "https") && port == "443");
+  if(!port.empty() && !(rules.strip_default_port && default_port)) {
+    emit.put(':');
+    emit.put(port);
+  }
+
+  // /path
+  auto last_slash = path.rfind('/');
+  if(last_slash != std::string_view::npos && matches_any(rules.index_files, path.substr(last_slash + 1))) {
+    path = path.substr(0, last_slash + 1);
+  }
+  if(rules.strip_trailing_slash && path.size() > 1 && path.back() == '/') {
+    path.remove_suffix(1);
+  }
+  if(path.empty()) {
+    emit.put('/');
+  } else {
+    put_escaped(emit, path, rules.decode_unreserved);
+  }
+
+  // ?query
+  if(!rules.keep_query || query.empty()) {
+    return emit.hash;
+  }
+
+  params.clear();
+  spans.clear();
+  StringSink sink{params};
+  while(!query.empty()) {
+    std::string_view param = query.substr(0, query.find('&'));
+    query.remove_prefix(std::min(param.size() + 1, query.size()));
+    if(param.empty()) {
+      continue;
+    }
+
+    std::string_view name = param.substr(0, param.find('='));
+    if(!rules.keep_params.empty() && !matches_any(rules.keep_params, name)) {
+      continue;
+    }
+    if(matches_any(rules.drop_params, name)) {
+      continue;
+    }
+
+    std::size_t start = params.size();
+    put_escaped(sink, param, rules.decode_unreserved);
+    spans.emplace_back(start, params.size() - start);
+  }
+
+  auto view = [&](std::pair<std::size_t, std::size_t> span) {
+    return std::string_view(params).substr(span.first, span.second);
+  };
+
+  if(rules.sort_query) {
+    std::sort(spans.begin(), spans.end(), [&](auto a, auto b) { return view(a) < view(b); });
+  }
+
+  for(std::size_t i = 0; i < spans.size(); ++i) {
+    emit.put(i == 0 ? '?' : '&');
+    emit.put(view(spans[i]));
+  }
+
+  return emit.hash;
+}
@@ -0,0 +1,222 @@
+#include <cluster.hpp>
+//
+#include <algorithm>
+#include <map>
+#include <numeric>
+#include <random>
+#include <unordered_map>
+
+namespace {
+
+using EdgeList = std::vector<std::pair<int, int>>;
+
+// the edges with both ends in the same group, per group, renumbered by the
+// position of the node in its group
+auto edges_per_group(EdgeList const& edges, std::vector<int> const& group_of, std::vector<int> const& position,
+  std::size_t groups) -> std::vector<EdgeList>
+{
+  std::vector<EdgeList> out(groups);
+  for(auto const& [from, to] : edges) {
+    if(group_of[from] >= 0 && group_of[from] == group_of[to]) {
+      out[group_of[from]].emplace_back(position[from], position[to]);
+    }
+  }
+  return out;
+}
+
+// {nodes}, ascending, in groups of at most max_size: the communities of the
+// links among them, the tiny ones pooled, and runs of consecutive nodes once
+// that stops making them smaller. {inside} links positions in {nodes}
+void split(std::vector<int> const& nodes, EdgeList const& inside, ClusterOptions const& options,
+  std::vector<std::vector<int>>& out)
+{
+  if(nodes.size() <= options.max_size) {
+    out.push_back(nodes);
+    return;
+  }
+
+  std::vector<int> labels = propagate_labels(nodes.size(), inside, options.max_rounds, options.seed);
+  std::unordered_map<int, std::size_t> sizes;
+  for(int label : labels) {
+    ++sizes[label];
+  }
+
+  constexpr int pooled = -1;
+  std::map<int, int> part_of_label; // label -> position in {parts}
+  std::vector<std::vector<int>> parts;
+  std::vector<int> part_of(nodes.size());
+  std::vector<int> position(nodes.size());
+  for(std::size_t i = 0; i < nodes.size(); ++i) {
+    int label = sizes[labels[i]] < options.min_size ? pooled : labels[i];
+    auto [it, inserted] = part_of_label.try_emplace(label, static_cast<int>(parts.size()));
+    if(inserted) {
+      parts.emplace_back();
+    }
+    part_of[i] = it->second;
+    position[i] = static_cast<int>(parts[it->second].size());
+    parts[it->second].push_back(nodes[i]);
+  }
+
+  if(parts.size() == 1) {
+    for(std::size_t first = 0; first < nodes.size(); first += options.max_size) {
+      std::size_t last = std::min(first + options.max_size, nodes.size());
+      out.emplace_back(nodes.begin() + static_cast<std::ptrdiff_t>(first), nodes.begin() + static_cast<std::ptrdiff_t>(last));
+    }
+    return;
+  }
+
+  std::vector<EdgeList> part_edges = edges_per_group(inside, part_of, position, parts.size());
+  for(std::size_t part = 0; part < parts.size(); ++part) {
+    split(parts[part], part_edges[part], options, out);
+  }
+}
+
+} // namespace
+
+std::vector<int> propagate_labels(std::size_t nodes, std::vector<std::pair<int, int>> const& edges,
+  int max_rounds, std::uint64_t seed)
+{
+  // undirected adjacency, as offsets into one array
+  std::vector<std::size_t> offsets(nodes + 1, 0);
+  for(auto const& [from, to] : edges) {
+    ++offsets[from + 1];
+    ++offsets[to + 1];
+  }
+  std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+  std::vector<int> neighbours(offsets.back());
+  std::vector<std::size_t> fill(offsets.begin(), offsets.end() - 1);
+  for(auto const& [from, to] : edges) {
+    neighbours[fill[from]++] = to;
+    neighbours[fill[to]++] = from;
+  }
+
+  std::vector<int> labels(nodes);
+  std::iota(labels.begin(), labels.end(), 0);
+  std::vector<int> order(labels);
+  std::mt19937_64 random(seed);
+
+  // votes per label for the current node, reset through {touched}
+  std::vector<int> votes(nodes, 0);
+  std::vector<int> touched;
+
+  for(int round = 0; round < max_rounds; ++round) {
+    std::shuffle(order.begin(), order.end(), random);
+    std::size_t changed = 0;
+
+    for(int node : order) {
+      for(std::size_t i = offsets[node]; i < offsets[node + 1]; ++i) {
+        int label = labels[neighbours[i]];
+        if(votes[label]++ == 0) {
+          touched.push_back(label);
+        }
+      }
+      if(touched.empty()) {
+        continue;
+      }
+
+      // ties keep the current label, which lets the rounds settle
+      int best = labels[node];
+      int best_votes = votes[best];
+      for(int label : touched) {
+        if(votes[label] > best_votes) {
+          best = label;
+          best_votes = votes[label];
+        }
+      }
+      for(int label : touched) {
+        votes[label] = 0;
+      }
+      touched.clear();
+
+      if(best != labels[node]) {
+        labels[node] = best;
+        ++changed;
+      }
+    }
+
+    if(changed == 0) {
+      break;
+    }
+  }
+
+  return labels;
+}
+
+Clusters cluster_graph(std::vector<std::uint64_t> const& hosts, std::vector<std::pair<int, int>> const& edges,
+  ClusterOptions const& options)
+{
+  std::vector<int> labels = propagate_labels(hosts.size(), edges, options.max_rounds, options.seed);
+
+  std::unordered_map<int, std::size_t> sizes;
+  for(int label : labels) {
+    ++sizes[label];
+  }
+
+  // a community keeps its label unless it is too small or too big to draw,
+  // then its pages fall back to their host
+  constexpr std::uint64_t by_host = ~0ull;
+  std::map<std::pair<std::uint64_t, std::uint64_t>, std::size_t> ids;
+  std::vector<std::vector<int>> groups;
+
+  for(std::size_t node = 0; node < hosts.size(); ++node) {
+    std::size_t size = sizes[labels[node]];
+    std::pair<std::uint64_t, std::uint64_t> key{static_cast<std::uint64_t>(labels[node]), 0};
+    if(size < options.min_size) {
+      key = {by_host, hosts[node]};
+    } else if(size > options.max_size) {
+      key = {static_cast<std::uint64_t>(labels[node]), hosts[node]};
+    }
+
+    auto [it, inserted] = ids.try_emplace(key, groups.size());
+    if(inserted) {
+      groups.emplace_back();
+    }
+    groups[it->second].push_back(static_cast<int>(node));
+  }
+
+  // what is still too big is cut down, each group with the links inside it.
+  // ids follow the order nodes are met
+  std::vector<int> group_of(hosts.size(), -1);
+  std::vector<int> position(hosts.size());
+  for(std::size_t group = 0; group < groups.size(); ++group) {
+    if(groups[group].size() > options.max_size) {
+      for(std::size_t i = 0; i < groups[group].size(); ++i) {
+        group_of[groups[group][i]] = static_cast<int>(group);
+        position[groups[group][i]] = static_cast<int>(i);
+      }
+    }
+  }
+  std::vector<EdgeList> group_edges = edges_per_group(edges, group_of, position, groups.size());
+
+  Clusters out;
+  for(std::size_t group = 0; group < groups.size(); ++group) {
+    split(groups[group], group_edges[group], options, out.members);
+  }
+  std::sort(out.members.begin(), out.members.end(),
+    [](std::vector<int> const& a, std::vector<int> const& b) { return a.front() < b.front(); });
+
+  out.of.resize(hosts.size());
+  for(std::size_t cluster = 0; cluster < out.members.size(); ++cluster) {
+    for(int node : out.members[cluster]) {
+      out.of[node] = static_cast<int>(cluster);
+    }
+  }
+
+  // links inside a cluster are drawn in its own view, the rest are summed
+  std::map<std::pair<int, int>, int> weights;
+  for(auto const& [from, to] : edges) {
+    int a = out.of[from];
+    int b = out.of[to];
+    if(a != b) {
+      ++weights[{a, b}];
+    }
+  }
+
+  out.edges.reserve(weights.size());
+  for(auto const& [pair, weight] : weights) {
+    out.edges.push_back(Clusters::Edge{.from = pair.first, .to = pair.second, .weight = weight});
+  }
+
+  return out;
+}
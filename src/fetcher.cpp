@@ -0,0 +1,376 @@
+#include <fetcher.hpp>
+//
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+//
+#include <fmt/color.h>
+#include <fmt/core.h>
+//
+#include <url.hpp>
+
+namespace {
+
+auto is_http_url(std::string_view url) -> bool
+{
+  return url.starts_with("http://") || url.starts_with("https://");
+}
+
+} // namespace
+
+size_t CurlFetcher::write_callback(char* ptr, size_t size, size_t nmemb, void* userdata)
+{
+  std::string* buffer = static_cast<std::string*>(userdata);
+  size_t total_size = size * nmemb; // size * number_of_bytes
+  buffer->append(ptr, total_size);  // append exactly total_size bytes from ptr
+  return total_size;
+}
+
+size_t CurlFetcher::header_callback(char* ptr, size_t size, size_t nitems, void* userdata)
+{
+  std::string* headers = static_cast<std::string*>(userdata);
+  std::string_view line(ptr, size * nitems);
+
+  // a status line starts the headers of the next redirect
+  if(line.starts_with("HTTP/")) {
+    headers->clear();
+  }
+
+  headers->append(line);
+  return line.size();
+}
+
+CurlFetcher::CurlFetcher()
+{
+  curl_global_init(CURL_GLOBAL_DEFAULT);
+  m_multi_handle = curl_multi_init();
+  m_easy = curl_easy_init(); // reused by every request, along with its connections
+
+  if(std::optional<DnsResolver::Options> options = DnsResolver::system_options()) {
+    m_resolver = std::make_unique<DnsResolver>(std::move(*options));
+  }
+}
+
+CurlFetcher::~CurlFetcher()
+{
+  curl_easy_cleanup(m_easy);
+  curl_multi_cleanup(m_multi_handle);
+  curl_global_cleanup();
+}
+
+CurlFetcher::Response CurlFetcher::fetch(std::string const& url)
+{
+  Response response;
+  fetch(url, response);
+  return response;
+}
+
+void CurlFetcher::fetch(std::string const& url, Response& out)
+{
+  transfer(url, out, nullptr, RecordKind::page);
+}
+
+void CurlFetcher::fetch(std::string const& url, Response& out, RecordKind kind)
+{
+  transfer(url, out, nullptr, kind);
+}
+
+bool CurlFetcher::fetch(std::string const& url, Response& out, Validators const& known)
+{
+  return transfer(url, out, &known, RecordKind::page) != 304;
+}
+
+long CurlFetcher::transfer(std::string const& url, Response& out, Validators const* known, RecordKind kind)
+{
+  // buffers are cleared, not freed, so they keep their capacity between pages
+  auto& [final_url, response] = out;
+  final_url.clear();
+  response.clear();
+
+  if(m_replay) {
+    replay(url, out);
+    return 200;
+  }
+
+  CURL* easy = m_easy;
+  if(!easy) {
+    throw std::runtime_error("Failed to init curl for " + url);
+  }
+
+  CURL* hedge = nullptr;
+  curl_slist* resolve = nullptr;
+  curl_slist* conditions = nullptr;
+  auto clean = [&]() {
+    curl_multi_remove_handle(m_multi_handle, easy);
+    if(hedge) {
+      curl_multi_remove_handle(m_multi_handle, hedge);
+      curl_easy_cleanup(hedge);
+    }
+    curl_slist_free_all(resolve);
+    curl_slist_free_all(conditions);
+  };
+
+  std::string& headers = m_headers;
+  headers.clear();
+
+  // timeouts follow what this host has needed so far
+  std::string_view host = url_host(url);
+  curl_easy_reset(easy);
+  curl_easy_setopt(easy, CURLOPT_URL, url.c_str());
+  curl_easy_setopt(easy, CURLOPT_VERBOSE, 0L);
+  curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, static_cast<long>(m_latency.timeout(host).count()));
+  curl_easy_setopt(easy, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(m_latency.connect_timeout(host).count()));
+  curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, CurlFetcher::write_callback);
+  curl_easy_setopt(easy, CURLOPT_WRITEDATA, &response);
+  curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, CurlFetcher::header_callback);
+  curl_easy_setopt(easy, CURLOPT_HEADERDATA, &headers);
+  curl_easy_setopt(easy, CURLOPT_FOLLOWLOCATION, 1L);
+  curl_easy_setopt(easy, CURLOPT_USERAGENT, "Mozilla/5.0");
+
+  // a page seen by an earlier crawl only comes back if it changed
+  if(known) {
+    if(!known->etag.empty()) {
+      conditions = curl_slist_append(conditions, ("If-None-Match: " + known->etag).c_str());
+    }
+    if(!known->last_modified.empty()) {
+      conditions = curl_slist_append(conditions, ("If-Modified-Since: " + known->last_modified).c_str());
+    }
+    curl_easy_setopt(easy, CURLOPT_HTTPHEADER, conditions);
+  }
+
+  // the address was looked up while the page sat in the frontier. once the
+  // resolver has no fresh answer, the one curl was given goes as well
+  if(m_resolver) {
+    std::string host_port = std::string(host) + ':' + std::to_string(url_port(url));
+    if(std::optional<std::string> entry = m_resolver->curl_resolve_entry(host, url_port(url))) {
+      resolve = curl_slist_append(nullptr, entry->c_str());
+      m_resolve_entries.insert(std::move(host_port));
+    } else if(m_resolve_entries.erase(host_port) > 0) {
+      resolve = curl_slist_append(nullptr, ('-' + host_port).c_str());
+    }
+    if(resolve) {
+      curl_easy_setopt(easy, CURLOPT_RESOLVE, resolve);
+    }
+  }
+
+  curl_multi_add_handle(m_multi_handle, easy);
+
+  // a slow request gets a duplicate once it runs past what the host usually
+  // takes, and whichever answers first wins
+  auto started = std::chrono::steady_clock::now();
+  std::optional<LatencyTracker::Duration> hedge_after = m_hedging ? m_latency.hedge_delay(host) : std::nullopt;
+  bool easy_running = true;
+  bool hedge_running = false;
+  CURL* winner = nullptr;
+  CURLcode result = CURLE_OK;
+
+  int still_running = 0;
+  curl_multi_perform(m_multi_handle, &still_running);
+
+  while(!winner) {
+    int queued = 0;
+    while(CURLMsg* msg = curl_multi_info_read(m_multi_handle, &queued)) {
+      if(msg->msg != CURLMSG_DONE) {
+        continue;
+      }
+
+      bool is_hedge = msg->easy_handle == hedge;
+      bool other_running = is_hedge ? easy_running : hedge_running;
+      (is_hedge ? hedge_running : easy_running) = false;
+
+      // a failure only counts once the other copy has failed as well
+      if(msg->data.result == CURLE_OK || !other_running) {
+        winner = msg->easy_handle;
+        result = msg->data.result;
+        break;
+      }
+    }
+
+    if(winner || (!easy_running && !hedge_running)) {
+      break;
+    }
+
+    auto elapsed = std::chrono::duration_cast<LatencyTracker::Duration>(std::chrono::steady_clock::now() - started);
+    if(hedge_after && !hedge && elapsed >= *hedge_after) {
+      hedge = curl_easy_duphandle(easy);
+      if(hedge) {
+        m_hedge_response.clear();
+        m_hedge_headers.clear();
+        curl_easy_setopt(hedge, CURLOPT_WRITEDATA, &m_hedge_response);
+        curl_easy_setopt(hedge, CURLOPT_HEADERDATA, &m_hedge_headers);
+        curl_multi_add_handle(m_multi_handle, hedge);
+        hedge_running = true;
+        ++m_hedged;
+      }
+    }
+
+    int wait_ms = 1000;
+    if(hedge_after && !hedge) {
+      wait_ms = static_cast<int>(std::clamp<LatencyTracker::Duration::rep>((*hedge_after - elapsed).count(), 1, 1000));
+    }
+
+    int numfds = 0;
+    CURLMcode mc = curl_multi_wait(m_multi_handle, nullptr, 0, wait_ms, &numfds);
+    if(mc != CURLM_OK) {
+      clean();
+      throw std::runtime_error("curl_multi_wait error");
+    }
+    curl_multi_perform(m_multi_handle, &still_running);
+  }
+
+  if(!winner) {
+    clean();
+    throw FetchError("Transfer lost for " + url, 0, true);
+  }
+
+  if(winner == hedge) {
+    response.swap(m_hedge_response);
+    headers.swap(m_hedge_headers);
+  }
+  // whatever the loser got so far
+  m_hedge_response.clear();
+  m_hedge_headers.clear();
+
+  if(result != CURLE_OK) {
+    if(result == CURLE_OPERATION_TIMEDOUT) {
+      m_latency.record_timeout(host);
+    }
+    clean();
+    throw FetchError(std::string(curl_easy_strerror(result)) + " for " + url, 0, is_retryable(0, result));
+  }
+  m_latency.record(host, std::chrono::duration_cast<LatencyTracker::Duration>(std::chrono::steady_clock::now() - started));
+
+  long response_code = 0;
+  curl_easy_getinfo(winner, CURLINFO_RESPONSE_CODE, &response_code);
+
+  char* eff_url_char = nullptr;
+  curl_easy_getinfo(winner, CURLINFO_EFFECTIVE_URL, &eff_url_char);
+
+  // errors are archived too, so a replay fails the same way
+  if(m_archive) {
+    m_archive->append(ArchiveRecord{
+      .url = url,
+      .final_url = eff_url_char ? eff_url_char : url,
+      .status = response_code,
+      .headers = headers,
+      .body = response,
+      .kind = kind,
+    });
+  }
+
+  if(response_code >= 400) {
+    clean();
+    throw FetchError("HTTP error " + std::to_string(response_code) + " for " + url, response_code, is_retryable(response_code, CURLE_OK));
+  }
+
+  if(!eff_url_char) {
+    clean();
+    throw std::runtime_error("Failed to get effective_url requesting html.");
+  }
+
+  final_url.assign(eff_url_char);
+  clean();
+  return response_code;
+}
+
+bool CurlFetcher::is_retryable(long status, CURLcode code)
+{
+  switch(code) {
+    case CURLE_OK:
+      break;
+    case CURLE_OPERATION_TIMEDOUT:
+    case CURLE_COULDNT_CONNECT:
+    case CURLE_SEND_ERROR:
+    case CURLE_RECV_ERROR:
+    case CURLE_GOT_NOTHING:
+    case CURLE_PARTIAL_FILE:
+      return true;
+    default:
+      return false;
+  }
+
+  // server trouble and rate limits pass, missing pages do not
+  return status >= 500 || status == 429 || status == 408;
+}
+
+std::optional<std::string> CurlFetcher::effective_url(std::string const& url)
+{
+  if(m_replay) {
+    std::optional<ArchiveRecord> record = m_replay->find(url);
+    if(!record) {
+      return std::nullopt;
+    }
+    return std::make_optional(record->final_url);
+  }
+
+  CURL* curl = curl_easy_init();
+  if(!curl) {
+    return std::nullopt;
+  }
+
+  curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+  curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+  curl_easy_setopt(curl, CURLOPT_VERBOSE, 0L);
+  curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+  curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);        // max 10 seconds per request
+  curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 15L); // max 5 seconds to connect
+
+  CURLcode res = curl_easy_perform(curl);
+  char* effective_url = nullptr;
+  if(res != CURLE_OK) {
+    fmt::print(stderr, fg(fmt::color::red), "❌ curl failed: {}\n", curl_easy_strerror(res));
+    curl_easy_cleanup(curl);
+    return std::nullopt;
+  }
+  curl_easy_getinfo(curl, CURLINFO_EFFECTIVE_URL, &effective_url);
+  if(effective_url) {
+    std::string final_url = effective_url;
+    if(!is_http_url(final_url)) {
+      throw std::runtime_error("invalid final url for " + url + ": " + final_url);
+    }
+
+    // keep the redirect, so a replay resolves the root the same way
+    if(m_archive) {
+      long response_code = 0;
+      curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
+      m_archive->append(ArchiveRecord{.url = url, .final_url = final_url, .status = response_code, .kind = RecordKind::head});
+    }
+
+    curl_easy_cleanup(curl);
+    return std::make_optional(final_url);
+  }
+  return std::nullopt;
+}
+
+void CurlFetcher::prefetch(std::string_view host)
+{
+  if(m_resolver && !m_replay) {
+    m_resolver->prefetch(host);
+  }
+}
+
+void CurlFetcher::record_to(std::filesystem::path const& path)
+{
+  m_archive = std::make_unique<ArchiveWriter>(path);
+}
+
+void CurlFetcher::replay_from(std::filesystem::path const& path)
+{
+  m_replay = std::make_unique<ArchiveReader>(path);
+}
+
+void CurlFetcher::replay(std::string const& url, Response& out)
+{
+  std::optional<ArchiveRecord> record = m_replay->find(url);
+  if(!record) {
+    throw std::runtime_error("Not in archive: " + url);
+  }
+
+  if(record->status >= 400) {
+    throw std::runtime_error("HTTP error " + std::to_string(record->status) + " for " + url);
+  }
+
+  out.first = std::move(record->final_url);
+  out.second = std::move(record->body);
+  m_headers = std::move(record->headers);
+}
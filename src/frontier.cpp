@@ -0,0 +1,169 @@
+#include <frontier.hpp>
+//
+#include <algorithm>
+#include <cmath>
+//
+#include <url.hpp>
+
+Frontier::Frontier() :
+  Frontier(default_scorer)
+{
+}
+
+Frontier::Frontier(Scorer scorer) :
+  m_scorer{std::move(scorer)}
+{
+}
+
+double Frontier::default_scorer(FrontierEntry const& entry, Frontier const& frontier)
+{
+  return entry.in_links
+    + 0.5 * entry.depth
+    - 0.25 * std::log2(1.0 + frontier.host_fetched(entry.host));
+}
+
+void Frontier::push(int index, int depth, std::string_view host)
+{
+  if(contains(index)) {
+    add_in_link(index, depth);
+    return;
+  }
+
+  FrontierEntry entry{.index = index, .depth = depth, .in_links = 1, .host = fnv1a64(host)};
+  entry.score = m_scorer(entry, *this);
+  insert(entry);
+}
+
+void Frontier::add_in_link(int index, int depth)
+{
+  if(!contains(index)) {
+    return;
+  }
+
+  std::size_t pos = m_position[index];
+  FrontierEntry& entry = m_heap[pos];
+  ++entry.in_links;
+  entry.depth = std::max(entry.depth, depth);
+  entry.score = m_scorer(entry, *this);
+  sift_up(pos);
+  sift_down(m_position[index]);
+}
+
+void Frontier::defer(FrontierEntry entry)
+{
+  entry.score = m_scorer(entry, *this);
+  insert(entry);
+}
+
+std::optional<FrontierEntry> Frontier::pop()
+{
+  return pop_ready([](FrontierEntry const&) { return true; }, 1);
+}
+
+std::optional<FrontierEntry> Frontier::pop_ready(std::function<bool(FrontierEntry const&)> const& ready, std::size_t lookahead)
+{
+  m_passed.clear();
+  std::optional<FrontierEntry> found;
+  while(!m_heap.empty() && m_passed.size() < lookahead) {
+    FrontierEntry entry = take_top();
+    if(ready(entry)) {
+      found = entry;
+      break;
+    }
+    m_passed.push_back(entry);
+  }
+
+  for(FrontierEntry const& entry : m_passed) {
+    insert(entry);
+  }
+  if(found) {
+    ++m_host_fetched[found->host];
+  }
+  return found;
+}
+
+FrontierEntry Frontier::take_top()
+{
+  // host_fetched() moves while an entry waits, so the top may be stale.
+  // rescore it and look again at whatever ends up on top.
+  while(true) {
+    double fresh = m_scorer(m_heap.front(), *this);
+    if(fresh >= m_heap.front().score) {
+      break;
+    }
+    m_heap.front().score = fresh;
+    sift_down(0);
+  }
+
+  FrontierEntry entry = m_heap.front();
+  swap(0, m_heap.size() - 1);
+  m_heap.pop_back();
+  m_position[entry.index] = -1;
+  if(!m_heap.empty()) {
+    sift_down(0);
+  }
+  return entry;
+}
+
+void Frontier::insert(FrontierEntry const& entry)
+{
+  if(static_cast<std::size_t>(entry.index) >= m_position.size()) {
+    m_position.resize(entry.index + 1, -1);
+  }
+  m_heap.push_back(entry);
+  m_position[entry.index] = static_cast<int>(m_heap.size() - 1);
+  sift_up(m_heap.size() - 1);
+}
+
+bool Frontier::contains(int index) const
+{
+  return index >= 0 && static_cast<std::size_t>(index) < m_position.size() && m_position[index] >= 0;
+}
+
+void Frontier::clear()
+{
+  m_heap.clear();
+  m_position.clear();
+  m_host_fetched.clear();
+}
+
+int Frontier::host_fetched(std::uint64_t host) const
+{
+  auto it = m_host_fetched.find(host);
+  return it == m_host_fetched.end() ? 0 : it->second;
+}
+
+void Frontier::swap(std::size_t a, std::size_t b)
+{
+  std::swap(m_heap[a], m_heap[b]);
+  m_position[m_heap[a].index] = static_cast<int>(a);
+  m_position[m_heap[b].index] = static_cast<int>(b);
+}
+
+void Frontier::sift_up(std::size_t pos)
+{
+  while(pos > 0) {
+    std::size_t parent = (pos - 1) / 2;
+    if(!less(parent, pos)) {
+      break;
+    }
+    swap(parent, pos);
+    pos = parent;
+  }
+}
+
+void Frontier::sift_down(std::size_t pos)
+{
+  while(true) {
+    std::size_t largest = pos;
+    std::size_t left = 2 * pos + 1;
+    std::size_t right = left + 1;
+    if(left < m_heap.size() && less(largest, left)) largest = left;
+    if(right < m_heap.size() && less(largest, right)) largest = right;
+    if(largest == pos) {
+      break;
+    }
+    swap(pos, largest);
+    pos = largest;
+  }
+}
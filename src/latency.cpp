@@ -0,0 +1,76 @@
+#include <latency.hpp>
+//
+#include <algorithm>
+#include <cmath>
+//
+#include <url.hpp>
+
+void LatencyTracker::record(std::string_view host, Duration elapsed)
+{
+  Stats& stats = m_hosts[fnv1a64(host)];
+  double sample = static_cast<double>(elapsed.count());
+
+  if(stats.samples == 0) {
+    stats.mean_ms = sample;
+    stats.deviation_ms = sample / 2;
+  } else {
+    stats.deviation_ms = (1 - m_limits.beta) * stats.deviation_ms + m_limits.beta * std::abs(stats.mean_ms - sample);
+    stats.mean_ms = (1 - m_limits.alpha) * stats.mean_ms + m_limits.alpha * sample;
+  }
+  ++stats.samples;
+}
+
+void LatencyTracker::record_timeout(std::string_view host)
+{
+  // the request took at least the timeout it hit. its retries wait no
+  // longer than that, so one slow answer cannot stall a host for longer
+  Duration hit = timeout(host);
+  record(host, hit);
+
+  Stats& stats = m_hosts[fnv1a64(host)];
+  double limit = static_cast<double>(hit.count());
+  stats.mean_ms = std::min(stats.mean_ms, limit);
+  stats.deviation_ms = std::min(stats.deviation_ms, (limit - stats.mean_ms) / m_limits.k);
+}
+
+auto LatencyTracker::find(std::string_view host) const -> Stats const*
+{
+  auto it = m_hosts.find(fnv1a64(host));
+  return it == m_hosts.end() ? nullptr : &it->second;
+}
+
+LatencyTracker::Duration LatencyTracker::timeout(std::string_view host) const
+{
+  Stats const* stats = find(host);
+  if(!stats) {
+    return m_limits.default_timeout;
+  }
+
+  auto estimate = Duration(static_cast<Duration::rep>(stats->mean_ms + m_limits.k * stats->deviation_ms));
+  return std::clamp(estimate, m_limits.min_timeout, m_limits.max_timeout);
+}
+
+LatencyTracker::Duration LatencyTracker::connect_timeout(std::string_view host) const
+{
+  if(!find(host)) {
+    return m_limits.default_connect;
+  }
+  return std::clamp(timeout(host) / 2, m_limits.min_connect, m_limits.default_connect);
+}
+
+std::optional<LatencyTracker::Duration> LatencyTracker::hedge_delay(std::string_view host) const
+{
+  Stats const* stats = find(host);
+  if(!stats || stats->samples < m_limits.hedge_min_samples) {
+    return std::nullopt;
+  }
+
+  auto delay = Duration(static_cast<Duration::rep>(stats->mean_ms + m_limits.hedge_k * stats->deviation_ms));
+  return std::min(delay, timeout(host));
+}
+
+std::optional<LatencyTracker::Stats> LatencyTracker::stats(std::string_view host) const
+{
+  Stats const* stats = find(host);
+  return stats ? std::make_optional(*stats) : std::nullopt;
+}
@@ -0,0 +1,63 @@
+#include <link_buffer.hpp>
+//
+#include <algorithm>
+//
+#include <url.hpp>
+
+void LinkBuffer::clear()
+{
+  m_size = 0;
+  std::fill(m_table.begin(), m_table.end(), 0);
+}
+
+std::string& LinkBuffer::next()
+{
+  if(m_size == m_links.size()) {
+    m_links.emplace_back();
+    m_hashes.emplace_back();
+  }
+  return m_links[m_size];
+}
+
+bool LinkBuffer::commit()
+{
+  return commit(fnv1a64(m_links[m_size]));
+}
+
+bool LinkBuffer::commit(std::uint64_t hash)
+{
+  // keep the load factor under 1/2
+  if((m_size + 1) * 2 > m_table.size()) {
+    rehash(std::max<std::size_t>(64, m_table.size() * 2));
+  }
+
+  std::string const& link = m_links[m_size];
+  std::size_t mask = m_table.size() - 1;
+
+  for(std::size_t i = hash & mask;; i = (i + 1) & mask) {
+    std::uint32_t slot = m_table[i];
+    if(slot == 0) {
+      m_table[i] = static_cast<std::uint32_t>(m_size + 1);
+      m_hashes[m_size] = hash;
+      ++m_size;
+      return true;
+    }
+    if(m_hashes[slot - 1] == hash && m_links[slot - 1] == link) {
+      return false;
+    }
+  }
+}
+
+void LinkBuffer::rehash(std::size_t buckets)
+{
+  m_table.assign(buckets, 0);
+  std::size_t mask = buckets - 1;
+
+  for(std::size_t slot = 0; slot < m_size; ++slot) {
+    std::size_t i = m_hashes[slot] & mask;
+    while(m_table[i] != 0) {
+      i = (i + 1) & mask;
+    }
+    m_table[i] = static_cast<std::uint32_t>(slot + 1);
+  }
+}
@@ -0,0 +1,624 @@
+#include <live_view.hpp>
+//
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+//
+#include <fmt/core.h>
+//
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr std::size_t max_request = 8192;
+
+// served as is, it only talks to /events
+constexpr std::string_view viewer_page = R"html(<!doctype html>
+<html>
+<head>
+<meta charset="utf-8">
+<title>crawler · live</title>
+<style>
+  html, body { margin: 0; height: 100%; overflow: hidden; background: #111; color: #ddd; font: 13px monospace; }
+  #bar { position: fixed; top: 0; left: 0; right: 0; padding: 6px 10px; background: #000b; white-space: pre; }
+  canvas { display: block; width: 100%; height: 100%; }
+</style>
+</head>
+<body>
+<div id="bar">connecting…</div>
+<canvas id="view"></canvas>
+<script>
+// in PageStatus order
+const names = ['found', 'fetched', 'unchanged', 'retrying', 'failed', 'merged', 'disallowed'];
+const colors = ['#777', '#4c8', '#48c', '#fa3', '#e44', '#a6a', '#444'];
+
+const nodes = [], all = [], links = [];
+const canvas = document.getElementById('view'), ctx = canvas.getContext('2d'), bar = document.getElementById('bar');
+const view = { x: 0, y: 0, scale: 1 };
+let connected = false, selected = null;
+
+function reset() {
+  nodes.length = 0;
+  all.length = 0;
+  links.length = 0;
+  selected = null;
+}
+
+function add(batch) {
+  for (const [index, url, depth, status] of batch.pages) {
+    if (nodes[index]) continue;
+    const angle = Math.random() * 2 * Math.PI, radius = 50 + Math.random() * 50;
+    const node = { url, depth, status, x: Math.cos(angle) * radius, y: Math.sin(angle) * radius, vx: 0, vy: 0, placed: false };
+    nodes[index] = node;
+    all.push(node);
+  }
+  for (const [index, status] of batch.status) {
+    if (nodes[index]) nodes[index].status = status;
+  }
+  for (const [from, to] of batch.links) {
+    const a = nodes[from], b = nodes[to];
+    if (!a || !b) continue;
+    links.push([a, b]);
+    // a new page starts next to the page that found it
+    if (!b.placed && b !== a) {
+      b.x = a.x + (Math.random() - 0.5) * 30;
+      b.y = a.y + (Math.random() - 0.5) * 30;
+    }
+    a.placed = b.placed = true;
+  }
+}
+
+// springs along links, repulsion only between pages sharing a grid cell
+function step() {
+  const cell = 40, grid = new Map();
+  for (const n of all) {
+    const key = Math.floor(n.x / cell) + ',' + Math.floor(n.y / cell);
+    let bucket = grid.get(key);
+    if (!bucket) grid.set(key, bucket = []);
+    if (bucket.length < 32) bucket.push(n);
+  }
+  for (const bucket of grid.values()) {
+    for (let i = 0; i < bucket.length; i++) {
+      for (let j = i + 1; j < bucket.length; j++) {
+        const a = bucket[i], b = bucket[j];
+        const dx = a.x - b.x || Math.random() - 0.5, dy = a.y - b.y || Math.random() - 0.5;
+        const f = Math.min(60 / (dx * dx + dy * dy), 1);
+        a.vx += dx * f; a.vy += dy * f;
+        b.vx -= dx * f; b.vy -= dy * f;
+      }
+    }
+  }
+  for (const [a, b] of links) {
+    const dx = b.x - a.x, dy = b.y - a.y, d = Math.sqrt(dx * dx + dy * dy) + 0.01;
+    const f = (d - 30) * 0.005 / d;
+    a.vx += dx * f; a.vy += dy * f;
+    b.vx -= dx * f; b.vy -= dy * f;
+  }
+  for (const n of all) {
+    n.vx = (n.vx - n.x * 0.0005) * 0.8;
+    n.vy = (n.vy - n.y * 0.0005) * 0.8;
+    n.x += n.vx;
+    n.y += n.vy;
+  }
+}
+
+function draw() {
+  const width = canvas.width = canvas.clientWidth, height = canvas.height = canvas.clientHeight;
+  ctx.setTransform(view.scale, 0, 0, view.scale, width / 2 + view.x, height / 2 + view.y);
+
+  ctx.strokeStyle = links.length > 20000 ? '#ffffff0c' : '#ffffff22';
+  ctx.lineWidth = 1 / view.scale;
+  ctx.beginPath();
+  for (const [a, b] of links) {
+    ctx.moveTo(a.x, a.y);
+    ctx.lineTo(b.x, b.y);
+  }
+  ctx.stroke();
+
+  const size = Math.max(3 / view.scale, 1);
+  for (const n of all) {
+    ctx.fillStyle = colors[n.status];
+    ctx.fillRect(n.x - size / 2, n.y - size / 2, size, size);
+  }
+  if (selected) {
+    ctx.strokeStyle = '#fff';
+    ctx.strokeRect(selected.x - size, selected.y - size, size * 2, size * 2);
+  }
+
+  const counts = names.map(() => 0);
+  for (const n of all) counts[n.status]++;
+  bar.textContent = (connected ? '● live' : '○ disconnected') + `   ${all.length} pages  ${links.length} links   `
+    + names.map((name, i) => `${name} ${counts[i]}`).join('  ')
+    + (selected ? `\n${selected.url} (depth ${selected.depth}, ${names[selected.status]})` : '');
+}
+
+function frame() {
+  step();
+  draw();
+  requestAnimationFrame(frame);
+}
+
+function to_graph(event) {
+  return [(event.offsetX - canvas.width / 2 - view.x) / view.scale, (event.offsetY - canvas.height / 2 - view.y) / view.scale];
+}
+
+canvas.addEventListener('wheel', event => {
+  event.preventDefault();
+  const [x, y] = to_graph(event);
+  view.scale *= event.deltaY < 0 ? 1.2 : 1 / 1.2;
+  view.x = event.offsetX - canvas.width / 2 - x * view.scale;
+  view.y = event.offsetY - canvas.height / 2 - y * view.scale;
+}, { passive: false });
+
+let drag = null;
+canvas.addEventListener('mousedown', event => drag = { x: event.offsetX, y: event.offsetY, moved: false });
+canvas.addEventListener('mousemove', event => {
+  if (!drag) return;
+  view.x += event.offsetX - drag.x;
+  view.y += event.offsetY - drag.y;
+  drag = { x: event.offsetX, y: event.offsetY, moved: true };
+});
+canvas.addEventListener('mouseup', event => {
+  if (drag && !drag.moved) {
+    const [x, y] = to_graph(event), reach = 8 / view.scale;
+    selected = null;
+    let best = reach * reach;
+    for (const n of all) {
+      const d = (n.x - x) ** 2 + (n.y - y) ** 2;
+      if (d < best) { best = d; selected = n; }
+    }
+  }
+  drag = null;
+});
+
+const events = new EventSource('events');
+events.addEventListener('snapshot', event => { reset(); add(JSON.parse(event.data)); });
+events.onmessage = event => add(JSON.parse(event.data));
+events.onopen = () => connected = true;
+events.onerror = () => connected = false;
+requestAnimationFrame(frame);
+</script>
+</body>
+</html>
+)html";
+
+void append_json_string(std::string& out, std::string_view text)
+{
+  out += '"';
+  for(char c : text) {
+    switch(c) {
+      case '"':
+        out += "\\\"";
+        break;
+      case '\\':
+        out += "\\\\";
+        break;
+      case '\n':
+        out += "\\n";
+        break;
+      case '\r':
+        out += "\\r";
+        break;
+      case '\t':
+        out += "\\t";
+        break;
+      default:
+        if(static_cast<unsigned char>(c) < 0x20) {
+          out += fmt::format("\\u{:04x}", static_cast<int>(c));
+        } else {
+          out += c;
+        }
+    }
+  }
+  out += '"';
+}
+
+auto status_line(int code) -> std::string_view
+{
+  switch(code) {
+    case 200:
+      return "200 OK";
+    case 404:
+      return "404 Not Found";
+    case 405:
+      return "405 Method Not Allowed";
+    default:
+      return "400 Bad Request";
+  }
+}
+
+// a whole response, the connection closes after it
+auto plain_response(int code, std::string_view type, std::string_view body) -> std::string
+{
+  return fmt::format("HTTP/1.1 {}\r\nContent-Type: {}\r\nContent-Length: {}\r\nConnection: close\r\n\r\n{}",
+    status_line(code), type, body.size(), body);
+}
+
+void set_nonblocking(int fd)
+{
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+} // namespace
+
+void GraphDeltas::page(int index, std::string_view url, int depth)
+{
+  if(m_page_at.contains(index)) {
+    return;
+  }
+  m_page_at.emplace(index, m_pages.size());
+  m_pages.push_back(Page{.index = index, .url = std::string(url), .depth = depth});
+}
+
+void GraphDeltas::status(int index, PageStatus status)
+{
+  if(auto page = m_page_at.find(index); page != m_page_at.end()) {
+    m_pages[page->second].status = status;
+    return;
+  }
+
+  auto [at, added] = m_status_at.try_emplace(index, m_statuses.size());
+  if(added) {
+    m_statuses.emplace_back(index, status);
+  } else {
+    m_statuses[at->second].second = status;
+  }
+}
+
+void GraphDeltas::link(int from, int to)
+{
+  std::uint64_t key = static_cast<std::uint64_t>(static_cast<std::uint32_t>(from)) << 32 | static_cast<std::uint32_t>(to);
+  if(m_link_set.insert(key).second) {
+    m_links.emplace_back(from, to);
+  }
+}
+
+void GraphDeltas::append(GraphDeltas const& later)
+{
+  for(Page const& added : later.m_pages) {
+    page(added.index, added.url, added.depth);
+    status(added.index, added.status);
+  }
+  for(auto const& [index, value] : later.m_statuses) {
+    status(index, value);
+  }
+  for(auto const& [from, to] : later.m_links) {
+    link(from, to);
+  }
+}
+
+void GraphDeltas::clear()
+{
+  m_pages.clear();
+  m_page_at.clear();
+  m_statuses.clear();
+  m_status_at.clear();
+  m_links.clear();
+  m_link_set.clear();
+}
+
+auto GraphDeltas::to_json() const -> std::string
+{
+  std::string out;
+  out.reserve(64 + m_pages.size() * 64 + m_statuses.size() * 12 + m_links.size() * 16);
+
+  out += "{\"pages\":[";
+  for(std::size_t i = 0; i < m_pages.size(); ++i) {
+    Page const& page = m_pages[i];
+    out += i == 0 ? "[" : ",[";
+    out += std::to_string(page.index);
+    out += ',';
+    append_json_string(out, page.url);
+    out += fmt::format(",{},{}]", page.depth, static_cast<int>(page.status));
+  }
+
+  out += "],\"status\":[";
+  for(std::size_t i = 0; i < m_statuses.size(); ++i) {
+    auto const& [index, status] = m_statuses[i];
+    out += fmt::format("{}[{},{}]", i == 0 ? "" : ",", index, static_cast<int>(status));
+  }
+
+  out += "],\"links\":[";
+  for(std::size_t i = 0; i < m_links.size(); ++i) {
+    auto const& [from, to] = m_links[i];
+    out += fmt::format("{}[{},{}]", i == 0 ? "" : ",", from, to);
+  }
+  out += "]}";
+  return out;
+}
+
+LiveView::LiveView(Options options) :
+  m_options(std::move(options))
+{
+  m_listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+  if(m_listen_fd < 0) {
+    throw std::runtime_error("Failed to open a socket for the live view");
+  }
+
+  int reuse = 1;
+  setsockopt(m_listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(m_options.port);
+  if(inet_pton(AF_INET, m_options.address.c_str(), &address.sin_addr) != 1 ||
+     bind(m_listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+     listen(m_listen_fd, 16) != 0) {
+    std::string reason = std::strerror(errno);
+    close(m_listen_fd);
+    throw std::runtime_error(fmt::format("Failed to listen on {}:{}: {}", m_options.address, m_options.port, reason));
+  }
+
+  socklen_t length = sizeof(address);
+  getsockname(m_listen_fd, reinterpret_cast<sockaddr*>(&address), &length);
+  m_port = ntohs(address.sin_port);
+  set_nonblocking(m_listen_fd);
+
+  m_thread = std::thread([this]() { serve(); });
+}
+
+LiveView::~LiveView()
+{
+  m_stopping = true;
+  m_thread.join();
+  for(Client const& client : m_clients) {
+    close(client.fd);
+  }
+  close(m_listen_fd);
+}
+
+auto LiveView::url() const -> std::string
+{
+  return fmt::format("http://{}:{}/", m_options.address, m_port);
+}
+
+void LiveView::page_added(int index, std::string_view url, int depth)
+{
+  std::lock_guard lock(m_mutex);
+  m_pending.page(index, url, depth);
+}
+
+void LiveView::page_status(int index, PageStatus status)
+{
+  std::lock_guard lock(m_mutex);
+  m_pending.status(index, status);
+}
+
+void LiveView::link_added(int from, int to)
+{
+  std::lock_guard lock(m_mutex);
+  m_pending.link(from, to);
+}
+
+void LiveView::serve()
+{
+  // what is still unsent after stopping gets this long to go out
+  constexpr std::chrono::milliseconds linger{1000};
+
+  using Clock = std::chrono::steady_clock;
+  Clock::time_point next_flush = Clock::now() + m_options.interval;
+  std::optional<Clock::time_point> give_up;
+  std::vector<pollfd> fds;
+
+  while(true) {
+    if(m_stopping && !give_up) {
+      flush();
+      give_up = Clock::now() + linger;
+    }
+    if(give_up) {
+      bool done = std::none_of(m_clients.begin(), m_clients.end(), [](Client const& c) { return c.sent < c.out.size(); });
+      if(done || Clock::now() >= *give_up) {
+        return;
+      }
+    }
+
+    fds.clear();
+    fds.push_back(pollfd{.fd = m_listen_fd, .events = POLLIN});
+    for(Client const& client : m_clients) {
+      short events = client.closing ? 0 : POLLIN;
+      if(client.sent < client.out.size()) {
+        events |= POLLOUT;
+      }
+      fds.push_back(pollfd{.fd = client.fd, .events = events});
+    }
+
+    auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(next_flush - Clock::now());
+    if(give_up) {
+      wait = std::chrono::milliseconds{10};
+    }
+    poll(fds.data(), fds.size(), static_cast<int>(std::clamp<std::chrono::milliseconds::rep>(wait.count(), 0, 1000)));
+
+    for(std::size_t i = 0; i < m_clients.size(); ++i) {
+      short revents = fds[i + 1].revents;
+      if(revents & (POLLERR | POLLHUP | POLLNVAL)) {
+        drop(m_clients[i]);
+        continue;
+      }
+      if(revents & POLLIN) {
+        read_request(m_clients[i]);
+      }
+      if(revents & POLLOUT) {
+        write_out(m_clients[i]);
+      }
+    }
+    if(fds[0].revents & POLLIN && !give_up) {
+      accept_clients();
+    }
+
+    if(!give_up && Clock::now() >= next_flush) {
+      flush();
+      next_flush = Clock::now() + m_options.interval;
+    }
+
+    // closed, finished or hopelessly behind
+    std::erase_if(m_clients, [this](Client const& client) {
+      bool behind = client.out.size() - client.sent > m_options.max_backlog;
+      bool finished = client.closing && client.sent == client.out.size();
+      if(behind || finished) {
+        close(client.fd);
+        return true;
+      }
+      return false;
+    });
+    m_viewers = static_cast<std::size_t>(std::count_if(m_clients.begin(), m_clients.end(), [](Client const& c) { return c.streaming; }));
+  }
+}
+
+void LiveView::accept_clients()
+{
+  while(true) {
+    int fd = accept(m_listen_fd, nullptr, nullptr);
+    if(fd < 0) {
+      return;
+    }
+    set_nonblocking(fd);
+    m_clients.push_back(Client{.fd = fd});
+  }
+}
+
+void LiveView::read_request(Client& client)
+{
+  // a viewer has nothing more to say, and a client already answered nothing
+  // that matters. what they send is only read to notice they hung up
+  bool keep = !client.streaming && !client.closing;
+
+  char buffer[2048];
+  bool ended = false;
+  while(true) {
+    ssize_t received = recv(client.fd, buffer, sizeof(buffer), 0);
+    if(received > 0) {
+      if(keep) {
+        client.request.append(buffer, static_cast<std::size_t>(received));
+        if(client.request.size() > max_request) {
+          break; // the rest is not buffered
+        }
+      }
+      continue;
+    }
+    ended = received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+    break;
+  }
+
+  if(!keep) {
+    client.request.clear();
+    if(ended) {
+      drop(client);
+    }
+    return;
+  }
+
+  if(client.request.find("\r\n\r\n") != std::string::npos) {
+    respond(client);
+  } else if(ended) {
+    drop(client);
+  } else if(client.request.size() > max_request) {
+    client.out = plain_response(400, "text/plain", "request too large\n");
+    client.closing = true;
+  }
+}
+
+void LiveView::respond(Client& client)
+{
+  std::string_view request = client.request;
+  std::string_view line = request.substr(0, request.find("\r\n"));
+  std::size_t method_end = line.find(' ');
+  std::size_t path_end = line.find(' ', method_end + 1);
+  client.closing = true;
+
+  if(method_end == std::string_view::npos || path_end == std::string_view::npos) {
+    client.out = plain_response(400, "text/plain", "bad request\n");
+    return;
+  }
+  if(line.substr(0, method_end) != "GET") {
+    client.out = plain_response(405, "text/plain", "only GET is served\n");
+    return;
+  }
+
+  std::string_view path = line.substr(method_end + 1, path_end - method_end - 1);
+  path = path.substr(0, path.find('?'));
+
+  if(path == "/" || path == "/index.html") {
+    client.out = plain_response(200, "text/html; charset=utf-8", viewer_page);
+  } else if(path == "/events") {
+    // everything seen so far, then the batches as they come
+    client.out =
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type: text/event-stream\r\n"
+      "Cache-Control: no-cache\r\n"
+      "Connection: keep-alive\r\n"
+      "\r\n"
+      "retry: 1000\n"
+      "event: snapshot\n"
+      "data: ";
+    client.out += m_seen.to_json();
+    client.out += "\n\n";
+    client.streaming = true;
+    client.closing = false;
+  } else {
+    client.out = plain_response(404, "text/plain", "not found\n");
+  }
+  client.request.clear();
+  write_out(client);
+}
+
+void LiveView::write_out(Client& client)
+{
+  while(client.sent < client.out.size()) {
+    ssize_t written = send(client.fd, client.out.data() + client.sent, client.out.size() - client.sent, MSG_NOSIGNAL);
+    if(written > 0) {
+      client.sent += static_cast<std::size_t>(written);
+      continue;
+    }
+    if(written < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+      drop(client);
+    }
+    break;
+  }
+
+  // keep the buffer from growing with everything ever sent
+  if(client.sent == client.out.size()) {
+    client.out.clear();
+    client.sent = 0;
+  } else if(client.sent > client.out.size() / 2) {
+    client.out.erase(0, client.sent);
+    client.sent = 0;
+  }
+}
+
+void LiveView::drop(Client& client)
+{
+  client.closing = true;
+  client.streaming = false;
+  client.out.clear();
+  client.sent = 0;
+}
+
+void LiveView::flush()
+{
+  {
+    std::lock_guard lock(m_mutex);
+    if(m_pending.empty()) {
+      return;
+    }
+    std::swap(m_pending, m_batch); // the crawl gets the emptied buffer back, capacity and all
+  }
+
+  std::string event = "data: " + m_batch.to_json() + "\n\n";
+  m_seen.append(m_batch);
+  m_batch.clear();
+  ++m_batches;
+
+  for(Client& client : m_clients) {
+    if(client.streaming) {
+      client.out += event;
+      write_out(client);
+    }
+  }
+}
@@ -1,13 +1,98 @@
 #if 1
 #include <main.hpp>
 #include <program.hpp>
+#include <cstdint>
 #include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
 
-int main() {
+namespace {
+
+// a command line argument that is not what its mode expects
+struct BadArgument : std::runtime_error
+{
+  using std::runtime_error::runtime_error;
+};
+
+auto number(char const* text, int min = std::numeric_limits<int>::min(), int max = std::numeric_limits<int>::max()) -> int
+{
+  std::string argument = text;
+  std::size_t used = 0;
+  int value = 0;
+  try {
+    value = std::stoi(argument, &used);
+  }
+  catch(std::logic_error const&) { // not a number, or out of int range
+    throw BadArgument("not a number: " + argument);
+  }
+  if(used != argument.size()) {
+    throw BadArgument("not a number: " + argument);
+  }
+  if(value < min || value > max) {
+    throw BadArgument(argument + " is not within " + std::to_string(min) + ".." + std::to_string(max));
+  }
+  return value;
+}
+
+void print_usage(char const* name)
+{
+  std::cerr << "usage: " << name << " [shard <id> <count> <dir> <url> <depth> | merge <count> <dir> | "
+            << "record <archive> | replay <archive> <url> <depth> | rebuild <archive> [threads] | "
+            << "refresh <cache> <url> <depth> | live <port> <url> <depth>]" << std::endl;
+}
+
+} // namespace
+
+// usage:
+//   crawler_exe                                       interactive crawl
+//   crawler_exe shard <id> <count> <dir> <url> <depth> crawl one host shard
+//   crawler_exe merge <count> <dir>                   merge finished shards
+//   crawler_exe record <archive>                      interactive crawl, archiving every page
+//   crawler_exe replay <archive> <url> <depth>        crawl from an archive instead of the network
+//   crawler_exe rebuild <archive> [threads]           rebuild the graph of a whole archive
+//   crawler_exe refresh <cache> <url> <depth>         re-crawl, downloading only what changed
+//   crawler_exe live <port> <url> <depth>             crawl, drawing the graph live at http://127.0.0.1:<port>/
+int main(int argc, char** argv) {
 
   try {
     Program program{};
-    program.run();
+    std::string mode = argc > 1 ? argv[1] : "";
+
+    if(mode == "shard" && argc == 7) {
+      int count = number(argv[3], 1);
+      ShardConfig config{.id = number(argv[2], 0, count - 1), .count = count, .dir = argv[4]};
+      program.run_shard(config, argv[5], number(argv[6], 0));
+    } else if(mode == "merge" && argc == 4) {
+      ShardConfig config{.id = 0, .count = number(argv[2], 1), .dir = argv[3]};
+      program.run_merge(config);
+    } else if(mode == "record" && argc == 3) {
+      program.record_to(argv[2]);
+      program.run();
+    } else if(mode == "replay" && argc == 5) {
+      program.replay_from(argv[2]);
+      program.run(argv[3], number(argv[4], 0));
+    } else if(mode == "rebuild" && (argc == 3 || argc == 4)) {
+      int threads = argc == 4 ? number(argv[3], 1) : static_cast<int>(std::thread::hardware_concurrency());
+      program.run_rebuild(argv[2], threads);
+    } else if(mode == "refresh" && argc == 5) {
+      program.use_cache(argv[2]);
+      program.run(argv[3], number(argv[4], 0));
+    } else if(mode == "live" && argc == 5) {
+      program.serve_live(static_cast<std::uint16_t>(number(argv[2], 1, 65535)));
+      program.run(argv[3], number(argv[4], 0));
+    } else if(argc == 1) {
+      program.run();
+    } else {
+      print_usage(argv[0]);
+      return 1;
+    }
+  }
+  catch(BadArgument const& e) {
+    std::cerr << e.what() << std::endl;
+    print_usage(argv[0]);
+    return 1;
   }
   catch(std::runtime_error e) {
     std::cerr << "[Exception] " << e.what() << std::endl;
@@ -0,0 +1,168 @@
+#include <page_cache.hpp>
+//
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+auto trim(std::string_view text) -> std::string_view
+{
+  while(!text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) {
+    text.remove_prefix(1);
+  }
+  while(!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) {
+    text.remove_suffix(1);
+  }
+  return text;
+}
+
+auto iequals(std::string_view a, std::string_view b) -> bool
+{
+  return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+    return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+  });
+}
+
+// fields are tab separated, one record per line
+auto field(std::string_view value) -> std::string
+{
+  std::string out(value);
+  std::replace_if(out.begin(), out.end(), [](char c) { return c == '\t' || c == '\n' || c == '\r'; }, ' ');
+  return out;
+}
+
+auto split(std::string_view line, char separator) -> std::vector<std::string_view>
+{
+  std::vector<std::string_view> out;
+  while(true) {
+    auto end = line.find(separator);
+    out.push_back(line.substr(0, end));
+    if(end == std::string_view::npos) {
+      return out;
+    }
+    line.remove_prefix(end + 1);
+  }
+}
+
+} // namespace
+
+Validators parse_validators(std::string_view headers)
+{
+  Validators out;
+  while(!headers.empty()) {
+    auto end = headers.find('\n');
+    std::string_view line = headers.substr(0, end);
+    headers.remove_prefix(end == std::string_view::npos ? headers.size() : end + 1);
+
+    auto colon = line.find(':');
+    if(colon == std::string_view::npos) {
+      continue;
+    }
+
+    std::string_view name = trim(line.substr(0, colon));
+    if(iequals(name, "etag")) {
+      out.etag = trim(line.substr(colon + 1));
+    } else if(iequals(name, "last-modified")) {
+      out.last_modified = trim(line.substr(colon + 1));
+    }
+  }
+  return out;
+}
+
+PageCache::PageCache(std::filesystem::path path) :
+  m_path{std::move(path)}
+{
+  if(std::filesystem::exists(m_path)) {
+    load();
+  }
+}
+
+CachedPage const* PageCache::find(std::string const& url) const
+{
+  auto it = m_pages.find(url);
+  return it == m_pages.end() ? nullptr : &it->second;
+}
+
+void PageCache::store(std::string const& url, CachedPage page)
+{
+  m_pages.insert_or_assign(url, std::move(page));
+}
+
+void PageCache::save() const
+{
+  if(m_path.has_parent_path()) {
+    std::filesystem::create_directories(m_path.parent_path());
+  }
+
+  std::filesystem::path temporary = m_path;
+  temporary += ".tmp";
+  {
+    std::ofstream out(temporary, std::ios::trunc | std::ios::binary);
+    if(!out) {
+      throw std::runtime_error("Failed to write page cache " + temporary.string());
+    }
+
+    out << m_pages.size() << '\n';
+    for(auto const& [url, page] : m_pages) {
+      out << field(url) << '\t' << field(page.final_url) << '\t' << field(page.validators.etag) << '\t'
+          << field(page.validators.last_modified) << '\t' << page.content_hash << '\t' << page.fingerprint.exact << '\t'
+          << page.fingerprint.simhash << '\t' << page.fingerprint.words << '\t' << field(page.duplicate_of) << '\t'
+          << page.links.size() << '\n';
+      for(std::string const& link : page.links) {
+        out << field(link) << '\n';
+      }
+    }
+
+    if(!out) {
+      throw std::runtime_error("Failed to write page cache " + temporary.string());
+    }
+  }
+  std::filesystem::rename(temporary, m_path);
+}
+
+void PageCache::load()
+{
+  std::ifstream in(m_path, std::ios::binary);
+  if(!in) {
+    throw std::runtime_error("Failed to read page cache " + m_path.string());
+  }
+
+  std::string line;
+  std::getline(in, line);
+  std::size_t count = std::stoull(line.empty() ? "0" : line);
+  m_pages.reserve(count);
+
+  for(std::size_t i = 0; i < count; ++i) {
+    if(!std::getline(in, line)) {
+      throw std::runtime_error("Corrupt page cache " + m_path.string());
+    }
+
+    std::vector<std::string_view> fields = split(line, '\t');
+    if(fields.size() != 10) {
+      throw std::runtime_error("Corrupt page cache " + m_path.string());
+    }
+
+    CachedPage page{
+      .final_url = std::string(fields[1]),
+      .validators = {.etag = std::string(fields[2]), .last_modified = std::string(fields[3])},
+      .content_hash = std::stoull(std::string(fields[4])),
+      .fingerprint = {
+        .exact = std::stoull(std::string(fields[5])),
+        .simhash = std::stoull(std::string(fields[6])),
+        .words = std::stoull(std::string(fields[7])),
+      },
+      .duplicate_of = std::string(fields[8]),
+    };
+    std::size_t links = std::stoull(std::string(fields[9]));
+    page.links.resize(links);
+    for(std::string& link : page.links) {
+      if(!std::getline(in, link)) {
+        throw std::runtime_error("Corrupt page cache " + m_path.string());
+      }
+    }
+
+    m_pages.insert_or_assign(std::string(fields[0]), std::move(page));
+  }
+}
@@ -0,0 +1,126 @@
+#include <page_graph.hpp>
+//
+#include <algorithm>
+#include <stdexcept>
+
+auto PageGraph::add_node(std::string const& url, int depth) -> Index
+{
+  auto [index, inserted] = m_urls.insert(url);
+  grow(index + 1); // may be interned but not committed yet
+  if(inserted) {
+    m_nodes[index].set_depth(depth);
+  }
+
+  return index;
+}
+
+auto PageGraph::get_index(std::string const& url) const -> Index
+{
+  std::optional<Index> index = m_urls.find(url);
+  if(!index) {
+    throw std::out_of_range("PageGraph::get_index: unknown url " + url);
+  }
+  return *index;
+}
+
+auto PageGraph::intern(std::string_view url, int depth, EdgeBuffer& buffer) -> Index
+{
+  auto [index, inserted] = m_urls.insert(url);
+  if(inserted) {
+    buffer.node(index, depth);
+  }
+  return index;
+}
+
+void PageGraph::commit(EdgeBuffer& buffer)
+{
+  std::lock_guard lock(m_commit);
+
+  for(auto const& [index, depth] : buffer.m_nodes) {
+    grow(index + 1);
+    m_nodes[index].set_depth(depth);
+  }
+
+  // grouped by page, so each list grows once
+  std::stable_sort(buffer.m_edges.begin(), buffer.m_edges.end(), [](auto const& a, auto const& b) { return a.first < b.first; });
+  for(std::size_t i = 0; i < buffer.m_edges.size();) {
+    Index from = buffer.m_edges[i].first;
+    std::size_t end = i;
+    while(end < buffer.m_edges.size() && buffer.m_edges[end].first == from) {
+      ++end;
+    }
+
+    grow(from + 1);
+    PageNode& node = m_nodes[from];
+    node.reserve(node.children().size() + (end - i));
+    for(; i < end; ++i) {
+      grow(buffer.m_edges[i].second + 1);
+      node.add_link(buffer.m_edges[i].second);
+    }
+  }
+
+  buffer.clear();
+}
+
+void PageGraph::grow(std::size_t size)
+{
+  while(m_nodes.size() < size) {
+    m_nodes.emplace_back(static_cast<Index>(m_nodes.size()), 0);
+  }
+}
+
+void PageGraph::merge(Index duplicate, Index original)
+{
+  get_node(duplicate).merge_into(original);
+  m_urls.assign(get_url(duplicate), original);
+}
+
+auto PageGraph::resolve_node(Index index) const -> Index
+{
+  while(m_nodes.at(index).duplicate_of() >= 0) {
+    index = m_nodes.at(index).duplicate_of();
+  }
+  return index;
+}
+
+ShardGraph PageGraph::export_graph() const
+{
+  ShardGraph out;
+  out.urls.reserve(m_nodes.size());
+  out.depths.reserve(m_nodes.size());
+
+  for(PageNode const& node : m_nodes) {
+    out.urls.push_back(get_url(node.index()));
+    out.depths.push_back(node.depth());
+    for(int child : node.children()) {
+      out.edges.emplace_back(resolve_node(node.index()), resolve_node(child));
+    }
+    if(node.duplicate_of() >= 0) {
+      out.merged.emplace_back(node.index(), resolve_node(node.index()));
+    }
+  }
+
+  return out;
+}
+
+void PageGraph::load_graph(ShardGraph const& graph)
+{
+  clear();
+
+  for(std::size_t i = 0; i < graph.urls.size(); ++i) {
+    add_node(graph.urls[i], graph.depths[i]);
+  }
+  for(auto const& [duplicate, original] : graph.merged) {
+    merge(duplicate, original);
+  }
+
+  for(auto const& [from, to] : graph.edges) {
+    get_node(from).add_link(to);
+  }
+}
+
+void PageGraph::clear()
+{
+  m_nodes.clear();
+  m_urls.clear();
+}
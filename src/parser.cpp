@@ -0,0 +1,93 @@
+#include <parser.hpp>
+//
+#include <stdexcept>
+//
+#include <lexbor/dom/interfaces/character_data.h>
+#include <lexbor/dom/interfaces/element.h>
+#include <lexbor/dom/interfaces/node.h>
+#include <lexbor/tag/const.h>
+//
+#include <url.hpp>
+
+PageParser::PageParser(Canonicalizer const& canonicalizer) :
+  m_canonicalizer{&canonicalizer}
+{
+  m_doc = lxb_html_document_create();
+  if(!m_doc) {
+    throw std::runtime_error("Failed to create the page parser.");
+  }
+}
+
+PageParser::~PageParser()
+{
+  lxb_html_document_destroy(m_doc);
+}
+
+void PageParser::parse(std::string_view base_url, std::string_view content, LinkBuffer& out)
+{
+  out.clear();
+  m_base_url.assign(base_url);
+  m_simhash.clear();
+  m_fingerprint = ContentFingerprint{.exact = fnv1a64(content)};
+
+  lxb_html_document_clean(m_doc);
+  auto parse_result = lxb_html_document_parse(m_doc, reinterpret_cast<const lxb_char_t*>(content.data()), content.size());
+  if(parse_result != LXB_STATUS_OK) {
+    throw std::runtime_error("Failed to parse " + m_base_url + ". lxb_html_document_parse() error.");
+  }
+
+  auto* body = lxb_html_document_body_element(m_doc);
+  if(body == nullptr) {
+    throw std::runtime_error("Failed to parse " + m_base_url + ". lxb_html_document_body_element() error.");
+  }
+
+  extract_links_rec(lxb_dom_interface_node(body), out);
+  m_fingerprint.simhash = m_simhash.value();
+  m_fingerprint.words = m_simhash.words();
+}
+
+void PageParser::extract_links_rec(lxb_dom_node_t* node, LinkBuffer& out, bool visible)
+{
+  for(lxb_dom_node_t* child = node->first_child; child; child = child->next) {
+    // visible text goes into the simhash
+    if(child->type == LXB_DOM_NODE_TYPE_TEXT) {
+      if(!visible) {
+        continue;
+      }
+      lexbor_str_t const& text = lxb_dom_interface_character_data(child)->data;
+      m_simhash.add_text(std::string_view(reinterpret_cast<const char*>(text.data), text.length));
+      continue;
+    }
+
+    bool child_visible = visible;
+    if(child->type == LXB_DOM_NODE_TYPE_ELEMENT) {
+      auto* el = lxb_dom_interface_element(child);
+      auto tag = lxb_dom_element_tag_id(el);
+      if(tag == LXB_TAG_SCRIPT || tag == LXB_TAG_STYLE || tag == LXB_TAG_NOSCRIPT || tag == LXB_TAG_TEMPLATE) {
+        child_visible = false;
+      }
+      if(tag == LXB_TAG_A) {
+        if(auto* attr = lxb_dom_element_attr_by_name(
+             el, (const lxb_char_t*)"href", 4)) {
+          if(auto* href = lxb_dom_attr_value(attr, nullptr)) {
+            if(auto fingerprint = resolve((const char*)href, out.next())) {
+              out.commit(fingerprint.value());
+            }
+          }
+        }
+      }
+    }
+    extract_links_rec(child, out, child_visible);
+  }
+}
+
+std::optional<std::uint64_t> PageParser::resolve(const char* href, std::string& out)
+{
+  // no curl url handle here: it allocates on every set and get
+  if(!resolve_reference(m_base_url, href, m_resolved)) {
+    return std::nullopt;
+  }
+
+  // canonicalized straight into the link buffer
+  return m_canonicalizer->canonicalize(m_resolved, out);
+}
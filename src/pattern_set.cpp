@@ -0,0 +1,499 @@
+#include <pattern_set.hpp>
+//
+#include <algorithm>
+#include <bitset>
+#include <map>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+using ByteSet = std::bitset<256>;
+
+constexpr std::size_t max_nfa_states = 100000; // {m,n} nesting multiplies quickly
+
+struct Node
+{
+  enum class Kind { bytes, concat, alternate, repeat, begin, end };
+
+  Kind kind = Kind::concat;
+  ByteSet bytes;
+  std::vector<Node> children;
+  int min = 0;
+  int max = -1; // -1 is unbounded
+};
+
+auto range(char from, char to) -> ByteSet
+{
+  ByteSet out;
+  for(int c = static_cast<unsigned char>(from); c <= static_cast<unsigned char>(to); ++c) {
+    out.set(static_cast<std::size_t>(c));
+  }
+  return out;
+}
+
+auto single(char c) -> ByteSet
+{
+  return range(c, c);
+}
+
+// recursive descent over the supported subset, into a tree of Nodes
+class Parser
+{
+public:
+  explicit Parser(std::string_view pattern) : m_pattern(pattern) {}
+
+  auto parse() -> Node
+  {
+    Node node = alternation();
+    if(m_at < m_pattern.size()) {
+      fail("unbalanced ')'");
+    }
+    return node;
+  }
+
+private:
+  [[noreturn]] void fail(std::string const& what) const
+  {
+    throw std::runtime_error("pattern '" + std::string(m_pattern) + "' at " + std::to_string(m_at) + ": " + what);
+  }
+
+  auto done() const -> bool { return m_at >= m_pattern.size(); }
+  auto peek() const -> char { return m_pattern[m_at]; }
+
+  auto alternation() -> Node
+  {
+    Node node{.kind = Node::Kind::alternate};
+    node.children.push_back(sequence());
+    while(!done() && peek() == '|') {
+      ++m_at;
+      node.children.push_back(sequence());
+    }
+    if(node.children.size() == 1) {
+      return std::move(node.children.front());
+    }
+    return node;
+  }
+
+  auto sequence() -> Node
+  {
+    Node node{.kind = Node::Kind::concat};
+    while(!done() && peek() != '|' && peek() != ')') {
+      node.children.push_back(quantified(atom()));
+    }
+    return node;
+  }
+
+  auto quantified(Node atom) -> Node
+  {
+    while(!done()) {
+      int min = 0;
+      int max = -1;
+      char c = peek();
+      if(c == '*') {
+        ++m_at;
+      } else if(c == '+') {
+        min = 1;
+        ++m_at;
+      } else if(c == '?') {
+        max = 1;
+        ++m_at;
+      } else if(c == '{') {
+        ++m_at;
+        min = number();
+        max = min;
+        if(!done() && peek() == ',') {
+          ++m_at;
+          max = !done() && peek() == '}' ? -1 : number();
+        }
+        if(done() || peek() != '}') {
+          fail("malformed {m,n}");
+        }
+        ++m_at;
+        if((max != -1 && max < min) || min > PatternSet::max_repeat || max > PatternSet::max_repeat) {
+          fail("bad repeat bounds");
+        }
+      } else {
+        break;
+      }
+      if(!done() && peek() == '?') {
+        ++m_at; // lazy matches the same set of texts
+      }
+      if(atom.kind == Node::Kind::begin || atom.kind == Node::Kind::end) {
+        fail("quantified anchor");
+      }
+      Node repeat{.kind = Node::Kind::repeat, .min = min, .max = max};
+      repeat.children.push_back(std::move(atom));
+      atom = std::move(repeat);
+    }
+    return atom;
+  }
+
+  auto number() -> int
+  {
+    int value = 0;
+    std::size_t start = m_at;
+    while(!done() && peek() >= '0' && peek() <= '9' && value <= PatternSet::max_repeat) {
+      value = value * 10 + (peek() - '0');
+      ++m_at;
+    }
+    if(m_at == start) {
+      fail("malformed {m,n}");
+    }
+    return value;
+  }
+
+  auto atom() -> Node
+  {
+    char c = peek();
+    ++m_at;
+    switch(c) {
+    case '(': {
+      if(!done() && peek() == '?') {
+        if(m_at + 1 < m_pattern.size() && m_pattern[m_at + 1] == ':') {
+          m_at += 2;
+        } else {
+          fail("lookarounds and named groups are not supported");
+        }
+      }
+      Node inside = alternation();
+      if(done() || peek() != ')') {
+        fail("missing ')'");
+      }
+      ++m_at;
+      return inside;
+    }
+    case '^':
+      return Node{.kind = Node::Kind::begin};
+    case '$':
+      return Node{.kind = Node::Kind::end};
+    case '.':
+      return Node{.kind = Node::Kind::bytes, .bytes = ~(single('\n') | single('\r'))};
+    case '[':
+      return Node{.kind = Node::Kind::bytes, .bytes = bracket()};
+    case '\\':
+      return Node{.kind = Node::Kind::bytes, .bytes = escape()};
+    case '*':
+    case '+':
+    case '?':
+    case '{':
+      fail("nothing to repeat");
+    default:
+      return Node{.kind = Node::Kind::bytes, .bytes = single(c)};
+    }
+  }
+
+  auto escape() -> ByteSet
+  {
+    if(done()) {
+      fail("trailing '\\'");
+    }
+    char c = peek();
+    ++m_at;
+    ByteSet word = range('a', 'z') | range('A', 'Z') | range('0', '9') | single('_');
+    ByteSet space = single(' ') | range('\t', '\r');
+    switch(c) {
+    case 'd': return range('0', '9');
+    case 'D': return ~range('0', '9');
+    case 'w': return word;
+    case 'W': return ~word;
+    case 's': return space;
+    case 'S': return ~space;
+    case 'n': return single('\n');
+    case 'r': return single('\r');
+    case 't': return single('\t');
+    case 'f': return single('\f');
+    case 'v': return single('\v');
+    default:
+      break;
+    }
+    bool alnum = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+    if(alnum) {
+      fail(std::string("unsupported escape \\") + c);
+    }
+    return single(c);
+  }
+
+  // one member of a [class], a byte or a \d like set
+  auto member(bool& is_byte) -> ByteSet
+  {
+    if(done()) {
+      fail("missing ']'");
+    }
+    char c = peek();
+    ++m_at;
+    if(c != '\\') {
+      is_byte = true;
+      return single(c);
+    }
+    ByteSet set = escape();
+    is_byte = set.count() == 1;
+    return set;
+  }
+
+  auto bracket() -> ByteSet
+  {
+    bool negated = !done() && peek() == '^';
+    if(negated) {
+      ++m_at;
+    }
+    ByteSet out;
+    while(done() || peek() != ']') {
+      bool is_byte = false;
+      ByteSet first = member(is_byte);
+      bool ranged = is_byte && m_at + 1 < m_pattern.size() && peek() == '-' && m_pattern[m_at + 1] != ']';
+      if(!ranged) {
+        out |= first;
+        continue;
+      }
+      ++m_at;
+      bool last_is_byte = false;
+      ByteSet last = member(last_is_byte);
+      if(!last_is_byte) {
+        fail("bad range in class");
+      }
+      std::size_t from = 0;
+      std::size_t to = 0;
+      while(!first.test(from)) {
+        ++from;
+      }
+      while(!last.test(to)) {
+        ++to;
+      }
+      if(to < from) {
+        fail("bad range in class");
+      }
+      for(std::size_t c = from; c <= to; ++c) {
+        out.set(c);
+      }
+    }
+    ++m_at;
+    return negated ? ~out : out;
+  }
+
+  std::string_view m_pattern;
+  std::size_t m_at = 0;
+};
+
+// Thompson NFA, built back to front so every fragment knows where it goes
+struct Nfa
+{
+  enum class Kind { bytes, split, begin, end, match };
+
+  struct State
+  {
+    Kind kind;
+    ByteSet bytes;
+    int out = -1;
+    int out2 = -1;
+  };
+
+  auto add(State state) -> int
+  {
+    if(states.size() >= max_nfa_states) {
+      throw std::runtime_error("pattern repeats too much");
+    }
+    states.push_back(state);
+    return static_cast<int>(states.size()) - 1;
+  }
+
+  // the entry of {node}, continuing at {next} once it matched
+  auto compile(Node const& node, int next) -> int
+  {
+    switch(node.kind) {
+    case Node::Kind::bytes:
+      return add({.kind = Kind::bytes, .bytes = node.bytes, .out = next});
+    case Node::Kind::begin:
+      return add({.kind = Kind::begin, .out = next});
+    case Node::Kind::end:
+      return add({.kind = Kind::end, .out = next});
+    case Node::Kind::concat:
+      for(auto child = node.children.rbegin(); child != node.children.rend(); ++child) {
+        next = compile(*child, next);
+      }
+      return next;
+    case Node::Kind::alternate: {
+      int entry = compile(node.children.back(), next);
+      for(auto child = node.children.rbegin() + 1; child != node.children.rend(); ++child) {
+        entry = add({.kind = Kind::split, .out = compile(*child, next), .out2 = entry});
+      }
+      return entry;
+    }
+    case Node::Kind::repeat:
+      return repeat(node.children.front(), node.min, node.max, next);
+    }
+    return next;
+  }
+
+  auto repeat(Node const& body, int min, int max, int next) -> int
+  {
+    // the optional tail first: x* or up to max - min nested x?
+    if(max == -1) {
+      int loop = add({.kind = Kind::split, .out2 = next});
+      states[static_cast<std::size_t>(loop)].out = compile(body, loop);
+      next = loop;
+    } else {
+      for(int i = min; i < max; ++i) {
+        int entry = compile(body, next);
+        next = add({.kind = Kind::split, .out = entry, .out2 = next});
+      }
+    }
+    for(int i = 0; i < min; ++i) {
+      next = compile(body, next);
+    }
+    return next;
+  }
+
+  // states reachable from {from} without reading a byte; begin assertions
+  // only hold before the first byte, end assertions are left in the set
+  void closure(std::vector<int> from, bool at_begin, bool through_end, std::vector<char>& seen, std::vector<int>& out) const
+  {
+    while(!from.empty()) {
+      int index = from.back();
+      from.pop_back();
+      if(index < 0 || seen[static_cast<std::size_t>(index)]) {
+        continue;
+      }
+      seen[static_cast<std::size_t>(index)] = 1;
+      State const& state = states[static_cast<std::size_t>(index)];
+      switch(state.kind) {
+      case Kind::split:
+        from.push_back(state.out2);
+        from.push_back(state.out);
+        break;
+      case Kind::begin:
+        if(at_begin) {
+          from.push_back(state.out);
+        }
+        break;
+      case Kind::end:
+        out.push_back(index);
+        if(through_end) {
+          from.push_back(state.out);
+        }
+        break;
+      default:
+        out.push_back(index);
+        break;
+      }
+    }
+  }
+
+  std::vector<State> states;
+};
+
+} // namespace
+
+void PatternSet::add(std::string_view pattern)
+{
+  // parse it alone first, so a bad pattern leaves the set untouched
+  Parser(pattern).parse();
+
+  std::vector<std::string> patterns = m_patterns;
+  patterns.emplace_back(pattern);
+
+  Nfa nfa;
+  int match = nfa.add({.kind = Nfa::Kind::match});
+  int entry = -1;
+  for(std::string const& each : patterns) {
+    int start = nfa.compile(Parser(each).parse(), match);
+    entry = entry == -1 ? start : nfa.add({.kind = Nfa::Kind::split, .out = start, .out2 = entry});
+  }
+  // unanchored: any prefix may be skipped before a pattern starts
+  int skip = nfa.add({.kind = Nfa::Kind::bytes, .bytes = ByteSet().set()});
+  int root = nfa.add({.kind = Nfa::Kind::split, .out = entry, .out2 = skip});
+  nfa.states[static_cast<std::size_t>(skip)].out = root;
+
+  std::vector<std::uint32_t> next;
+  std::vector<std::uint8_t> accepts;
+  std::vector<std::uint8_t> accepts_at_end;
+  std::map<std::vector<int>, std::uint32_t> ids;
+  std::vector<std::vector<int>> sets;
+  std::vector<char> seen(nfa.states.size());
+
+  auto intern = [&](std::vector<int> set) -> std::uint32_t {
+    std::sort(set.begin(), set.end());
+    auto [found, added] = ids.emplace(set, static_cast<std::uint32_t>(sets.size()));
+    if(!added) {
+      return found->second;
+    }
+    if(sets.size() >= max_states) {
+      throw std::runtime_error("pattern '" + std::string(pattern) + "' makes the pattern set too large");
+    }
+    bool matched = false;
+    bool matched_at_end = false;
+    std::vector<int> ends;
+    for(int index : set) {
+      Nfa::Kind kind = nfa.states[static_cast<std::size_t>(index)].kind;
+      matched = matched || kind == Nfa::Kind::match;
+      if(kind == Nfa::Kind::end) {
+        ends.push_back(index);
+      }
+    }
+    if(!ends.empty()) {
+      std::fill(seen.begin(), seen.end(), 0);
+      std::vector<int> reached;
+      nfa.closure(ends, false, true, seen, reached);
+      for(int index : reached) {
+        matched_at_end = matched_at_end || nfa.states[static_cast<std::size_t>(index)].kind == Nfa::Kind::match;
+      }
+    }
+    accepts.push_back(matched);
+    accepts_at_end.push_back(matched || matched_at_end);
+    sets.push_back(std::move(set));
+    return found->second;
+  };
+
+  std::vector<int> start;
+  nfa.closure({root}, true, false, seen, start);
+  intern(std::move(start));
+
+  // subset construction, one state at a time in the order they appear
+  for(std::size_t state = 0; state < sets.size(); ++state) {
+    next.resize((state + 1) * 256);
+    if(accepts[state]) {
+      continue; // search() stops here, no need for its edges
+    }
+    std::map<std::vector<int>, std::vector<std::size_t>> targets;
+    std::vector<int> moved;
+    for(std::size_t byte = 0; byte < 256; ++byte) {
+      moved.clear();
+      for(int index : sets[state]) {
+        Nfa::State const& from = nfa.states[static_cast<std::size_t>(index)];
+        if(from.kind == Nfa::Kind::bytes && from.bytes.test(byte)) {
+          moved.push_back(from.out);
+        }
+      }
+      targets[moved].push_back(byte);
+    }
+    for(auto const& [moved_to, bytes] : targets) {
+      std::fill(seen.begin(), seen.end(), 0);
+      std::vector<int> set;
+      nfa.closure(moved_to, false, false, seen, set);
+      std::uint32_t id = intern(std::move(set));
+      for(std::size_t byte : bytes) {
+        next[state * 256 + byte] = id;
+      }
+    }
+  }
+
+  m_patterns = std::move(patterns);
+  m_next = std::move(next);
+  m_accepts = std::move(accepts);
+  m_accepts_at_end = std::move(accepts_at_end);
+}
+
+auto PatternSet::search(std::string_view text) const -> bool
+{
+  if(m_accepts.empty()) {
+    return false;
+  }
+  std::uint32_t state = 0;
+  for(char c : text) {
+    if(m_accepts[state]) {
+      return true;
+    }
+    state = m_next[state * 256 + static_cast<unsigned char>(c)];
+  }
+  return m_accepts_at_end[state] != 0;
+}
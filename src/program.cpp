@@ -6,7 +6,6 @@
 #include <iostream>
 #include <limits>
 #include <filesystem>
-#include <thread>
 #include <unordered_set>
 //
 #include <ogdf/basic/Graph.h>
@@ -20,207 +19,17 @@
 #include <fmt/color.h>
 #include <fmt/core.h>
 //
-
-size_t Program::write_callback(char* ptr, size_t size, size_t nmemb, void* userdata)
-{
-  std::string* buffer = static_cast<std::string*>(userdata);
-  size_t total_size = size * nmemb; // size * number_of_bytes
-  buffer->append(ptr, total_size);  // append exactly total_size bytes from ptr
-  return total_size;
-}
+#include <cluster.hpp>
+#include <url.hpp>
 
 Program::Program()
 {
-  curl_global_init(CURL_GLOBAL_DEFAULT);
-  m_multi_handle = curl_multi_init();
+  // a duplicate request once a page runs past what its host usually takes
+  m_crawler.fetcher().set_hedging(true);
 }
 
 Program::~Program()
 {
-  curl_multi_cleanup(m_multi_handle);
-  curl_global_cleanup();
-}
-
-Program::Response Program::request_html(std::string const& url)
-{
-  CURL* easy = curl_easy_init();
-  if(!easy) {
-    throw std::runtime_error("Failed to init curl for " + url);
-  }
-
-  auto clean = [&]() {
-    curl_multi_remove_handle(m_multi_handle, easy);
-    curl_easy_cleanup(easy);
-  };
-
-  std::string response;
-
-  curl_easy_setopt(easy, CURLOPT_URL, url.c_str());
-  curl_easy_setopt(easy, CURLOPT_VERBOSE, 0L);
-  curl_easy_setopt(easy, CURLOPT_TIMEOUT, 10L);       // max 10 seconds per request
-  curl_easy_setopt(easy, CURLOPT_CONNECTTIMEOUT, 5L); // max 5 seconds to connect
-  curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, Program::write_callback);
-  curl_easy_setopt(easy, CURLOPT_WRITEDATA, &response);
-  curl_easy_setopt(easy, CURLOPT_FOLLOWLOCATION, 1L);
-  curl_easy_setopt(easy, CURLOPT_USERAGENT, "Mozilla/5.0");
-
-  curl_multi_add_handle(m_multi_handle, easy);
-
-  int still_running = 0;
-  curl_multi_perform(m_multi_handle, &still_running);
-
-  while(still_running) {
-    int numfds = 0;
-    CURLMcode mc = curl_multi_wait(m_multi_handle, nullptr, 0, 1000, &numfds);
-    if(mc != CURLM_OK) {
-      clean();
-      throw std::runtime_error("curl_multi_wait error");
-    }
-    curl_multi_perform(m_multi_handle, &still_running);
-  }
-
-  long response_code = 0;
-  curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &response_code);
-  if(response_code >= 400) {
-    clean();
-    throw std::runtime_error("HTTP error " + std::to_string(response_code) + " for " + url);
-  }
-
-  std::string final_url;
-  char* eff_url_char;
-  curl_easy_getinfo(easy, CURLINFO_EFFECTIVE_URL, &eff_url_char);
-
-  if(!eff_url_char) {
-    clean();
-    throw std::runtime_error("Failed to get effective_url requesting html.");
-  }
-
-  final_url = normalize_url(std::string(eff_url_char));
-  clean();
-  return std::make_pair(final_url, response);
-}
-
-void Program::crawl_page(std::string const& url, int depth)
-{
-  std::optional<std::string> effective_url = get_effective_url(url);
-  if(!effective_url) {
-    throw std::runtime_error("Failed to get effective url in crawl_page.");
-  }
-
-  // builds root node and crawls {depth} times
-  int index = add_node(effective_url.value(), depth);
-  crawl_page_rec(get_node(index), depth);
-}
-
-std::optional<std::string> Program::get_effective_url(std::string const& url)
-{
-  CURL* curl = curl_easy_init();
-  if(!curl) {
-    return std::nullopt;
-  }
-
-  curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
-  curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-  curl_easy_setopt(curl, CURLOPT_VERBOSE, 0L);
-  curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-  curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);        // max 10 seconds per request
-  curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 15L); // max 5 seconds to connect
-
-  CURLcode res = curl_easy_perform(curl);
-  char* effective_url = nullptr;
-  if(res != CURLE_OK) {
-    fmt::print(stderr, fg(fmt::color::red), "❌ curl failed: {}\n", curl_easy_strerror(res));
-    curl_easy_cleanup(curl);
-    return std::nullopt;
-  }
-  curl_easy_getinfo(curl, CURLINFO_EFFECTIVE_URL, &effective_url);
-  if(effective_url) {
-    std::string final_url = effective_url;
-    if(!is_valid_url(final_url)) {
-      throw std::runtime_error("invalid final url for " + url + ": " + final_url);
-    }
-
-    curl_easy_cleanup(curl);
-    return std::make_optional(final_url);
-  }
-  return std::nullopt;
-}
-
-std::optional<PageNode::Index> Program::crawl_page_rec(PageNode& page, int depth)
-{
-  URL const& url = get_url(page.index());
-
-  // we've gone far enough
-  if(depth == 0) {
-    return std::nullopt;
-  }
-
-  fmt::print(fg(fmt::color::cyan) | fmt::emphasis::bold,
-    "\n🔍 Crawling (depth {}) → {}\n", depth, url);
-
-  std::string final_url{}, content{};
-
-  try {
-    // politely wait
-    std::this_thread::sleep_for(std::chrono::milliseconds(300)); // ~3 requests per second
-    std::tie(final_url, content) = request_html(url);
-  }
-  catch(const std::exception& e) {
-    fmt::print(fg(fmt::color::red), "❌ Error fetching {}: {}\n", url, e.what());
-    return std::nullopt;
-  }
-
-  // Building blocks
-  std::unordered_set<URL> children = parse_url(final_url, content);
-  get_node(page.index()).reserve(children.size());
-
-  fmt::print(fg(fmt::color::green), "   ↳ Found {} links\n", children.size());
-
-  // children
-  int ended = 0;
-  int added = 0;
-  int duplicates = 0;
-  int linked = 0;
-
-  for(URL const& child_url : children) {
-    // avoids crawling the same page twice
-    if(exists(child_url)) {
-      page.add_link(get_index(child_url));
-      ++linked;
-      ++duplicates;
-      continue;
-    }
-
-    int child_index = add_node(child_url, depth);
-    page.add_link(child_index);
-    ++added;
-    ++linked;
-
-    auto maybe_index = crawl_page_rec(get_node(child_index), depth - 1);
-    if(!maybe_index) {
-      ++ended;
-    }
-  }
-
-  fmt::print(fg(fmt::color::medium_sea_green), "   🕷️ Crawled → {}\n", url);
-
-  if(added > 0) {
-    fmt::print(fg(fmt::color::blue), "      ➕ Added {} new nodes\n", added);
-  }
-
-  if(ended > 0) {
-    fmt::print(fg(fmt::color::light_gray), "      ⏹️  {} branches ended at this depth\n", ended);
-  }
-
-  if(duplicates > 0) {
-    fmt::print(fg(fmt::color::light_gray), "      ♻️  {} duplicates skipped\n", duplicates);
-  }
-
-  if(linked > 0) {
-    fmt::print(fg(fmt::color::light_gray), "      🔗  {} nodes linked\n", linked);
-  }
-
-  return page.index();
 }
 
 void Program::print_header()
@@ -276,6 +85,44 @@ int Program::request_depth()
   return depth;
 }
 
+void Program::request_budget()
+{
+  long long pages = -1;
+
+  while(true) {
+    fmt::print(fmt::fg(fmt::color::cyan), "💰 Max pages to fetch (0 for no limit): ");
+    std::cin >> pages;
+
+    if(std::cin.fail() || pages < 0) {
+      std::cin.clear();
+      std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+      fmt::print(fmt::fg(fmt::color::red), "❌ Invalid input. Must be a non-negative integer.\n");
+    } else {
+      break;
+    }
+  }
+
+  if(pages > 0) {
+    m_crawler.budget().max_pages = static_cast<std::size_t>(pages);
+  }
+}
+
+void Program::request_scope(std::string const& root_url)
+{
+  std::string host(url_host(m_crawler.normalize_url(root_url)));
+  if(host.empty()) {
+    return;
+  }
+
+  std::string answer;
+  fmt::print(fmt::fg(fmt::color::cyan), "🧭 Stay on {} and its subdomains? [y/N]: ", host);
+  std::cin >> answer;
+
+  if(!answer.empty() && (answer[0] == 'y' || answer[0] == 'Y')) {
+    m_crawler.scope().allow_host(host);
+  }
+}
+
 std::optional<std::string> Program::resolve_url(const std::string& base_url,
   const std::string& href)
 {
@@ -307,30 +154,6 @@ std::optional<std::string> Program::resolve_url(const std::string& base_url,
   return out;
 }
 
-void Program::extract_links_rec(lxb_dom_node_t* node,
-  std::unordered_set<URL>& out, std::string const& base_url)
-{
-  for(lxb_dom_node_t* child = node->first_child; child; child = child->next) {
-    if(child->type == LXB_DOM_NODE_TYPE_ELEMENT) {
-      auto* el = lxb_dom_interface_element(child);
-      const lxb_char_t* tag = lxb_dom_element_qualified_name(el, nullptr);
-      if(tag && strcmp((const char*)tag, "a") == 0) {
-        if(auto* attr = lxb_dom_element_attr_by_name(
-             el, (const lxb_char_t*)"href", 4)) {
-          if(auto* href = lxb_dom_attr_value(attr, nullptr)) {
-            std::string raw((const char*)href);
-            std::optional<Program::URL> url = resolve_url(base_url, raw);
-            if(url) {
-              out.insert(normalize_url(url.value()));
-            }
-          }
-        }
-      }
-    }
-    extract_links_rec(child, out, base_url);
-  }
-}
-
 bool Program::is_valid_url(std::string url)
 {
   CURLU* h = curl_url();
@@ -353,80 +176,18 @@ bool Program::is_valid_url(std::string url)
   return is_http;
 }
 
-std::string Program::normalize_url(std::string_view url)
-{
-  std::string result(url);
-
-  // Remove fragment
-  auto hash_pos = result.find('#');
-  if(hash_pos != std::string::npos)
-    result.erase(hash_pos);
-
-  // Remove query
-  auto query_pos = result.find('?');
-  if(query_pos != std::string::npos)
-    result.erase(query_pos);
-
-  // Optional: remove trailing slash (careful!)
-  if(result.size() > 1 && result.back() == '/')
-    result.pop_back();
-
-  return result;
-}
-
 std::unordered_set<Program::URL> Program::parse_url(std::string url, std::string const& content)
 {
-  std::unordered_set<URL> pages;
-  std::string error_message = "Failed to parse " + url + ". ";
+  // one parser per thread, recycled between calls
+  thread_local PageParser parser;
+  thread_local LinkBuffer links;
 
-  auto* doc = lxb_html_document_create();
-  if(!doc) {
-    throw std::runtime_error(error_message + "lxb_html_document_create() error.");
-  }
-
-  auto parse_result = lxb_html_document_parse(doc, reinterpret_cast<const lxb_char_t*>(content.c_str()), content.size());
-  if(parse_result != LXB_STATUS_OK) {
-    lxb_html_document_destroy(doc);
-    throw std::runtime_error(error_message + "lxb_html_document_parse() error.");
-  }
-
-  auto* body = lxb_html_document_body_element(doc);
-  if(body == nullptr) {
-    throw std::runtime_error(error_message + "lxb_html_document_parse() error.");
-  }
-
-  extract_links_rec(lxb_dom_interface_node(body), pages, url);
-  if(pages.empty()) {
+  parser.parse(url, content, links);
+  if(links.empty()) {
     fmt::print(stderr, fg(fmt::color::red), "📉 Failed to extract links from: {}\n", url);
   }
 
-  lxb_html_document_destroy(doc);
-  return pages;
-}
-
-auto Program::get_node(PageNode::Index index) -> PageNode&
-{
-  return m_nodes.at(index);
-}
-
-auto Program::exists(std::string const& url) -> bool
-{
-  return m_url_to_index.find(url) != m_url_to_index.end();
-}
-
-auto Program::add_node(std::string const& url, int depth) -> PageNode::Index
-{
-  auto it = m_url_to_index.find(url);
-  if(it == m_url_to_index.end()) {
-    int index = m_nodes.size();
-    m_index_to_url[index] = url;
-    m_url_to_index[url] = index;
-    m_nodes.push_back(PageNode(index, depth));
-
-    return index;
-  }
-
-  return it->second;
+  return std::unordered_set<URL>(links.begin(), links.end());
 }
 
 ogdf::Color getHeatMapColor(float value)
@@ -462,31 +223,18 @@ ogdf::Color getHeatMapColor(float value)
   return ogdf::Color(r, g, b);
 }
 
-int Program::graph()
+void configure_fmmm(ogdf::FMMMLayout& layout)
 {
-  ogdf::Graph G;
-  std::vector<ogdf::node> nodes;
-  nodes.reserve(m_nodes.size());
-  for(size_t i = 0; i < m_nodes.size(); ++i) {
-    nodes.push_back(G.newNode());
-  }
-
-  for(std::size_t i = 0; i < m_nodes.size(); ++i) {
-    PageNode const& node = m_nodes[i];
-    for(int child_index : node.children()) {
-      if(child_index >= 0 && child_index < static_cast<int>(nodes.size())) {
-        G.newEdge(nodes[i], nodes[child_index]);
-      }
-    }
-  }
-
-  fmt::print(fg(fmt::color::magenta), "[Graph] 🧩 Nodes: {} | 🔗 Edges: {}\n", G.numberOfNodes(), G.numberOfEdges());
-
-  if(G.numberOfNodes() == 0) {
-    fmt::print(fg(fmt::color::red), "⚠️  Graph is empty, skipping rendering.\n");
-    return 0;
-  }
+  layout.useHighLevelOptions(true);
+  layout.newInitialPlacement(true);
+  layout.qualityVersusSpeed(ogdf::FMMMOptions::QualityVsSpeed::GorgeousAndEfficient);
+  layout.unitEdgeLength(40.0);  // Larger = more spread
+  layout.repForcesStrength(0.25); // Try increasing (0.1 - 1.0+)
+}
 
+// heat map colours and sizes by degree, on every node and edge of {GA}
+void style_graph(ogdf::Graph const& G, ogdf::GraphAttributes& GA)
+{
   // Style Calculation
   // --------------------
   int maxDegree = 0;
@@ -499,8 +247,6 @@ int Program::graph()
 
   // Attribute Assignment
   // -----------------------
-  ogdf::GraphAttributes GA(G, ogdf::GraphAttributes::all);
-
   // --- Pre-computation step to find parents efficiently ---
   // Since we can't ask a node for its parent directly, we build a map.
   // The key is the child node, and the value is its parent node.
@@ -550,6 +296,50 @@ int Program::graph()
 
     GA.arrowType(e) = ogdf::EdgeArrow::None;
   }
+}
+
+int Program::graph()
+{
+  PageGraph const& pages = m_crawler.graph();
+  std::deque<PageNode> const& page_nodes = pages.nodes();
+
+  // merged duplicates are drawn as the page they copy
+  ogdf::Graph G;
+  std::vector<ogdf::node> nodes(page_nodes.size(), nullptr);
+  for(size_t i = 0; i < page_nodes.size(); ++i) {
+    if(page_nodes[i].duplicate_of() < 0) {
+      nodes[i] = G.newNode();
+    }
+  }
+
+  for(std::size_t i = 0; i < page_nodes.size(); ++i) {
+    PageNode const& node = page_nodes[i];
+    for(int child_index : node.children()) {
+      if(child_index >= 0 && child_index < static_cast<int>(nodes.size())) {
+        ogdf::node from = nodes[pages.resolve_node(i)];
+        ogdf::node to = nodes[pages.resolve_node(child_index)];
+        if(from != to) {
+          G.newEdge(from, to);
+        }
+      }
+    }
+  }
+
+  fmt::print(fg(fmt::color::magenta), "[Graph] 🧩 Nodes: {} | 🔗 Edges: {}\n", G.numberOfNodes(), G.numberOfEdges());
+
+  if(G.numberOfNodes() == 0) {
+    fmt::print(fg(fmt::color::red), "⚠️  Graph is empty, skipping rendering.\n");
+    return 0;
+  }
+
+  // past a few thousand nodes one drawing is a hairball, and takes longer
+  // to lay out than the crawl took
+  if(static_cast<std::size_t>(G.numberOfNodes()) > m_cluster_threshold) {
+    return graph_clusters();
+  }
+
+  ogdf::GraphAttributes GA(G, ogdf::GraphAttributes::all);
+  style_graph(G, GA);
 
   // 4. Layout and Export
   // --------------------
@@ -592,11 +382,7 @@ int Program::graph()
 
   // Engine 1: FMMMLayout (Fast Multipole Multilevel Method)
   ogdf::FMMMLayout fmmmLayout;
-  fmmmLayout.useHighLevelOptions(true);
-  fmmmLayout.newInitialPlacement(true);
-  fmmmLayout.qualityVersusSpeed(ogdf::FMMMOptions::QualityVsSpeed::GorgeousAndEfficient);
-  fmmmLayout.unitEdgeLength(40.0);  // Larger = more spread
-  fmmmLayout.repForcesStrength(0.25); // Try increasing (0.1 - 1.0+)
+  configure_fmmm(fmmmLayout);
   runLayout(fmmmLayout, "FMMMLayout");
 
   // Engine 2: StressMinimization
@@ -616,19 +402,152 @@ int Program::graph()
   return graph_count;
 }
 
+int Program::graph_clusters()
+{
+  PageGraph const& pages = m_crawler.graph();
+  std::deque<PageNode> const& page_nodes = pages.nodes();
+
+  // live pages get dense ids, merged duplicates are drawn as the page they copy
+  std::vector<int> dense(page_nodes.size(), -1);
+  std::vector<int> page_of;
+  std::vector<std::uint64_t> hosts;
+  for(std::size_t i = 0; i < page_nodes.size(); ++i) {
+    if(page_nodes[i].duplicate_of() < 0) {
+      dense[i] = static_cast<int>(page_of.size());
+      page_of.push_back(static_cast<int>(i));
+      hosts.push_back(fnv1a64(url_host(pages.get_url(i))));
+    }
+  }
+
+  std::vector<std::pair<int, int>> edges;
+  for(std::size_t i = 0; i < page_nodes.size(); ++i) {
+    for(int child_index : page_nodes[i].children()) {
+      int from = dense[pages.resolve_node(i)];
+      int to = dense[pages.resolve_node(child_index)];
+      if(from != to) {
+        edges.emplace_back(from, to);
+      }
+    }
+  }
+
+  Clusters clusters = cluster_graph(hosts, edges);
+  fmt::print(fg(fmt::color::magenta), "[Graph] 🧶 {} clusters\n", clusters.size());
+
+  // views of an earlier, bigger clustering would pass for this one's
+  int graph_count = 0;
+  std::filesystem::create_directories("graphs/clusters");
+  for(std::filesystem::directory_entry const& entry : std::filesystem::directory_iterator("graphs/clusters")) {
+    if(entry.path().filename().string().starts_with("cluster-") && entry.path().extension() == ".svg") {
+      std::filesystem::remove(entry.path());
+    }
+  }
+
+  // the overview: a node per cluster, as big as its pages, and the links
+  // between clusters. laid out first, it is what opens fast
+  {
+    fmt::print("[Layout] 🧠 overview ... ");
+
+    ogdf::Graph G;
+    std::vector<ogdf::node> nodes(clusters.size());
+    for(ogdf::node& node : nodes) {
+      node = G.newNode();
+    }
+
+    std::vector<std::pair<ogdf::edge, int>> weighted;
+    for(Clusters::Edge const& edge : clusters.edges) {
+      weighted.emplace_back(G.newEdge(nodes[edge.from], nodes[edge.to]), edge.weight);
+    }
+
+    ogdf::GraphAttributes GA(G, ogdf::GraphAttributes::all);
+    style_graph(G, GA);
+
+    std::size_t largest = 1;
+    for(std::vector<int> const& members : clusters.members) {
+      largest = std::max(largest, members.size());
+    }
+    for(std::size_t k = 0; k < clusters.size(); ++k) {
+      std::vector<int> const& members = clusters.members[k];
+      double size = 1.0 + 9.0 * std::sqrt(static_cast<double>(members.size()) / largest);
+      GA.width(nodes[k]) = size;
+      GA.height(nodes[k]) = size;
+      // #k is the view in graphs/clusters/cluster-k.svg
+      GA.label(nodes[k]) = fmt::format("#{} {} ({})", k, url_host(pages.get_url(page_of[members.front()])), members.size());
+    }
+    for(auto const& [edge, weight] : weighted) {
+      GA.strokeWidth(edge) = static_cast<float>(0.085 * (1.0 + std::log2(weight)));
+    }
+
+    ogdf::FMMMLayout layout;
+    configure_fmmm(layout);
+    layout.call(GA);
+    std::string filename = "graphs/overview.svg";
+    ogdf::GraphIO::write(GA, filename, ogdf::GraphIO::drawSVG);
+    ++graph_count;
+
+    fmt::print(fg(fmt::color::green), "ok");
+    fmt::print(" ({} clusters, {} edges) 📄 Saved to {}\n", G.numberOfNodes(), G.numberOfEdges(), filename);
+  }
+
+  // one drill-down view per cluster, with the links inside it
+  std::vector<std::vector<std::pair<int, int>>> inner(clusters.size());
+  for(auto const& [from, to] : edges) {
+    if(clusters.of[from] == clusters.of[to]) {
+      inner[clusters.of[from]].emplace_back(from, to);
+    }
+  }
+
+  std::vector<ogdf::node> local(page_of.size(), nullptr);
+  int views = 0;
+  for(std::size_t k = 0; k < clusters.size(); ++k) {
+    if(clusters.members[k].size() < 2) {
+      continue;
+    }
+
+    ogdf::Graph G;
+    for(int member : clusters.members[k]) {
+      local[member] = G.newNode();
+    }
+    for(auto const& [from, to] : inner[k]) {
+      G.newEdge(local[from], local[to]);
+    }
+
+    ogdf::GraphAttributes GA(G, ogdf::GraphAttributes::all);
+    style_graph(G, GA);
+    ogdf::FMMMLayout layout;
+    configure_fmmm(layout);
+    layout.call(GA);
+    ogdf::GraphIO::write(GA, fmt::format("graphs/clusters/cluster-{}.svg", k), ogdf::GraphIO::drawSVG);
+    ++graph_count;
+    ++views;
+  }
+
+  fmt::print("[Layout] 🔎 {} cluster views 📄 Saved to graphs/clusters/\n", views);
+  return graph_count;
+}
+
 void Program::run()
 {
   print_header(); // fancy header output
   std::string root_url = request_input();
   int depth = request_depth();
+  request_scope(root_url);
+  request_budget();
 
   // std::string root_url = "https://en.wikipedia.org/wiki/Web_crawler";
   // int depth = 3;
 
+  run(root_url, depth);
+}
+
+void Program::run(std::string const& root_url, int depth)
+{
   fmt::print(fg(fmt::color::yellow), "🚀 Starting crawl from {}\n", root_url);
 
   auto start = std::chrono::steady_clock::now();
-  crawl_page(root_url, depth);
+  m_crawler.crawl(root_url, depth);
+  if(PageCache* cache = m_crawler.cache()) {
+    cache->save();
+  }
   int graph_count = graph();
   auto end = std::chrono::steady_clock::now();
   auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(end - start).count();
@@ -636,8 +555,108 @@ void Program::run()
   fmt::print("━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n");
   fmt::print("📊 {}!\n", "Crawl Complete");
   fmt::print("⏱️ {:<18} {}s\n", "Elapsed Time:", elapsed);
-  fmt::print("🌐 {:<18} {}\n", "Total Pages:", m_nodes.size());
+  fmt::print("🌐 {:<18} {}\n", "Total Pages:", m_crawler.graph().node_count());
+  fmt::print("📥 {:<18} {}\n", "Fetched Pages:", m_crawler.stats().pages_fetched);
   fmt::print("📁 {:<18} {}\n", "Output SVGs:", graph_count);
   fmt::print("⛏️ {:<18} {}\n", "Depth:", depth);
+  fmt::print("🪞 {:<18} {}\n", "Merged Duplicates:", m_crawler.stats().merged);
+  if(m_crawler.fetcher().hedging()) {
+    fmt::print("🏇 {:<18} {}\n", "Hedged Requests:", m_crawler.fetcher().hedged());
+  }
+  if(m_crawler.cache()) {
+    fmt::print("💤 {:<18} {}\n", "Not Modified:", m_crawler.stats().not_modified + m_crawler.stats().unchanged);
+  }
+  fmt::print("━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n");
+}
+
+void Program::run_shard(ShardConfig const& config, std::string const& root_url, int depth)
+{
+  print_header();
+  m_crawler.set_spool(std::make_unique<ShardSpool>(config));
+
+  fmt::print(fg(fmt::color::yellow), "🚀 Shard {}/{} starting crawl from {}\n", config.id, config.count, root_url);
+
+  auto start = std::chrono::steady_clock::now();
+  m_crawler.crawl_shard(root_url, depth);
+
+  std::filesystem::path path = shard_graph_path(config, config.id);
+  write_shard_graph(path, m_crawler.graph().export_graph());
+
+  auto end = std::chrono::steady_clock::now();
+  auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(end - start).count();
+
+  fmt::print("━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n");
+  fmt::print("📊 Shard {}/{} Complete!\n", config.id, config.count);
+  fmt::print("⏱️ {:<18} {}s\n", "Elapsed Time:", elapsed);
+  fmt::print("🌐 {:<18} {}\n", "Total Pages:", m_crawler.graph().node_count());
+  fmt::print("📁 {:<18} {}\n", "Shard Graph:", path.string());
+  fmt::print("━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n");
+}
+
+void Program::run_merge(ShardConfig const& config)
+{
+  print_header();
+  fmt::print(fg(fmt::color::yellow), "🧷 Merging {} shards from {}\n", config.count, config.dir.string());
+
+  m_crawler.graph().load_graph(merge_shards(config.dir, config.count));
+  int graph_count = graph();
+
+  fmt::print("━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n");
+  fmt::print("📊 {}!\n", "Merge Complete");
+  fmt::print("🌐 {:<18} {}\n", "Total Pages:", m_crawler.graph().node_count());
+  fmt::print("📁 {:<18} {}\n", "Output SVGs:", graph_count);
   fmt::print("━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n");
 }
+
+void Program::record_to(std::filesystem::path const& path)
+{
+  m_crawler.fetcher().record_to(path);
+}
+
+void Program::replay_from(std::filesystem::path const& path)
+{
+  m_crawler.fetcher().replay_from(path);
+}
+
+void Program::use_cache(std::filesystem::path const& path)
+{
+  m_crawler.set_cache(std::make_unique<PageCache>(path));
+}
+
+void Program::serve_live(std::uint16_t port)
+{
+  m_live = std::make_unique<LiveView>(LiveView::Options{.port = port});
+  m_crawler.set_listener(m_live.get());
+  fmt::print(fg(fmt::color::yellow), "📡 Live view on {}\n", m_live->url());
+}
+
+int Program::rebuild_from_archive(int threads)
+{
+  ArchiveReader const* replay = m_crawler.fetcher().replaying();
+  if(!replay) {
+    throw std::runtime_error("rebuild_from_archive() requires an archive.");
+  }
+  return m_crawler.rebuild(*replay, threads);
+}
+
+void Program::run_rebuild(std::filesystem::path const& path, int threads)
+{
+  print_header();
+  replay_from(path);
+
+  fmt::print(fg(fmt::color::yellow), "📼 Rebuilding graph from {} with {} threads\n", path.string(), threads);
+
+  auto start = std::chrono::steady_clock::now();
+  int pages = rebuild_from_archive(threads);
+  int graph_count = graph();
+  auto end = std::chrono::steady_clock::now();
+  auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(end - start).count();
+
+  fmt::print("━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n");
+  fmt::print("📊 {}!\n", "Rebuild Complete");
+  fmt::print("⏱️ {:<18} {}s\n", "Elapsed Time:", elapsed);
+  fmt::print("📄 {:<18} {}\n", "Archived Pages:", pages);
+  fmt::print("🌐 {:<18} {}\n", "Total Pages:", m_crawler.graph().node_count());
+  fmt::print("📁 {:<18} {}\n", "Output SVGs:", graph_count);
+  fmt::print("━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n");
+}
\ No newline at end of file
@@ -0,0 +1,560 @@
+#include <resolver.hpp>
+//
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+//
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr std::uint16_t type_a = 1;
+constexpr std::uint16_t type_aaaa = 28;
+constexpr std::uint16_t class_in = 1;
+constexpr int rcode_nxdomain = 3;
+
+auto is_ip_literal(std::string_view host) -> bool
+{
+  return !host.empty() && (host.front() == '[' || host.find_first_not_of("0123456789.") == std::string_view::npos);
+}
+
+// the names of a hosts file: "address name [aliases..]" per line
+auto read_hosts_file(std::string const& path) -> std::vector<std::string>
+{
+  std::vector<std::string> names;
+  std::ifstream file(path);
+  std::string line;
+  while(std::getline(file, line)) {
+    line.erase(std::min(line.find('#'), line.size()));
+    std::istringstream words(line);
+    std::string address;
+    std::string name;
+    words >> address;
+    while(words >> name) {
+      std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+      names.push_back(std::move(name));
+    }
+  }
+  return names;
+}
+
+auto read16(std::vector<std::uint8_t> const& data, std::size_t pos) -> std::uint16_t
+{
+  return static_cast<std::uint16_t>(data[pos] << 8 | data[pos + 1]);
+}
+
+auto read32(std::vector<std::uint8_t> const& data, std::size_t pos) -> std::uint32_t
+{
+  return static_cast<std::uint32_t>(read16(data, pos)) << 16 | read16(data, pos + 2);
+}
+
+// moves {pos} past a possibly compressed name
+auto skip_name(std::vector<std::uint8_t> const& data, std::size_t& pos) -> bool
+{
+  while(pos < data.size()) {
+    std::uint8_t length = data[pos];
+    if(length == 0) {
+      ++pos;
+      return true;
+    }
+    if((length & 0xC0) == 0xC0) {
+      pos += 2;
+      return pos <= data.size();
+    }
+    pos += 1 + length;
+  }
+  return false;
+}
+
+// the plain labels of a question name, as lowercase dotted text
+auto read_question_name(std::vector<std::uint8_t> const& data, std::size_t& pos) -> std::optional<std::string>
+{
+  std::string name;
+  while(pos < data.size()) {
+    std::uint8_t length = data[pos];
+    if(length == 0) {
+      ++pos;
+      return name;
+    }
+    if((length & 0xC0) != 0 || pos + 1 + length > data.size()) {
+      return std::nullopt; // nothing precedes the question to point back at
+    }
+    if(!name.empty()) {
+      name += '.';
+    }
+    for(std::size_t i = pos + 1; i < pos + 1 + length; ++i) {
+      name += static_cast<char>(std::tolower(data[i]));
+    }
+    pos += 1 + length;
+  }
+  return std::nullopt;
+}
+
+auto lowercase_name(std::string_view host) -> std::string
+{
+  if(host.ends_with('.')) {
+    host.remove_suffix(1);
+  }
+  std::string out(host);
+  std::transform(out.begin(), out.end(), out.begin(), [](unsigned char c) { return std::tolower(c); });
+  return out;
+}
+
+auto build_query(std::string_view host, std::uint16_t id, std::uint16_t type) -> std::optional<std::vector<std::uint8_t>>
+{
+  std::vector<std::uint8_t> packet = {
+    static_cast<std::uint8_t>(id >> 8), static_cast<std::uint8_t>(id), // id
+    0x01, 0x00,                                                        // recursion desired
+    0x00, 0x01,                                                        // one question
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+
+  while(!host.empty()) {
+    std::string_view label = host.substr(0, host.find('.'));
+    host.remove_prefix(std::min(label.size() + 1, host.size()));
+    if(label.empty() || label.size() > 63) {
+      return std::nullopt;
+    }
+    packet.push_back(static_cast<std::uint8_t>(label.size()));
+    packet.insert(packet.end(), label.begin(), label.end());
+  }
+
+  packet.insert(packet.end(), {0x00, static_cast<std::uint8_t>(type >> 8), static_cast<std::uint8_t>(type), 0x00, class_in});
+  return packet;
+}
+
+struct Response
+{
+  int rcode{};
+  bool truncated{};
+  std::vector<std::string> addresses;
+  std::uint32_t ttl = UINT32_MAX; // lowest of the answers
+};
+
+// the answer to the question {id} asked, {type} records of {name}, or
+// nothing if the packet answers anything else
+auto parse_response(std::vector<std::uint8_t> const& data, std::uint16_t id, std::string_view name, std::uint16_t type)
+  -> std::optional<Response>
+{
+  if(data.size() < 12 || read16(data, 0) != id || !(data[2] & 0x80) || read16(data, 4) != 1) {
+    return std::nullopt;
+  }
+
+  Response out;
+  out.truncated = (data[2] & 0x02) != 0;
+  out.rcode = data[3] & 0x0F;
+  std::uint16_t answers = read16(data, 6);
+
+  std::size_t pos = 12;
+  std::optional<std::string> asked = read_question_name(data, pos);
+  if(!asked || pos + 4 > data.size() || *asked != lowercase_name(name) || read16(data, pos) != type ||
+     read16(data, pos + 2) != class_in) {
+    return std::nullopt;
+  }
+  pos += 4;
+
+  int family = type == type_a ? AF_INET : AF_INET6;
+  std::uint16_t size = type == type_a ? 4 : 16;
+
+  // cnames come first, then the addresses of where they point
+  for(int i = 0; i < answers; ++i) {
+    if(!skip_name(data, pos) || pos + 10 > data.size()) {
+      return std::nullopt;
+    }
+    std::uint16_t rtype = read16(data, pos);
+    std::uint16_t rclass = read16(data, pos + 2);
+    std::uint32_t ttl = read32(data, pos + 4);
+    std::uint16_t length = read16(data, pos + 8);
+    pos += 10;
+    if(pos + length > data.size()) {
+      return std::nullopt;
+    }
+
+    if(rtype == type && rclass == class_in && length == size) {
+      char text[INET6_ADDRSTRLEN] = {};
+      inet_ntop(family, data.data() + pos, text, sizeof(text));
+      out.addresses.emplace_back(text);
+      out.ttl = std::min(out.ttl, ttl);
+    }
+    pos += length;
+  }
+
+  return out;
+}
+
+// closes the socket on the way out
+struct Socket
+{
+  int fd = -1;
+  ~Socket()
+  {
+    if(fd >= 0) {
+      ::close(fd);
+    }
+  }
+};
+
+auto read_exact(int fd, std::uint8_t* out, std::size_t size) -> bool
+{
+  while(size > 0) {
+    ssize_t received = ::recv(fd, out, size, 0);
+    if(received <= 0) {
+      return false;
+    }
+    out += received;
+    size -= static_cast<std::size_t>(received);
+  }
+  return true;
+}
+
+// one query over tcp, for answers too large for a datagram
+auto exchange_tcp(sockaddr_in const& server, std::vector<std::uint8_t> const& packet, std::chrono::milliseconds timeout)
+  -> std::optional<std::vector<std::uint8_t>>
+{
+  Socket socket{::socket(AF_INET, SOCK_STREAM, 0)};
+  if(socket.fd < 0) {
+    return std::nullopt;
+  }
+  // bounds connect, send and every recv alike
+  timeval limit{.tv_sec = timeout.count() / 1000, .tv_usec = static_cast<suseconds_t>(timeout.count() % 1000 * 1000)};
+  ::setsockopt(socket.fd, SOL_SOCKET, SO_RCVTIMEO, &limit, sizeof(limit));
+  ::setsockopt(socket.fd, SOL_SOCKET, SO_SNDTIMEO, &limit, sizeof(limit));
+  if(::connect(socket.fd, reinterpret_cast<sockaddr const*>(&server), sizeof(server)) != 0) {
+    return std::nullopt;
+  }
+
+  // every message goes with its length in front
+  std::vector<std::uint8_t> framed = {static_cast<std::uint8_t>(packet.size() >> 8), static_cast<std::uint8_t>(packet.size())};
+  framed.insert(framed.end(), packet.begin(), packet.end());
+  if(::send(socket.fd, framed.data(), framed.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(framed.size())) {
+    return std::nullopt;
+  }
+
+  std::uint8_t length[2];
+  if(!read_exact(socket.fd, length, sizeof(length))) {
+    return std::nullopt;
+  }
+  std::vector<std::uint8_t> data(static_cast<std::size_t>(length[0] << 8 | length[1]));
+  if(!read_exact(socket.fd, data.data(), data.size())) {
+    return std::nullopt;
+  }
+  return data;
+}
+
+} // namespace
+
+DnsResolver::DnsResolver(Options options) :
+  m_options{std::move(options)}
+{
+  if(!m_options.hosts_file.empty()) {
+    for(std::string& name : read_hosts_file(m_options.hosts_file)) {
+      m_local.insert(std::move(name));
+    }
+  }
+  for(int i = 0; i < std::max(1, m_options.workers); ++i) {
+    m_workers.emplace_back(&DnsResolver::work, this);
+  }
+}
+
+DnsResolver::~DnsResolver()
+{
+  {
+    std::lock_guard lock(m_mutex);
+    m_stop = true;
+  }
+  m_wake.notify_all();
+  for(std::thread& worker : m_workers) {
+    worker.join();
+  }
+}
+
+std::optional<DnsResolver::Options> DnsResolver::system_options(std::string const& path)
+{
+  Options options;
+  bool found = false;
+  std::ifstream file(path);
+  std::string line;
+  while(std::getline(file, line)) {
+    std::istringstream words(line);
+    std::string key;
+    words >> key;
+    if(key == "nameserver") {
+      std::string address;
+      in_addr parsed{};
+      if(!found && words >> address && inet_pton(AF_INET, address.c_str(), &parsed) == 1) {
+        options.server = address;
+        found = true;
+      }
+    } else if(key == "search" || key == "domain") {
+      // the last of them wins, as with the system resolver
+      options.search.clear();
+      std::string domain;
+      while(words >> domain) {
+        options.search.push_back(lowercase_name(domain));
+      }
+    } else if(key == "options") {
+      std::string option;
+      while(words >> option) {
+        if(option.starts_with("ndots:")) {
+          options.ndots = std::clamp(std::atoi(option.c_str() + 6), 0, 15);
+        }
+      }
+    }
+  }
+  if(!found) {
+    return std::nullopt;
+  }
+  return options;
+}
+
+void DnsResolver::prefetch(std::string_view host)
+{
+  if(host.empty() || is_ip_literal(host) || local(host)) {
+    return;
+  }
+
+  {
+    std::lock_guard lock(m_mutex);
+    auto it = m_cache.find(host);
+    if((it != m_cache.end() && it->second.expires > Clock::now()) || m_pending.contains(host)) {
+      return;
+    }
+    m_pending.emplace(host);
+    m_queue.emplace_back(host);
+  }
+  m_wake.notify_one();
+}
+
+std::optional<DnsResolver::Addresses> DnsResolver::lookup(std::string_view host) const
+{
+  std::lock_guard lock(m_mutex);
+  auto it = m_cache.find(host);
+  if(it == m_cache.end() || it->second.expires <= Clock::now()) {
+    return std::nullopt;
+  }
+  return it->second.addresses;
+}
+
+std::optional<DnsResolver::Addresses> DnsResolver::resolve(std::string_view host)
+{
+  if(local(host)) {
+    return std::nullopt;
+  }
+  if(std::optional<Addresses> cached = lookup(host)) {
+    return cached;
+  }
+
+  std::string name(host);
+  std::optional<Entry> entry = query(name);
+  if(!entry) {
+    return std::nullopt;
+  }
+
+  Addresses addresses = entry->addresses;
+  store(name, std::move(*entry));
+  return addresses;
+}
+
+std::optional<std::string> DnsResolver::curl_resolve_entry(std::string_view host, int port) const
+{
+  std::optional<Addresses> addresses = lookup(host);
+  if(!addresses || addresses->empty()) {
+    return std::nullopt;
+  }
+
+  std::string out = "+";
+  out += host;
+  out += ':' + std::to_string(port) + ':';
+  for(std::size_t i = 0; i < addresses->size(); ++i) {
+    if(i > 0) {
+      out += ',';
+    }
+    std::string const& address = (*addresses)[i];
+    out += address.find(':') == std::string::npos ? address : '[' + address + ']';
+  }
+  return out;
+}
+
+void DnsResolver::work()
+{
+  while(true) {
+    std::string host;
+    {
+      std::unique_lock lock(m_mutex);
+      m_wake.wait(lock, [&]() { return m_stop || !m_queue.empty(); });
+      if(m_stop) {
+        return;
+      }
+      host = std::move(m_queue.front());
+      m_queue.pop_front();
+    }
+
+    std::optional<Entry> entry = query(host);
+
+    std::lock_guard lock(m_mutex);
+    m_pending.erase(host);
+    if(entry) {
+      m_cache.insert_or_assign(host, std::move(*entry));
+    }
+  }
+}
+
+void DnsResolver::store(std::string const& host, Entry entry)
+{
+  std::lock_guard lock(m_mutex);
+  m_cache.insert_or_assign(host, std::move(entry));
+}
+
+std::optional<DnsResolver::Entry> DnsResolver::query(std::string const& host)
+{
+  // the names to try, in order, like res_search
+  std::vector<std::string> names;
+  if(host.ends_with('.') || m_options.search.empty()) {
+    names.push_back(host);
+  } else {
+    bool enough_dots = std::count(host.begin(), host.end(), '.') >= m_options.ndots;
+    if(enough_dots) {
+      names.push_back(host);
+    }
+    for(std::string const& domain : m_options.search) {
+      names.push_back(host + '.' + domain);
+    }
+    if(!enough_dots) {
+      names.push_back(host);
+    }
+  }
+
+  std::optional<Entry> entry;
+  for(std::string const& name : names) {
+    entry = ask(name);
+    if(!entry || !entry->addresses.empty()) {
+      return entry; // an answer, or no way to know whether the others exist
+    }
+  }
+  return entry; // none of them exists
+}
+
+std::optional<DnsResolver::Entry> DnsResolver::ask(std::string const& name)
+{
+  thread_local std::mt19937 rng{std::random_device{}()};
+
+  struct Question
+  {
+    std::uint16_t type;
+    std::uint16_t id;
+    std::vector<std::uint8_t> packet;
+    std::optional<Response> response;
+  };
+
+  std::array<Question, 2> questions = {Question{.type = type_a}, Question{.type = type_aaaa}};
+  for(Question& question : questions) {
+    question.id = static_cast<std::uint16_t>(rng());
+    std::optional<std::vector<std::uint8_t>> packet = build_query(name, question.id, question.type);
+    if(!packet) {
+      return std::nullopt;
+    }
+    question.packet = std::move(*packet);
+  }
+
+  sockaddr_in server{};
+  server.sin_family = AF_INET;
+  server.sin_port = htons(m_options.port);
+  if(inet_pton(AF_INET, m_options.server.c_str(), &server.sin_addr) != 1) {
+    return std::nullopt;
+  }
+
+  // connected, so only the nameserver's datagrams get through
+  Socket socket{::socket(AF_INET, SOCK_DGRAM, 0)};
+  if(socket.fd < 0 || ::connect(socket.fd, reinterpret_cast<sockaddr*>(&server), sizeof(server)) != 0) {
+    return std::nullopt;
+  }
+
+  auto unanswered = [&]() {
+    return std::any_of(questions.begin(), questions.end(), [](Question const& question) { return !question.response; });
+  };
+  // every answer is in, or one already settles it (nxdomain, server trouble)
+  auto settled = [&]() {
+    return !unanswered() || std::any_of(questions.begin(), questions.end(), [](Question const& question) {
+      return question.response && question.response->rcode != 0;
+    });
+  };
+
+  std::vector<std::uint8_t> buffer(4096);
+  for(int attempt = 0; attempt < m_options.attempts && !settled(); ++attempt) {
+    for(Question const& question : questions) {
+      if(!question.response) {
+        ++m_queries;
+        if(::send(socket.fd, question.packet.data(), question.packet.size(), 0) < 0) {
+          return std::nullopt;
+        }
+      }
+    }
+
+    auto deadline = Clock::now() + m_options.timeout;
+    while(!settled() && Clock::now() < deadline) {
+      auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now());
+      pollfd poller{.fd = socket.fd, .events = POLLIN, .revents = 0};
+      if(::poll(&poller, 1, static_cast<int>(std::max<long long>(left.count(), 1))) <= 0) {
+        break;
+      }
+
+      ssize_t received = ::recv(socket.fd, buffer.data(), buffer.size(), 0);
+      if(received <= 0) {
+        break;
+      }
+
+      std::vector<std::uint8_t> data(buffer.begin(), buffer.begin() + received);
+      for(Question& question : questions) {
+        if(question.response) {
+          continue;
+        }
+        std::optional<Response> response = parse_response(data, question.id, name, question.type);
+        if(response && response->truncated) {
+          // the rest did not fit, ask again over tcp
+          ++m_queries;
+          std::optional<std::vector<std::uint8_t>> whole = exchange_tcp(server, question.packet, m_options.timeout);
+          response = whole ? parse_response(*whole, question.id, name, question.type) : std::nullopt;
+        }
+        if(response) {
+          question.response = std::move(response);
+          break;
+        }
+      }
+      // anything else is a stray or broken datagram, keep waiting
+    }
+  }
+
+  auto now = Clock::now();
+  Entry entry{.addresses = {}, .expires = now + m_options.negative_ttl};
+  std::uint32_t ttl = UINT32_MAX;
+  for(Question& question : questions) {
+    if(!question.response) {
+      continue;
+    }
+    if(question.response->rcode == rcode_nxdomain) {
+      return Entry{.addresses = {}, .expires = now + m_options.negative_ttl};
+    }
+    if(question.response->rcode != 0) {
+      return std::nullopt; // server trouble, not worth remembering
+    }
+    for(std::string& address : question.response->addresses) {
+      entry.addresses.push_back(std::move(address));
+    }
+    ttl = std::min(ttl, question.response->ttl);
+  }
+
+  if(entry.addresses.empty()) {
+    // no address of either family, unless an answer is missing
+    return unanswered() ? std::nullopt : std::optional<Entry>(entry);
+  }
+  entry.expires = now + std::clamp(std::chrono::seconds(ttl), m_options.min_ttl, m_options.max_ttl);
+  return entry;
+}
@@ -0,0 +1,50 @@
+#include <retry.hpp>
+//
+#include <algorithm>
+#include <cmath>
+
+RetryQueue::Clock::duration RetryQueue::delay(int attempt)
+{
+  // base, 2 * base, 4 * base, ... capped
+  double backoff = m_policy.base_delay.count() * std::pow(2.0, std::max(0, attempt - 1));
+  backoff = std::min(backoff, static_cast<double>(m_policy.max_delay.count()));
+
+  std::uniform_real_distribution<double> jitter(1.0 - m_policy.jitter, 1.0 + m_policy.jitter);
+  auto ms = std::chrono::milliseconds(static_cast<long long>(backoff * jitter(m_rng)));
+  return std::chrono::duration_cast<Clock::duration>(ms);
+}
+
+bool RetryQueue::schedule(int index, int depth, int attempt, Clock::time_point now)
+{
+  if(attempt >= m_policy.max_attempts) {
+    return false;
+  }
+
+  m_queue.push(RetryEntry{.index = index, .depth = depth, .attempt = attempt, .ready = now + delay(attempt)});
+  return true;
+}
+
+void RetryQueue::defer(RetryEntry entry, Clock::time_point until)
+{
+  entry.ready = until;
+  m_queue.push(entry);
+}
+
+std::optional<RetryEntry> RetryQueue::pop_ready(Clock::time_point now)
+{
+  if(m_queue.empty() || m_queue.top().ready > now) {
+    return std::nullopt;
+  }
+
+  RetryEntry entry = m_queue.top();
+  m_queue.pop();
+  return entry;
+}
+
+std::optional<RetryQueue::Clock::time_point> RetryQueue::next_ready() const
+{
+  if(m_queue.empty()) {
+    return std::nullopt;
+  }
+  return m_queue.top().ready;
+}
@@ -0,0 +1,367 @@
+#include <robots.hpp>
+//
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+//
+#include <zlib.h>
+//
+#include <url.hpp>
+
+namespace {
+
+auto to_lower(char c) -> char
+{
+  return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+auto lowercase(std::string_view in) -> std::string
+{
+  std::string out(in);
+  std::transform(out.begin(), out.end(), out.begin(), to_lower);
+  return out;
+}
+
+auto trim(std::string_view s) -> std::string_view
+{
+  auto first = s.find_first_not_of(" \t\r\n");
+  if(first == std::string_view::npos) {
+    return {};
+  }
+  auto last = s.find_last_not_of(" \t\r\n");
+  return s.substr(first, last - first + 1);
+}
+
+// '*' matches any run of characters. unless {anchored}, the pattern only
+// has to match a prefix of {text}
+auto glob_match(std::string_view pattern, std::string_view text, bool anchored) -> bool
+{
+  std::size_t p = 0;
+  std::size_t t = 0;
+  std::size_t star = std::string_view::npos;
+  std::size_t mark = 0;
+
+  while(t < text.size()) {
+    if(p < pattern.size() && pattern[p] == '*') {
+      star = p++;
+      mark = t;
+    } else if(p == pattern.size() && !anchored) {
+      return true;
+    } else if(p < pattern.size() && pattern[p] == text[t]) {
+      ++p;
+      ++t;
+    } else if(star != std::string_view::npos) {
+      p = star + 1;
+      t = ++mark;
+    } else {
+      return false;
+    }
+  }
+
+  while(p < pattern.size() && pattern[p] == '*') {
+    ++p;
+  }
+  return p == pattern.size();
+}
+
+auto unescape_xml(std::string_view in) -> std::string
+{
+  static constexpr std::pair<std::string_view, char> entities[] = {
+    {"&amp;", '&'}, {"&lt;", '<'}, {"&gt;", '>'}, {"&quot;", '"'}, {"&apos;", '\''}};
+
+  std::string out;
+  out.reserve(in.size());
+  for(std::size_t i = 0; i < in.size(); ++i) {
+    bool replaced = false;
+    if(in[i] == '&') {
+      for(auto const& [entity, c] : entities) {
+        if(in.substr(i, entity.size()) == entity) {
+          out.push_back(c);
+          i += entity.size() - 1;
+          replaced = true;
+          break;
+        }
+      }
+    }
+    if(!replaced) {
+      out.push_back(in[i]);
+    }
+  }
+  return out;
+}
+
+} // namespace
+
+RobotsRules RobotsRules::parse(std::string_view text, std::string_view agent)
+{
+  struct Group
+  {
+    std::vector<std::string> agents;
+    std::vector<std::pair<std::string_view, bool>> rules;
+    std::optional<std::chrono::milliseconds> crawl_delay;
+  };
+
+  RobotsRules out;
+  std::vector<Group> groups;
+  bool in_agents = false; // consecutive user-agent lines share one group
+
+  while(!text.empty()) {
+    std::string_view line = text.substr(0, text.find('\n'));
+    text.remove_prefix(std::min(line.size() + 1, text.size()));
+
+    line = trim(line.substr(0, line.find('#')));
+    auto colon = line.find(':');
+    if(colon == std::string_view::npos) {
+      continue;
+    }
+
+    std::string key = lowercase(trim(line.substr(0, colon)));
+    std::string_view value = trim(line.substr(colon + 1));
+
+    if(key == "sitemap") {
+      if(!value.empty()) {
+        out.m_sitemaps.emplace_back(value);
+      }
+      continue;
+    }
+
+    if(key == "user-agent") {
+      if(!in_agents) {
+        groups.emplace_back();
+      }
+      groups.back().agents.push_back(lowercase(value));
+      in_agents = true;
+      continue;
+    }
+
+    in_agents = false;
+    if(groups.empty()) {
+      continue; // rules before any user-agent line
+    }
+
+    if(key == "allow" || key == "disallow") {
+      if(!value.empty()) { // an empty disallow allows everything
+        groups.back().rules.emplace_back(value, key == "allow");
+      }
+    } else if(key == "crawl-delay") {
+      double seconds = 0;
+      auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), seconds);
+      if(ec == std::errc{} && seconds >= 0) {
+        groups.back().crawl_delay = std::chrono::milliseconds(static_cast<long long>(seconds * 1000));
+      }
+    }
+  }
+
+  // our own groups if there are any, otherwise the '*' ones
+  std::string me = lowercase(agent);
+  auto names = [&](Group const& group, std::string_view name) {
+    return std::find(group.agents.begin(), group.agents.end(), name) != group.agents.end();
+  };
+  bool specific = std::any_of(groups.begin(), groups.end(), [&](Group const& group) { return names(group, me); });
+
+  for(Group const& group : groups) {
+    if(!names(group, specific ? std::string_view(me) : std::string_view("*"))) {
+      continue;
+    }
+    for(auto const& [pattern, allow] : group.rules) {
+      out.add(pattern, allow);
+    }
+    if(!out.m_crawl_delay) {
+      out.m_crawl_delay = group.crawl_delay;
+    }
+  }
+
+  return out;
+}
+
+RobotsRules RobotsRules::disallow_all()
+{
+  RobotsRules out;
+  out.disallow("/");
+  return out;
+}
+
+std::optional<std::uint32_t> RobotsRules::child(std::uint32_t node, char c) const
+{
+  for(auto const& [edge, next] : m_nodes[node].edges) {
+    if(edge == c) {
+      return next;
+    }
+  }
+  return std::nullopt;
+}
+
+void RobotsRules::add(std::string_view pattern, bool allow)
+{
+  ++m_rule_count;
+
+  bool anchored = !pattern.empty() && pattern.back() == '$';
+  if(anchored || pattern.find('*') != std::string_view::npos) {
+    if(anchored) {
+      pattern.remove_suffix(1);
+    }
+    m_patterns.push_back(Pattern{.pattern = std::string(pattern), .anchored = anchored, .allow = allow});
+    return;
+  }
+
+  std::uint32_t node = 0;
+  for(char c : pattern) {
+    std::optional<std::uint32_t> next = child(node, c);
+    if(!next) {
+      next = static_cast<std::uint32_t>(m_nodes.size());
+      m_nodes[node].edges.emplace_back(c, *next);
+      m_nodes.emplace_back();
+    }
+    node = *next;
+  }
+
+  if(m_nodes[node].verdict != Verdict::Allow) {
+    m_nodes[node].verdict = allow ? Verdict::Allow : Verdict::Disallow; // allow wins ties
+  }
+}
+
+bool RobotsRules::allowed(std::string_view target) const
+{
+  if(target == "/robots.txt") {
+    return true;
+  }
+
+  // length of the longest matching rule, and whether it allows
+  std::size_t best = 0;
+  bool matched = false;
+  bool allow = true;
+
+  std::uint32_t node = 0;
+  for(std::size_t i = 0; i < target.size(); ++i) {
+    std::optional<std::uint32_t> next = child(node, target[i]);
+    if(!next) {
+      break;
+    }
+    node = *next;
+
+    if(m_nodes[node].verdict != Verdict::None) {
+      best = i + 1;
+      matched = true;
+      allow = m_nodes[node].verdict == Verdict::Allow;
+    }
+  }
+
+  for(Pattern const& pattern : m_patterns) {
+    std::size_t length = pattern.pattern.size() + pattern.anchored;
+    if(matched && (length < best || (length == best && allow))) {
+      continue; // could not win anyway
+    }
+    if(glob_match(pattern.pattern, target, pattern.anchored)) {
+      best = length;
+      matched = true;
+      allow = pattern.allow;
+    }
+  }
+
+  return !matched || allow;
+}
+
+RobotsRules const* RobotsCache::find(std::string_view origin) const
+{
+  auto it = m_rules.find(fnv1a64(origin));
+  return it == m_rules.end() ? nullptr : &it->second;
+}
+
+RobotsRules const& RobotsCache::insert(std::string_view origin, RobotsRules rules)
+{
+  return m_rules.insert_or_assign(fnv1a64(origin), std::move(rules)).first->second;
+}
+
+void HostScheduler::set_delay(std::string_view host, Clock::duration delay)
+{
+  m_hosts[fnv1a64(host)].delay = std::min(delay, m_max_delay);
+}
+
+HostScheduler::Clock::duration HostScheduler::delay(std::string_view host) const
+{
+  auto it = m_hosts.find(fnv1a64(host));
+  return it == m_hosts.end() ? m_default_delay : it->second.delay.value_or(m_default_delay);
+}
+
+HostScheduler::Clock::time_point HostScheduler::ready_at(std::string_view host) const
+{
+  return ready_at(fnv1a64(host));
+}
+
+HostScheduler::Clock::time_point HostScheduler::ready_at(std::uint64_t host_hash) const
+{
+  auto it = m_hosts.find(host_hash);
+  if(it == m_hosts.end() || !it->second.last) {
+    return Clock::time_point{};
+  }
+  return *it->second.last + it->second.delay.value_or(m_default_delay);
+}
+
+void HostScheduler::visited(std::string_view host, Clock::time_point when)
+{
+  m_hosts[fnv1a64(host)].last = when;
+}
+
+Sitemap parse_sitemap(std::string_view xml)
+{
+  Sitemap out;
+  bool index = xml.find("<sitemapindex") != std::string_view::npos;
+
+  std::size_t pos = 0;
+  while((pos = xml.find("<loc>", pos)) != std::string_view::npos) {
+    pos += 5;
+    auto end = xml.find("</loc>", pos);
+    if(end == std::string_view::npos) {
+      break;
+    }
+
+    std::string_view loc = trim(xml.substr(pos, end - pos));
+    pos = end + 6;
+
+    if(loc.starts_with("<![CDATA[") && loc.ends_with("]]>")) {
+      loc = trim(loc.substr(9, loc.size() - 12));
+    }
+    if(!loc.empty()) {
+      (index ? out.sitemaps : out.urls).push_back(unescape_xml(loc));
+    }
+  }
+
+  return out;
+}
+
+std::string gunzip(std::string_view data)
+{
+  if(data.size() < 2 || static_cast<unsigned char>(data[0]) != 0x1f || static_cast<unsigned char>(data[1]) != 0x8b) {
+    return std::string(data);
+  }
+
+  // sitemaps may not be larger than 50MB uncompressed, stop there
+  constexpr std::size_t max_size = 50 * 1024 * 1024;
+
+  z_stream stream{};
+  if(inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) {
+    throw std::runtime_error("Failed to init zlib.");
+  }
+
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream.avail_in = static_cast<uInt>(data.size());
+
+  std::string out;
+  int status = Z_OK;
+  while(status == Z_OK && out.size() < max_size) {
+    std::size_t offset = out.size();
+    out.resize(offset + 64 * 1024);
+    stream.next_out = reinterpret_cast<Bytef*>(out.data() + offset);
+    stream.avail_out = 64 * 1024;
+
+    status = inflate(&stream, Z_NO_FLUSH);
+    out.resize(out.size() - stream.avail_out);
+  }
+  inflateEnd(&stream);
+
+  if(status != Z_STREAM_END && status != Z_OK) {
+    throw std::runtime_error("Failed to inflate gzip data.");
+  }
+
+  return out;
+}
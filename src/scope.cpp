@@ -0,0 +1,194 @@
+#include <scope.hpp>
+//
+#include <algorithm>
+#include <cctype>
+//
+#include <url.hpp>
+
+namespace {
+
+auto lowercase(std::string_view in) -> std::string
+{
+  std::string out(in);
+  std::transform(out.begin(), out.end(), out.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+  return out;
+}
+
+} // namespace
+
+std::optional<std::uint32_t> CrawlScope::Trie::child(std::uint32_t node, char c) const
+{
+  for(auto const& [edge, next] : nodes[node].edges) {
+    if(edge == c) {
+      return next;
+    }
+  }
+  return std::nullopt;
+}
+
+CrawlScope::Node& CrawlScope::Trie::insert(std::string_view key)
+{
+  std::uint32_t node = 0;
+  for(char c : key) {
+    std::optional<std::uint32_t> next = child(node, c);
+    if(!next) {
+      next = static_cast<std::uint32_t>(nodes.size());
+      nodes[node].edges.emplace_back(c, *next);
+      nodes.emplace_back();
+    }
+    node = *next;
+  }
+  return nodes[node];
+}
+
+CrawlScope::Node& CrawlScope::Trie::insert_reversed(std::string_view key)
+{
+  std::string reversed(key.rbegin(), key.rend());
+  return insert(reversed);
+}
+
+void CrawlScope::allow_host(std::string_view host, int max_level)
+{
+  add_host(host, Verdict::Allow, max_level);
+  m_has_host_allow = true;
+}
+
+void CrawlScope::deny_host(std::string_view host)
+{
+  add_host(host, Verdict::Deny, unlimited);
+}
+
+void CrawlScope::allow_path(std::string_view prefix)
+{
+  add_path(prefix, Verdict::Allow);
+  m_has_path_allow = true;
+}
+
+void CrawlScope::deny_path(std::string_view prefix)
+{
+  add_path(prefix, Verdict::Deny);
+}
+
+void CrawlScope::allow_pattern(std::string const& regex)
+{
+  m_allow_patterns.add(regex);
+}
+
+void CrawlScope::deny_pattern(std::string const& regex)
+{
+  m_deny_patterns.add(regex);
+}
+
+void CrawlScope::add_host(std::string_view host, Verdict verdict, int max_level)
+{
+  while(!host.empty() && host.front() == '.') {
+    host.remove_prefix(1);
+  }
+
+  Node& node = m_hosts.insert_reversed(lowercase(host));
+  if(node.verdict != Verdict::Allow) {
+    node.verdict = verdict; // allow wins ties
+  }
+  node.max_level = std::min(node.max_level, max_level);
+  ++m_host_rules;
+}
+
+void CrawlScope::add_path(std::string_view prefix, Verdict verdict)
+{
+  Node& node = m_paths.insert(prefix);
+  if(node.verdict != Verdict::Allow) {
+    node.verdict = verdict;
+  }
+  ++m_path_rules;
+}
+
+CrawlScope::Node const* CrawlScope::match_host(std::string_view host) const
+{
+  Node const* best = nullptr;
+  std::uint32_t node = 0;
+
+  // from the right, a rule only matches on a label boundary
+  for(std::size_t i = host.size(); i-- > 0;) {
+    std::optional<std::uint32_t> next = m_hosts.child(node, host[i]);
+    if(!next) {
+      break;
+    }
+    node = *next;
+
+    Node const& current = m_hosts.nodes[node];
+    if(current.verdict != Verdict::None && (i == 0 || host[i - 1] == '.')) {
+      best = &current;
+    }
+  }
+
+  return best;
+}
+
+CrawlScope::Verdict CrawlScope::match_path(std::string_view path) const
+{
+  Verdict best = m_paths.nodes[0].verdict;
+  std::uint32_t node = 0;
+
+  for(char c : path) {
+    std::optional<std::uint32_t> next = m_paths.child(node, c);
+    if(!next) {
+      break;
+    }
+    node = *next;
+
+    if(m_paths.nodes[node].verdict != Verdict::None) {
+      best = m_paths.nodes[node].verdict;
+    }
+  }
+
+  return best;
+}
+
+bool CrawlScope::allows(std::string_view url, int level) const
+{
+  auto scheme_end = url.find("://");
+  if(scheme_end == std::string_view::npos) {
+    return false;
+  }
+
+  std::string_view scheme = url.substr(0, scheme_end);
+  if(scheme != "http" && scheme != "https") {
+    return false;
+  }
+
+  if(empty()) {
+    return true;
+  }
+
+  if(m_host_rules > 0) {
+    Node const* rule = match_host(url_host(url));
+    if(rule) {
+      if(rule->verdict == Verdict::Deny || level > rule->max_level) {
+        return false;
+      }
+    } else if(m_has_host_allow) {
+      return false;
+    }
+  }
+
+  if(m_path_rules > 0) {
+    std::string_view rest = url.substr(scheme_end + 3);
+    auto path_start = rest.find_first_of("/?");
+    std::string_view path = path_start == std::string_view::npos ? std::string_view("/") : rest.substr(path_start);
+
+    Verdict verdict = match_path(path);
+    if(verdict == Verdict::Deny || (verdict == Verdict::None && m_has_path_allow)) {
+      return false;
+    }
+  }
+
+  if(m_deny_patterns.search(url)) {
+    return false;
+  }
+
+  if(!m_allow_patterns.empty() && !m_allow_patterns.search(url)) {
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,265 @@
+#include <shard.hpp>
+//
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+#include <unordered_map>
+//
+#include <url.hpp>
+
+int shard_of(std::string_view url, int count)
+{
+  if(count <= 1) {
+    return 0;
+  }
+
+  // hosts are case insensitive
+  std::uint64_t hash = fnv1a64({});
+  for(char c : url_host(url)) {
+    char lower = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    hash = fnv1a64(std::string_view(&lower, 1), hash);
+  }
+
+  return static_cast<int>(hash % static_cast<std::uint64_t>(count));
+}
+
+ShardSpool::ShardSpool(ShardConfig const& config) :
+  m_config{config}, m_out(config.count), m_read_pos(config.count, 0)
+{
+  if(m_config.count < 1 || m_config.id < 0 || m_config.id >= m_config.count) {
+    throw std::runtime_error("Invalid shard " + std::to_string(m_config.id) + "/" + std::to_string(m_config.count));
+  }
+
+  std::filesystem::create_directories(m_config.dir);
+  publish_status(false);
+}
+
+std::filesystem::path ShardSpool::spool_path(int to, int from) const
+{
+  return m_config.dir / ("spool-" + std::to_string(to) + "-" + std::to_string(from) + ".txt");
+}
+
+std::filesystem::path ShardSpool::status_path(int id) const
+{
+  return m_config.dir / ("status-" + std::to_string(id) + ".txt");
+}
+
+void ShardSpool::forward(std::string const& url, int depth)
+{
+  int to = shard_of(url, m_config.count);
+  if(to == m_config.id) {
+    return;
+  }
+
+  std::ofstream& out = m_out[to];
+  if(!out.is_open()) {
+    out.open(spool_path(to, m_config.id), std::ios::app | std::ios::binary);
+    if(!out) {
+      throw std::runtime_error("Failed to open spool " + spool_path(to, m_config.id).string());
+    }
+  }
+
+  out << depth << '\t' << url << '\n';
+  ++m_sent;
+}
+
+void ShardSpool::flush()
+{
+  for(std::ofstream& out : m_out) {
+    if(out.is_open()) {
+      out.flush();
+    }
+  }
+}
+
+std::vector<ShardLink> ShardSpool::receive()
+{
+  std::vector<ShardLink> links;
+
+  for(int from = 0; from < m_config.count; ++from) {
+    if(from == m_config.id) {
+      continue;
+    }
+
+    std::ifstream in(spool_path(m_config.id, from), std::ios::binary);
+    if(!in) {
+      continue;
+    }
+
+    in.seekg(m_read_pos[from]);
+    std::string chunk((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    // only consume complete lines, the writer may be mid-line
+    auto end = chunk.rfind('\n');
+    if(end == std::string::npos) {
+      continue;
+    }
+    m_read_pos[from] += static_cast<std::streamoff>(end + 1);
+
+    std::string_view lines(chunk.data(), end + 1);
+    while(!lines.empty()) {
+      auto eol = lines.find('\n');
+      std::string_view line = lines.substr(0, eol);
+      lines.remove_prefix(eol + 1);
+
+      auto tab = line.find('\t');
+      if(tab == std::string_view::npos) {
+        continue;
+      }
+
+      ShardLink link;
+      link.depth = std::stoi(std::string(line.substr(0, tab)));
+      link.url = std::string(line.substr(tab + 1));
+      links.push_back(std::move(link));
+      ++m_received;
+    }
+  }
+
+  if(!links.empty()) {
+    publish_status(false);
+  }
+
+  return links;
+}
+
+void ShardSpool::publish_status(bool idle)
+{
+  // write then rename, so readers never see a half written status
+  std::filesystem::path path = status_path(m_config.id);
+  std::filesystem::path tmp = path;
+  tmp += ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::trunc);
+    out << (idle ? 1 : 0) << ' ' << m_sent << ' ' << m_received << '\n';
+  }
+  std::filesystem::rename(tmp, path);
+}
+
+bool ShardSpool::finished()
+{
+  flush();
+  publish_status(true);
+
+  std::uint64_t sent = 0;
+  std::uint64_t received = 0;
+
+  for(int id = 0; id < m_config.count; ++id) {
+    std::ifstream in(status_path(id));
+    int idle = 0;
+    std::uint64_t s = 0, r = 0;
+    if(!(in >> idle >> s >> r) || !idle) {
+      m_last_totals = {~0ull, ~0ull};
+      return false;
+    }
+    sent += s;
+    received += r;
+  }
+
+  if(sent != received) {
+    m_last_totals = {~0ull, ~0ull};
+    return false;
+  }
+
+  // statuses are read one by one, so require the same totals twice in a row
+  bool stable = m_last_totals == std::make_pair(sent, received);
+  m_last_totals = {sent, received};
+  return stable;
+}
+
+std::filesystem::path shard_graph_path(ShardConfig const& config, int id)
+{
+  return config.dir / ("shard-" + std::to_string(id) + ".graph");
+}
+
+void write_shard_graph(std::filesystem::path const& path, ShardGraph const& graph)
+{
+  std::ofstream out(path, std::ios::trunc | std::ios::binary);
+  if(!out) {
+    throw std::runtime_error("Failed to write shard graph " + path.string());
+  }
+
+  out << graph.urls.size() << '\n';
+  for(std::size_t i = 0; i < graph.urls.size(); ++i) {
+    out << graph.depths[i] << ' ' << graph.urls[i] << '\n';
+  }
+
+  out << graph.edges.size() << '\n';
+  for(auto const& [from, to] : graph.edges) {
+    out << from << ' ' << to << '\n';
+  }
+
+  out << graph.merged.size() << '\n';
+  for(auto const& [duplicate, original] : graph.merged) {
+    out << duplicate << ' ' << original << '\n';
+  }
+}
+
+ShardGraph read_shard_graph(std::filesystem::path const& path)
+{
+  std::ifstream in(path, std::ios::binary);
+  if(!in) {
+    throw std::runtime_error("Failed to read shard graph " + path.string());
+  }
+
+  ShardGraph graph;
+  std::size_t count = 0;
+
+  in >> count;
+  graph.urls.resize(count);
+  graph.depths.resize(count);
+  for(std::size_t i = 0; i < count; ++i) {
+    in >> graph.depths[i] >> graph.urls[i];
+  }
+
+  in >> count;
+  graph.edges.resize(count);
+  for(std::size_t i = 0; i < count; ++i) {
+    in >> graph.edges[i].first >> graph.edges[i].second;
+  }
+
+  in >> count;
+  graph.merged.resize(count);
+  for(std::size_t i = 0; i < count; ++i) {
+    in >> graph.merged[i].first >> graph.merged[i].second;
+  }
+
+  if(!in) {
+    throw std::runtime_error("Corrupt shard graph " + path.string());
+  }
+
+  return graph;
+}
+
+ShardGraph merge_shards(std::filesystem::path const& dir, int count)
+{
+  ShardGraph merged;
+  std::unordered_map<std::string, int> url_to_index;
+  ShardConfig config{.id = 0, .count = count, .dir = dir};
+
+  for(int id = 0; id < count; ++id) {
+    ShardGraph shard = read_shard_graph(shard_graph_path(config, id));
+
+    // local index -> global index
+    std::vector<int> remap(shard.urls.size());
+    for(std::size_t i = 0; i < shard.urls.size(); ++i) {
+      auto [it, inserted] = url_to_index.try_emplace(shard.urls[i], static_cast<int>(merged.urls.size()));
+      if(inserted) {
+        merged.urls.push_back(shard.urls[i]);
+        merged.depths.push_back(shard.depths[i]);
+      } else {
+        int& depth = merged.depths[it->second];
+        depth = std::max(depth, shard.depths[i]);
+      }
+      remap[i] = it->second;
+    }
+
+    for(auto const& [from, to] : shard.edges) {
+      merged.edges.emplace_back(remap.at(from), remap.at(to));
+    }
+    for(auto const& [duplicate, original] : shard.merged) {
+      merged.merged.emplace_back(remap.at(duplicate), remap.at(original));
+    }
+  }
+
+  return merged;
+}
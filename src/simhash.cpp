@@ -0,0 +1,159 @@
+#include <simhash.hpp>
+//
+#include <bit>
+#include <stdexcept>
+#include <string>
+//
+#include <url.hpp>
+
+namespace {
+
+// spreads the bits of a shingle hash, simhash wants every bit to be a coin flip
+auto mix(std::uint64_t x) -> std::uint64_t
+{
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ull;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebull;
+  x ^= x >> 31;
+  return x;
+}
+
+auto is_word_char(unsigned char c) -> bool
+{
+  // bytes of utf-8 sequences count as letters
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c >= 0x80;
+}
+
+} // namespace
+
+int hamming(std::uint64_t a, std::uint64_t b)
+{
+  return std::popcount(a ^ b);
+}
+
+void SimHasher::clear()
+{
+  m_weights.fill(0);
+  m_window.fill(0);
+  m_words = 0;
+}
+
+void SimHasher::add_text(std::string_view text)
+{
+  std::uint64_t hash = fnv1a64({});
+  bool in_word = false;
+
+  for(char ch : text) {
+    auto c = static_cast<unsigned char>(ch);
+    if(is_word_char(c)) {
+      if(c >= 'A' && c <= 'Z') {
+        c = static_cast<unsigned char>(c - 'A' + 'a');
+      }
+      hash = (hash ^ c) * 1099511628211ull;
+      in_word = true;
+    } else if(in_word) {
+      add_word(hash);
+      hash = fnv1a64({});
+      in_word = false;
+    }
+  }
+
+  if(in_word) {
+    add_word(hash);
+  }
+}
+
+void SimHasher::add_word(std::uint64_t hash)
+{
+  m_window[m_words % shingle_size] = hash;
+  ++m_words;
+  if(m_words < shingle_size) {
+    return;
+  }
+
+  // the shingle, oldest word first
+  std::uint64_t shingle = 0;
+  for(std::size_t i = 0; i < shingle_size; ++i) {
+    shingle = shingle * 1099511628211ull ^ m_window[(m_words + i) % shingle_size];
+  }
+  add_feature(mix(shingle), m_weights);
+}
+
+void SimHasher::add_feature(std::uint64_t hash, std::array<std::int32_t, 64>& weights) const
+{
+  for(int bit = 0; bit < 64; ++bit) {
+    weights[bit] += (hash >> bit) & 1 ? 1 : -1;
+  }
+}
+
+std::uint64_t SimHasher::value() const
+{
+  // too short for a single shingle, use the words themselves
+  std::array<std::int32_t, 64> weights = m_weights;
+  if(m_words < shingle_size) {
+    for(std::size_t i = 0; i < m_words; ++i) {
+      add_feature(mix(m_window[i]), weights);
+    }
+  }
+
+  std::uint64_t out = 0;
+  for(int bit = 0; bit < 64; ++bit) {
+    if(weights[bit] > 0) {
+      out |= std::uint64_t{1} << bit;
+    }
+  }
+  return out;
+}
+
+SimHashIndex::SimHashIndex(int max_distance, std::size_t min_words) :
+  m_max_distance{max_distance}, m_min_words{min_words}
+{
+  // the block tables only guarantee a hit while fewer bits differ than there are blocks
+  if(max_distance < 0 || max_distance >= blocks) {
+    throw std::invalid_argument("SimHashIndex distance must be between 0 and " + std::to_string(blocks - 1));
+  }
+}
+
+void SimHashIndex::insert(ContentFingerprint const& fingerprint, int id)
+{
+  m_exact.try_emplace(fingerprint.exact, id);
+  if(fingerprint.words < m_min_words) {
+    return;
+  }
+
+  auto position = static_cast<std::uint32_t>(m_entries.size());
+  m_entries.push_back(Entry{.simhash = fingerprint.simhash, .id = id});
+  for(int i = 0; i < blocks; ++i) {
+    m_tables[i][block(fingerprint.simhash, i)].push_back(position);
+  }
+}
+
+std::optional<SimHashIndex::Match> SimHashIndex::find(ContentFingerprint const& fingerprint) const
+{
+  if(auto it = m_exact.find(fingerprint.exact); it != m_exact.end()) {
+    return Match{.id = it->second, .distance = 0};
+  }
+
+  if(fingerprint.words < m_min_words) {
+    return std::nullopt;
+  }
+
+  std::optional<Match> best;
+  for(int i = 0; i < blocks; ++i) {
+    auto it = m_tables[i].find(block(fingerprint.simhash, i));
+    if(it == m_tables[i].end()) {
+      continue;
+    }
+
+    for(std::uint32_t position : it->second) {
+      Entry const& entry = m_entries[position];
+      int distance = hamming(entry.simhash, fingerprint.simhash);
+      if(distance <= m_max_distance && (!best || distance < best->distance)) {
+        best = Match{.id = entry.id, .distance = distance};
+      }
+    }
+  }
+
+  return best;
+}
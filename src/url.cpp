@@ -0,0 +1,257 @@
+#include <url.hpp>
+//
+#include <algorithm>
+
+namespace {
+
+// the five parts of RFC 3986, each with whether it is there at all
+struct UrlParts
+{
+  std::string_view scheme;
+  std::string_view authority;
+  std::string_view path;
+  std::string_view query;
+  std::string_view fragment;
+  bool has_scheme = false;
+  bool has_authority = false;
+  bool has_query = false;
+  bool has_fragment = false;
+};
+
+auto is_scheme_char(char c, bool first) -> bool
+{
+  bool alpha = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+  return alpha || (!first && ((c >= '0' && c <= '9') || c == '+' || c == '-' || c == '.'));
+}
+
+auto split_url(std::string_view url) -> UrlParts
+{
+  UrlParts parts;
+
+  std::size_t colon = url.find_first_of(":/?#");
+  if(colon != std::string_view::npos && colon > 0 && url[colon] == ':') {
+    bool valid = true;
+    for(std::size_t i = 0; i < colon; ++i) {
+      valid = valid && is_scheme_char(url[i], i == 0);
+    }
+    if(valid) {
+      parts.has_scheme = true;
+      parts.scheme = url.substr(0, colon);
+      url.remove_prefix(colon + 1);
+    }
+  }
+
+  if(url.starts_with("//")) {
+    parts.has_authority = true;
+    std::size_t end = url.find_first_of("/?#", 2);
+    parts.authority = url.substr(2, end == std::string_view::npos ? end : end - 2);
+    url.remove_prefix(std::min(end, url.size()));
+  }
+
+  if(std::size_t hash = url.find('#'); hash != std::string_view::npos) {
+    parts.has_fragment = true;
+    parts.fragment = url.substr(hash + 1);
+    url = url.substr(0, hash);
+  }
+  if(std::size_t question = url.find('?'); question != std::string_view::npos) {
+    parts.has_query = true;
+    parts.query = url.substr(question + 1);
+    url = url.substr(0, question);
+  }
+  parts.path = url;
+  return parts;
+}
+
+auto is_space(char c) -> bool
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+// appends {part}, without tabs and newlines, with spaces escaped
+void put(std::string& out, std::string_view part)
+{
+  for(char c : part) {
+    if(c == '\t' || c == '\n' || c == '\r') {
+      continue;
+    }
+    if(c == ' ') {
+      out += "%20";
+    } else {
+      out += c;
+    }
+  }
+}
+
+// removes "." and ".." segments from the absolute path starting at {from},
+// in place: what is written never gets ahead of what is read
+void remove_dot_segments(std::string& out, std::size_t from)
+{
+  std::size_t read = from;
+  std::size_t write = from;
+  std::size_t end = out.size();
+
+  while(read < end) {
+    std::size_t segment = read + 1; // past the '/'
+    std::size_t next = out.find('/', segment);
+    if(next == std::string::npos) {
+      next = end;
+    }
+    std::string_view name(out.data() + segment, next - segment);
+    bool last = next == end;
+
+    if(name == "." || name == "..") {
+      if(name == ".." && write > from) {
+        write = out.rfind('/', write - 1);
+      }
+      if(last) {
+        out[write++] = '/'; // "/a/b/.." is "/a/"
+      }
+    } else {
+      out[write++] = '/';
+      std::copy(out.begin() + segment, out.begin() + next, out.begin() + write);
+      write += next - segment;
+    }
+    read = next;
+  }
+
+  out.resize(write);
+  if(write == from) {
+    out += '/';
+  }
+}
+
+} // namespace
+
+std::string_view url_host(std::string_view url)
+{
+  auto scheme_end = url.find("://");
+  if(scheme_end == std::string_view::npos) {
+    return {};
+  }
+
+  std::string_view authority = url.substr(scheme_end + 3);
+  authority = authority.substr(0, authority.find_first_of("/?#"));
+
+  // drop userinfo
+  auto at = authority.rfind('@');
+  if(at != std::string_view::npos) {
+    authority.remove_prefix(at + 1);
+  }
+
+  // ipv6 literal, keep the brackets
+  if(!authority.empty() && authority.front() == '[') {
+    auto close = authority.find(']');
+    return close == std::string_view::npos ? authority : authority.substr(0, close + 1);
+  }
+
+  return authority.substr(0, authority.find(':'));
+}
+
+std::string_view url_origin(std::string_view url)
+{
+  auto scheme_end = url.find("://");
+  if(scheme_end == std::string_view::npos) {
+    return {};
+  }
+
+  auto authority_end = url.find_first_of("/?#", scheme_end + 3);
+  return url.substr(0, authority_end);
+}
+
+std::string_view url_target(std::string_view url)
+{
+  std::string_view origin = url_origin(url);
+  if(origin.empty()) {
+    return {};
+  }
+
+  std::string_view target = url.substr(origin.size());
+  target = target.substr(0, target.find('#'));
+  return target.empty() || target.front() != '/' ? std::string_view("/") : target;
+}
+
+int url_port(std::string_view url)
+{
+  std::string_view origin = url_origin(url);
+  std::string_view host = url_host(url);
+  if(origin.empty()) {
+    return 0;
+  }
+
+  // whatever follows the host in the authority
+  std::string_view rest = origin.substr(origin.rfind(host) + host.size());
+  if(rest.size() > 1 && rest.front() == ':') {
+    int port = 0;
+    for(char c : rest.substr(1)) {
+      if(c < '0' || c > '9') {
+        return 0;
+      }
+      port = port * 10 + (c - '0');
+      if(port > 65535) {
+        return 0;
+      }
+    }
+    return port;
+  }
+
+  std::string_view scheme = url.substr(0, url.find("://"));
+  if(scheme == "https") return 443;
+  if(scheme == "http") return 80;
+  return 0;
+}
+
+bool resolve_reference(std::string_view base, std::string_view href, std::string& out)
+{
+  while(!href.empty() && is_space(href.front())) {
+    href.remove_prefix(1);
+  }
+  while(!href.empty() && is_space(href.back())) {
+    href.remove_suffix(1);
+  }
+
+  UrlParts b = split_url(base);
+  UrlParts r = split_url(href);
+  if(!b.has_scheme) {
+    return false;
+  }
+
+  out.clear();
+  out += r.has_scheme ? r.scheme : b.scheme;
+  out += ':';
+
+  UrlParts const& owner = r.has_scheme || r.has_authority ? r : b; // of the authority
+  if(owner.has_authority) {
+    out += "//";
+    put(out, owner.authority);
+  }
+
+  std::size_t path = out.size();
+  if(r.has_scheme || r.has_authority || r.path.starts_with('/')) {
+    put(out, r.path);
+  } else if(r.path.empty()) {
+    put(out, b.path);
+  } else {
+    // everything of the base path up to its last '/', then the link
+    if(b.has_authority && b.path.empty()) {
+      out += '/';
+    } else {
+      put(out, b.path.substr(0, b.path.rfind('/') + 1));
+    }
+    put(out, r.path);
+  }
+  if(out.size() > path && out[path] == '/') {
+    remove_dot_segments(out, path);
+  }
+
+  bool own_query = r.has_scheme || r.has_authority || !r.path.empty() || r.has_query;
+  UrlParts const& query = own_query ? r : b;
+  if(query.has_query) {
+    out += '?';
+    put(out, query.query);
+  }
+  if(r.has_fragment) {
+    out += '#';
+    put(out, r.fragment);
+  }
+  return true;
+}
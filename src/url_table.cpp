@@ -0,0 +1,174 @@
+#include <url_table.hpp>
+//
+#include <bit>
+#include <stdexcept>
+//
+#include <url.hpp>
+
+namespace {
+
+constexpr std::size_t initial_slots = 64;
+
+} // namespace
+
+UrlTable::UrlTable(std::size_t shards)
+{
+  std::size_t count = std::bit_ceil(std::max<std::size_t>(shards, 2));
+  m_shards = std::make_unique<Shard[]>(count);
+  m_shift = 64 - std::countr_zero(count);
+}
+
+UrlTable::~UrlTable()
+{
+  release();
+}
+
+std::pair<UrlTable::Index, bool> UrlTable::insert(std::string_view url)
+{
+  std::uint64_t hash = fnv1a64(url);
+  Shard& current = shard(hash);
+  std::lock_guard lock(current.mutex);
+
+  if(current.slots.empty()) {
+    current.slots.resize(initial_slots);
+  }
+
+  std::size_t pos = probe(current, hash, url);
+  if(current.slots[pos].key >= 0) {
+    return {current.slots[pos].value, false};
+  }
+
+  // kept at most half full, so probes stay short
+  if(2 * (current.used + 1) > current.slots.size()) {
+    grow(current);
+    pos = probe(current, hash, url);
+  }
+
+  Index index = m_next.fetch_add(1, std::memory_order_acq_rel);
+  store(index).assign(url);
+  current.slots[pos] = Slot{.hash = hash, .key = index, .value = index};
+  ++current.used;
+  return {index, true};
+}
+
+std::optional<UrlTable::Index> UrlTable::find(std::string_view url) const
+{
+  std::uint64_t hash = fnv1a64(url);
+  Shard const& current = shard(hash);
+  std::lock_guard lock(current.mutex);
+
+  if(current.slots.empty()) {
+    return std::nullopt;
+  }
+
+  Slot const& slot = current.slots[probe(current, hash, url)];
+  if(slot.key < 0) {
+    return std::nullopt;
+  }
+  return slot.value;
+}
+
+void UrlTable::assign(std::string_view url, Index index)
+{
+  std::uint64_t hash = fnv1a64(url);
+  Shard& current = shard(hash);
+  std::lock_guard lock(current.mutex);
+
+  if(!current.slots.empty()) {
+    Slot& slot = current.slots[probe(current, hash, url)];
+    if(slot.key >= 0) {
+      slot.value = index;
+      return;
+    }
+  }
+  throw std::out_of_range("UrlTable::assign: unknown url " + std::string(url));
+}
+
+std::string const& UrlTable::url(Index index) const
+{
+  if(index < 0 || static_cast<std::size_t>(index) >= size()) {
+    throw std::out_of_range("UrlTable::url: no url with id " + std::to_string(index));
+  }
+
+  auto [segment, offset] = locate(index);
+  return m_segments[segment].load(std::memory_order_acquire)[offset];
+}
+
+std::pair<int, std::size_t> UrlTable::locate(Index index)
+{
+  // segment s holds 2^(s + first_segment_bits) urls
+  std::uint64_t k = static_cast<std::uint64_t>(index) + (1ull << first_segment_bits);
+  int segment = std::bit_width(k) - 1 - first_segment_bits;
+  return {segment, k - (1ull << (segment + first_segment_bits))};
+}
+
+std::size_t UrlTable::probe(Shard const& current, std::uint64_t hash, std::string_view key) const
+{
+  std::size_t mask = current.slots.size() - 1;
+  for(std::size_t pos = hash & mask;; pos = (pos + 1) & mask) {
+    Slot const& slot = current.slots[pos];
+    if(slot.key < 0) {
+      return pos;
+    }
+    if(slot.hash != hash) {
+      continue;
+    }
+    auto [segment, offset] = locate(slot.key);
+    if(m_segments[segment].load(std::memory_order_relaxed)[offset] == key) {
+      return pos;
+    }
+  }
+}
+
+void UrlTable::grow(Shard& current)
+{
+  std::vector<Slot> old = std::move(current.slots);
+  current.slots.assign(old.size() * 2, Slot{});
+
+  std::size_t mask = current.slots.size() - 1;
+  for(Slot const& slot : old) {
+    if(slot.key < 0) {
+      continue;
+    }
+    std::size_t pos = slot.hash & mask;
+    while(current.slots[pos].key >= 0) {
+      pos = (pos + 1) & mask;
+    }
+    current.slots[pos] = slot;
+  }
+}
+
+std::string& UrlTable::store(Index index)
+{
+  auto [segment, offset] = locate(index);
+  std::string* urls = m_segments[segment].load(std::memory_order_acquire);
+  if(!urls) {
+    // first id in a new segment, another shard may be racing us to it
+    std::string* fresh = new std::string[1ull << (segment + first_segment_bits)];
+    if(m_segments[segment].compare_exchange_strong(urls, fresh, std::memory_order_acq_rel)) {
+      urls = fresh;
+    } else {
+      delete[] fresh;
+    }
+  }
+  return urls[offset];
+}
+
+void UrlTable::clear()
+{
+  release();
+  m_next.store(0, std::memory_order_release);
+
+  std::size_t count = std::size_t{1} << (64 - m_shift);
+  for(std::size_t i = 0; i < count; ++i) {
+    m_shards[i].slots.clear();
+    m_shards[i].used = 0;
+  }
+}
+
+void UrlTable::release()
+{
+  for(std::atomic<std::string*>& segment : m_segments) {
+    delete[] segment.exchange(nullptr);
+  }
+}
@@ -0,0 +1,169 @@
+#include "archive.hpp" // The header you're testing
+
+#include <doctest/doctest.h>
+#include <thread>
+//
+#include <unistd.h>
+
+namespace {
+
+auto archive_dir(std::string const& name) -> std::filesystem::path
+{
+  auto dir = std::filesystem::temp_directory_path() / ("crawler-" + name + "-" + std::to_string(getpid()));
+  std::filesystem::remove_all(dir);
+  return dir;
+}
+
+} // namespace
+
+TEST_CASE("archive roundtrip")
+{
+  auto dir = archive_dir("archive");
+  std::string body(20000, 'x');
+  body += "<a href=\"/next\">next</a>";
+
+  {
+    ArchiveWriter writer(dir / "crawl.warc");
+    writer.append({.url = "https://a.test/", .final_url = "https://a.test/home", .status = 200, .headers = "HTTP/1.1 200 OK\r\n", .body = body});
+    writer.append({.url = "https://a.test/missing", .final_url = "https://a.test/missing", .status = 404});
+  }
+
+  ArchiveReader reader(dir / "crawl.warc");
+  REQUIRE(reader.size() == 2);
+
+  auto home = reader.find("https://a.test/");
+  REQUIRE(home.has_value());
+  CHECK(home->final_url == "https://a.test/home");
+  CHECK(home->status == 200);
+  CHECK(home->headers == "HTTP/1.1 200 OK\r\n");
+  CHECK(home->body == body);
+
+  // reachable through the redirect target too
+  auto redirected = reader.find("https://a.test/home");
+  REQUIRE(redirected.has_value());
+  CHECK(redirected->url == "https://a.test/");
+
+  auto missing = reader.find("https://a.test/missing");
+  REQUIRE(missing.has_value());
+  CHECK(missing->status == 404);
+  CHECK(missing->body.empty());
+
+  CHECK_FALSE(reader.find("https://b.test/").has_value());
+
+  std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("archive keeps what each record was fetched for")
+{
+  auto dir = archive_dir("archive-kind");
+
+  {
+    ArchiveWriter writer(dir / "crawl.warc");
+    writer.append({.url = "https://a.test/", .final_url = "https://a.test/", .status = 200, .body = "page"});
+    writer.append({.url = "https://a.test/robots.txt", .final_url = "https://a.test/robots.txt", .status = 200, .kind = RecordKind::robots});
+    writer.append({.url = "https://a.test/sitemap.xml", .final_url = "https://a.test/sitemap.xml", .status = 200, .kind = RecordKind::sitemap});
+    writer.append({.url = "https://b.test/", .final_url = "https://b.test/home", .status = 200, .kind = RecordKind::head});
+  }
+
+  ArchiveReader reader(dir / "crawl.warc");
+  REQUIRE(reader.size() == 4);
+  CHECK(reader.record(0).kind == RecordKind::page);
+  CHECK(reader.record(1).kind == RecordKind::robots);
+  CHECK(reader.record(2).kind == RecordKind::sitemap);
+  CHECK(reader.find("https://b.test/home")->kind == RecordKind::head);
+
+  std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("archive appends across writers and prefers the latest fetch")
+{
+  auto dir = archive_dir("archive-append");
+
+  ArchiveWriter(dir / "crawl.warc").append({.url = "https://a.test/", .final_url = "https://a.test/", .status = 200, .body = "old"});
+  ArchiveWriter(dir / "crawl.warc").append({.url = "https://a.test/", .final_url = "https://a.test/", .status = 200, .body = "new"});
+
+  ArchiveReader reader(dir / "crawl.warc");
+  CHECK(reader.size() == 2);
+  CHECK(reader.record(0).body == "old");
+  CHECK(reader.find("https://a.test/")->body == "new");
+
+  std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("archive ignores an interrupted append")
+{
+  auto dir = archive_dir("archive-torn");
+
+  {
+    ArchiveWriter writer(dir / "crawl.warc");
+    writer.append({.url = "https://a.test/", .final_url = "https://a.test/", .status = 200, .body = "kept"});
+  }
+
+  // a torn index entry and a record the index never got to
+  std::ofstream(dir / "crawl.warc.idx", std::ios::app | std::ios::binary) << "partial";
+  std::ofstream(dir / "crawl.warc", std::ios::app | std::ios::binary) << "CRW2 garbage";
+
+  ArchiveReader reader(dir / "crawl.warc");
+  CHECK(reader.size() == 1);
+  CHECK(reader.find("https://a.test/")->body == "kept");
+
+  std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("archive rejects a record whose sizes overrun it")
+{
+  auto dir = archive_dir("archive-corrupt");
+
+  {
+    ArchiveWriter writer(dir / "crawl.warc");
+    writer.append({.url = "https://a.test/", .final_url = "https://a.test/", .status = 200, .body = "first"});
+    writer.append({.url = "https://b.test/", .final_url = "https://b.test/", .status = 200, .body = "second"});
+  }
+
+  // the url size of the first record, right after magic and status
+  {
+    std::fstream data(dir / "crawl.warc", std::ios::in | std::ios::out | std::ios::binary);
+    data.seekp(8);
+    std::uint32_t huge = 0x7fffffff;
+    data.write(reinterpret_cast<char const*>(&huge), sizeof(huge));
+  }
+
+  ArchiveReader reader(dir / "crawl.warc");
+  CHECK_THROWS_AS(reader.record(0), std::runtime_error);
+  CHECK_THROWS_AS(reader.find("https://a.test/"), std::runtime_error);
+  CHECK(reader.find("https://b.test/")->body == "second");
+
+  std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("archive is readable from several threads")
+{
+  auto dir = archive_dir("archive-threads");
+
+  {
+    ArchiveWriter writer(dir / "crawl.warc");
+    for(int i = 0; i < 64; ++i) {
+      std::string url = "https://a.test/" + std::to_string(i);
+      writer.append({.url = url, .final_url = url, .status = 200, .body = std::string(1000 + i, 'a' + i % 26)});
+    }
+  }
+
+  ArchiveReader reader(dir / "crawl.warc");
+  REQUIRE(reader.size() == 64);
+
+  std::vector<int> ok(4, 0);
+  std::vector<std::thread> pool;
+  for(int t = 0; t < 4; ++t) {
+    pool.emplace_back([&, t]() {
+      for(std::size_t i = t; i < reader.size(); i += 4) {
+        ArchiveRecord record = reader.record(i);
+        ok[t] += record.body.size() == 1000 + i && record.body[0] == static_cast<char>('a' + i % 26);
+      }
+    });
+  }
+  for(auto& thread : pool) thread.join();
+
+  CHECK(ok[0] + ok[1] + ok[2] + ok[3] == 64);
+
+  std::filesystem::remove_all(dir);
+}
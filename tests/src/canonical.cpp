@@ -0,0 +1,68 @@
+#include "canonical.hpp" // The header you're testing
+
+#include <doctest/doctest.h>
+//
+#include "url.hpp"
+
+TEST_CASE("canonicalize host, port and path")
+{
+  Canonicalizer const& c = Canonicalizer::defaults();
+
+  CHECK(c.canonicalize("HTTPS://Example.COM:443/a/b/") == "https://example.com/a/b");
+  CHECK(c.canonicalize("http://example.com:80") == "http://example.com/");
+  CHECK(c.canonicalize("http://example.com:8080/") == "http://example.com:8080/");
+  CHECK(c.canonicalize("https://example.com./x") == "https://example.com/x");
+  CHECK(c.canonicalize("https://example.com/dir/index.html") == "https://example.com/dir");
+  CHECK(c.canonicalize("https://example.com/index.htm#top") == "https://example.com/");
+  CHECK(c.canonicalize("https://user@[::1]:443/") == "https://user@[::1]/");
+  CHECK(c.canonicalize("mailto:someone@example.com") == "mailto:someone@example.com");
+}
+
+TEST_CASE("canonicalize percent encoding")
+{
+  Canonicalizer const& c = Canonicalizer::defaults();
+
+  CHECK(c.canonicalize("https://a.test/%7Euser/%41b%2d") == "https://a.test/~user/Ab-");
+  CHECK(c.canonicalize("https://a.test/a%2fb%c3%a9") == "https://a.test/a%2Fb%C3%A9");
+  CHECK(c.canonicalize("https://a.test/100%") == "https://a.test/100%");
+}
+
+TEST_CASE("canonicalize query")
+{
+  Canonicalizer const& c = Canonicalizer::defaults();
+
+  // distinct pages stay distinct
+  CHECK(c.canonicalize("https://w.test/index.php?title=A") != c.canonicalize("https://w.test/index.php?title=B"));
+
+  CHECK(c.canonicalize("https://a.test/p?b=2&a=1") == "https://a.test/p?a=1&b=2");
+  CHECK(c.canonicalize("https://a.test/p?utm_source=x&id=3&fbclid=y&&") == "https://a.test/p?id=3");
+  CHECK(c.canonicalize("https://a.test/p?UTM_Medium=x") == "https://a.test/p");
+  CHECK(c.canonicalize("https://a.test/p?q=%7e") == "https://a.test/p?q=~");
+}
+
+TEST_CASE("canonicalize per host rules")
+{
+  Canonicalizer c;
+  c.set_rules("wiki.test", CanonicalRules{.strip_www = true, .keep_params = {"title", "oldid"}});
+  c.set_rules("Static.Test", CanonicalRules{.keep_query = false});
+
+  CHECK(c.canonicalize("https://www.wiki.test/w/index.php?action=edit&title=X") == "https://wiki.test/w/index.php?title=X");
+  CHECK(c.canonicalize("https://en.wiki.test/w?oldid=1&x=2") == "https://en.wiki.test/w?oldid=1");
+  CHECK(c.canonicalize("https://static.test/a.css?v=123") == "https://static.test/a.css");
+  CHECK(c.canonicalize("https://www.other.test/?v=1") == "https://www.other.test/?v=1");
+
+  CHECK(&c.rules_for("deep.en.wiki.test") == &c.rules_for("wiki.test"));
+  CHECK(&c.rules_for("other.test") != &c.rules_for("wiki.test"));
+}
+
+TEST_CASE("canonicalize fingerprint")
+{
+  Canonicalizer const& c = Canonicalizer::defaults();
+  std::string out;
+
+  std::uint64_t a = c.canonicalize("https://A.test/x?b=1&a=2", out);
+  CHECK(a == fnv1a64(out));
+
+  std::uint64_t b = c.canonicalize("https://a.test:443/x?a=2&b=1#f", out);
+  CHECK(a == b);
+}
@@ -0,0 +1,111 @@
+#include "cluster.hpp" // The header you're testing
+
+#include <doctest/doctest.h>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// every pair of nodes in [first, first + size) linked both ways
+void clique(std::vector<std::pair<int, int>>& edges, int first, int size)
+{
+  for(int a = first; a < first + size; ++a) {
+    for(int b = first; b < first + size; ++b) {
+      if(a != b) {
+        edges.emplace_back(a, b);
+      }
+    }
+  }
+}
+
+} // namespace
+
+TEST_CASE("propagate_labels finds densely linked groups")
+{
+  std::vector<std::pair<int, int>> edges;
+  clique(edges, 0, 6);
+  clique(edges, 6, 6);
+  edges.emplace_back(0, 6); // one bridge
+
+  std::vector<int> labels = propagate_labels(12, edges);
+  for(int node = 1; node < 6; ++node) {
+    CHECK(labels[node] == labels[0]);
+    CHECK(labels[node + 6] == labels[6]);
+  }
+  CHECK(labels[0] != labels[6]);
+}
+
+TEST_CASE("propagate_labels leaves unlinked nodes alone")
+{
+  std::vector<int> labels = propagate_labels(3, {});
+  CHECK((labels == std::vector<int>{0, 1, 2}));
+}
+
+TEST_CASE("cluster_graph builds a weighted coarse graph")
+{
+  std::vector<std::pair<int, int>> edges;
+  clique(edges, 0, 5);
+  clique(edges, 5, 5);
+  edges.emplace_back(0, 5);
+  edges.emplace_back(1, 5);
+  edges.emplace_back(7, 2);
+
+  Clusters clusters = cluster_graph(std::vector<std::uint64_t>(10, 1), edges);
+  REQUIRE(clusters.size() == 2);
+  CHECK((clusters.members[0] == std::vector<int>{0, 1, 2, 3, 4}));
+  CHECK((clusters.members[1] == std::vector<int>{5, 6, 7, 8, 9}));
+  CHECK(clusters.of[7] == 1);
+
+  REQUIRE(clusters.edges.size() == 2);
+  CHECK(clusters.edges[0].from == 0);
+  CHECK(clusters.edges[0].to == 1);
+  CHECK(clusters.edges[0].weight == 2);
+  CHECK(clusters.edges[1].weight == 1);
+}
+
+TEST_CASE("cluster_graph regroups stragglers and giants by host")
+{
+  std::vector<std::pair<int, int>> edges;
+  clique(edges, 0, 8);
+  // 8 and 9 are linked to nothing, on hosts 2 and 3
+  std::vector<std::uint64_t> hosts{1, 1, 1, 1, 2, 2, 2, 2, 2, 3};
+
+  Clusters pooled = cluster_graph(hosts, edges, ClusterOptions{.min_size = 2, .max_size = 100});
+  REQUIRE(pooled.size() == 3);
+  CHECK(pooled.members[0].size() == 8);
+  CHECK(pooled.members[1] == std::vector<int>{8});
+  CHECK(pooled.members[2] == std::vector<int>{9});
+
+  Clusters split = cluster_graph(hosts, edges, ClusterOptions{.min_size = 2, .max_size = 4});
+  REQUIRE(split.size() == 4);
+  CHECK((split.members[0] == std::vector<int>{0, 1, 2, 3}));
+  CHECK((split.members[1] == std::vector<int>{4, 5, 6, 7}));
+  CHECK(split.members[2] == std::vector<int>{8});
+  CHECK(split.edges.size() == 2); // the two halves of the clique, both ways
+  CHECK(split.edges[0].weight == 16);
+}
+
+TEST_CASE("cluster_graph splits a giant on one host until it fits")
+{
+  // two dense groups with a few links between them, then one too dense to split
+  std::vector<std::pair<int, int>> edges;
+  clique(edges, 0, 6);
+  clique(edges, 6, 6);
+  edges.emplace_back(0, 6);
+  edges.emplace_back(1, 7);
+  clique(edges, 12, 10);
+  std::vector<std::uint64_t> hosts(22, 1);
+
+  Clusters clusters = cluster_graph(hosts, edges, ClusterOptions{.min_size = 2, .max_size = 6});
+  std::size_t total = 0;
+  for(std::size_t k = 0; k < clusters.size(); ++k) {
+    CHECK(clusters.members[k].size() <= 6);
+    for(int node : clusters.members[k]) {
+      CHECK(clusters.of[node] == static_cast<int>(k));
+    }
+    total += clusters.members[k].size();
+  }
+  CHECK(total == hosts.size());
+  CHECK((clusters.members[clusters.of[12]] == std::vector<int>{12, 13, 14, 15, 16, 17}));
+  CHECK((clusters.members[clusters.of[21]] == std::vector<int>{18, 19, 20, 21}));
+}
@@ -0,0 +1,483 @@
+#include "crawler.hpp" // The header you're testing
+
+#include <doctest/doctest.h>
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+//
+#include <canonical.hpp>
+#include <page_graph.hpp>
+
+namespace {
+
+// a small web held in memory, unknown pages are 404s
+struct MemoryFetcher
+{
+  using Response = std::pair<std::string, std::string>;
+
+  std::unordered_map<std::string, std::string> pages;
+  std::vector<std::string> fetched;
+
+  void fetch(std::string const& url, Response& out)
+  {
+    fetched.push_back(url);
+    auto it = pages.find(url);
+    if(it == pages.end()) {
+      throw FetchError("HTTP error 404 for " + url, 404, false);
+    }
+    out.first = url;
+    out.second = it->second;
+  }
+
+  auto live() const -> bool { return false; }
+  auto count(std::string const& url) const -> long { return std::count(fetched.begin(), fetched.end(), url); }
+};
+
+// the same web, with every fetch archived the way CurlFetcher does it
+struct ArchivingFetcher : MemoryFetcher
+{
+  std::unique_ptr<ArchiveWriter> archive;
+
+  void fetch(std::string const& url, Response& out) { fetch(url, out, RecordKind::page); }
+
+  void fetch(std::string const& url, Response& out, RecordKind kind)
+  {
+    try {
+      MemoryFetcher::fetch(url, out);
+    }
+    catch(const FetchError& e) {
+      archive->append({.url = url, .final_url = url, .status = e.status(), .kind = kind});
+      throw;
+    }
+    archive->append({.url = url, .final_url = out.first, .status = 200, .body = out.second, .kind = kind});
+  }
+};
+
+// answers 304 while a page keeps the etag it was fetched with
+struct ConditionalFetcher : MemoryFetcher
+{
+  std::unordered_map<std::string, std::string> etags;
+  std::string last_etag;
+
+  void fetch(std::string const& url, Response& out)
+  {
+    MemoryFetcher::fetch(url, out);
+    last_etag = etags[url];
+  }
+
+  auto fetch(std::string const& url, Response& out, Validators const& known) -> bool
+  {
+    if(known.etag == etags[url]) {
+      fetched.push_back(url);
+      out.first = url;
+      out.second.clear();
+      return false;
+    }
+    fetch(url, out);
+    return true;
+  }
+
+  auto validators() const -> Validators { return Validators{.etag = last_etag}; }
+};
+
+// one absolute link per line
+struct LineExtractor
+{
+  inline static int parsed = 0;
+
+  void parse(std::string const&, std::string const& content, LinkBuffer& out)
+  {
+    ++parsed;
+    out.clear();
+    std::size_t begin = 0;
+    while(begin < content.size()) {
+      std::size_t end = content.find('\n', begin);
+      if(end == std::string::npos) {
+        end = content.size();
+      }
+      if(end > begin) {
+        out.next().assign(content, begin, end - begin);
+        out.commit();
+      }
+      begin = end + 1;
+    }
+  }
+};
+
+// same links, plus a fingerprint of the whole body
+struct FingerprintExtractor : LineExtractor
+{
+  void parse(std::string const& base, std::string const& content, LinkBuffer& out)
+  {
+    LineExtractor::parse(base, content, out);
+    m_fingerprint = ContentFingerprint{.exact = fnv1a64(content)};
+  }
+
+  auto fingerprint() const -> ContentFingerprint const& { return m_fingerprint; }
+
+  ContentFingerprint m_fingerprint;
+};
+
+// what a listener was told, in order
+struct RecordingListener : CrawlListener
+{
+  std::vector<std::pair<int, std::string>> pages;
+  std::unordered_map<int, PageStatus> status;
+  std::vector<std::pair<int, int>> links;
+
+  void page_added(int index, std::string_view url, int) override { pages.emplace_back(index, url); }
+  void page_status(int index, PageStatus value) override { status[index] = value; }
+  void link_added(int from, int to) override { links.emplace_back(from, to); }
+};
+
+using MemoryCrawler = Crawler<MemoryFetcher, LineExtractor, Canonicalizer, PageGraph>;
+
+void fill(MemoryFetcher& fetcher)
+{
+  fetcher.pages = {
+    {"https://a.test/", "https://a.test/one\nhttps://a.test/two\nhttps://b.test/\n"},
+    {"https://a.test/one", "https://a.test/two\nhttps://a.test/deep\n"},
+    {"https://a.test/two", "https://a.test/\n"},
+    {"https://a.test/deep", "https://a.test/deeper\n"},
+    {"https://a.test/deeper", ""},
+    {"https://b.test/", "https://a.test/\n"},
+  };
+}
+
+// every link of {graph}, by url
+auto url_links(PageGraph const& graph) -> std::set<std::pair<std::string, std::string>>
+{
+  std::set<std::pair<std::string, std::string>> out;
+  for(PageNode const& node : graph.nodes()) {
+    for(int child : node.children()) {
+      out.emplace(graph.get_url(node.index()), graph.get_url(child));
+    }
+  }
+  return out;
+}
+
+auto urls(PageGraph const& graph) -> std::set<std::string>
+{
+  std::set<std::string> out;
+  for(PageNode const& node : graph.nodes()) {
+    out.insert(graph.get_url(node.index()));
+  }
+  return out;
+}
+
+} // namespace
+
+TEST_CASE("Crawler walks an in-memory web to the requested depth")
+{
+  MemoryCrawler crawler;
+  crawler.set_verbose(false);
+  crawler.set_respect_robots(false);
+  fill(crawler.fetcher());
+
+  crawler.crawl("https://a.test/", 2);
+
+  PageGraph const& graph = crawler.graph();
+  CHECK(crawler.stats().pages_fetched == 1 + 3);
+  CHECK(graph.exists("https://a.test/deep"));     // found on a depth 1 page
+  CHECK_FALSE(graph.exists("https://a.test/deeper")); // one level too far
+  CHECK(crawler.fetcher().count("https://a.test/deep") == 0);
+
+  // every page is fetched once, however many link to it
+  CHECK(crawler.fetcher().count("https://a.test/") == 1);
+  CHECK(crawler.fetcher().count("https://a.test/two") == 1);
+
+  // links to known pages still become edges
+  PageNode const& root = graph.get_node(graph.get_index("https://a.test/"));
+  CHECK(root.children().size() == 3);
+  PageNode const& two = graph.get_node(graph.get_index("https://a.test/two"));
+  REQUIRE(two.children().size() == 1);
+  CHECK(two.children()[0] == root.index());
+}
+
+TEST_CASE("Crawler raises the depth of a queued page reached from a shallower one")
+{
+  MemoryCrawler crawler;
+  crawler.set_verbose(false);
+  crawler.set_respect_robots(false);
+  crawler.fetcher().pages = {
+    {"https://a.test/", "https://a.test/short\nhttps://a.test/a1\n"},
+    {"https://a.test/a1", "https://a.test/a2\n"},
+    {"https://a.test/a2", "https://a.test/target\n"},
+    {"https://a.test/short", "https://a.test/target\n"},
+    {"https://a.test/target", "https://a.test/leaf\n"},
+    {"https://a.test/leaf", ""},
+  };
+  // newest first, except the target, which waits until everything else is done
+  crawler.frontier().set_scorer([&](FrontierEntry const& entry, Frontier const&) {
+    return crawler.graph().get_url(entry.index).ends_with("/target") ? -1.0 : entry.index;
+  });
+
+  crawler.crawl("https://a.test/", 4);
+
+  PageGraph const& graph = crawler.graph();
+  CHECK(graph.get_node(graph.get_index("https://a.test/target")).depth() == 2);
+  CHECK(crawler.fetcher().count("https://a.test/leaf") == 1);
+}
+
+TEST_CASE("Crawler keeps out of scope links out of the graph")
+{
+  MemoryCrawler crawler;
+  crawler.set_verbose(false);
+  crawler.set_respect_robots(false);
+  fill(crawler.fetcher());
+  crawler.scope().allow_host("a.test");
+
+  crawler.crawl("https://a.test/", 3);
+
+  CHECK_FALSE(crawler.graph().exists("https://b.test/"));
+  CHECK(crawler.fetcher().count("https://b.test/") == 0);
+  CHECK(crawler.graph().exists("https://a.test/deeper"));
+}
+
+TEST_CASE("Crawler stops when the budget is spent")
+{
+  MemoryCrawler crawler;
+  crawler.set_verbose(false);
+  crawler.set_respect_robots(false);
+  fill(crawler.fetcher());
+  crawler.budget().max_pages = 2;
+
+  crawler.crawl("https://a.test/", 4);
+
+  CHECK(crawler.stats().pages_fetched == 2);
+  CHECK(crawler.fetcher().fetched.size() == 2);
+}
+
+TEST_CASE("Crawler follows robots.txt and sitemaps")
+{
+  MemoryCrawler crawler;
+  crawler.set_verbose(false);
+  MemoryFetcher& fetcher = crawler.fetcher();
+  fill(fetcher);
+  fetcher.pages["https://a.test/robots.txt"] =
+    "User-agent: *\n"
+    "Disallow: /two\n"
+    "Sitemap: https://a.test/sitemap.xml\n";
+  fetcher.pages["https://a.test/sitemap.xml"] =
+    "<urlset><url><loc>https://a.test/listed</loc></url><url><loc>https://a.test/two</loc></url></urlset>";
+  fetcher.pages["https://a.test/listed"] = "";
+
+  crawler.crawl("https://a.test/", 2);
+
+  CHECK(fetcher.count("https://a.test/robots.txt") == 1); // cached per origin
+  CHECK(fetcher.count("https://a.test/listed") == 1);
+  CHECK(fetcher.count("https://a.test/two") == 0);
+  CHECK(crawler.stats().disallowed == 1);
+
+  // b.test has no robots.txt, which allows everything
+  CHECK(fetcher.count("https://b.test/robots.txt") == 1);
+  CHECK(fetcher.count("https://b.test/") == 1);
+  CHECK(crawler.stats().extra_fetched == 3);
+
+  // sitemap pages hang off the root
+  PageGraph const& graph = crawler.graph();
+  PageNode const& root = graph.get_node(graph.get_index("https://a.test/"));
+  int listed = graph.get_index("https://a.test/listed");
+  CHECK(std::find(root.children().begin(), root.children().end(), listed) != root.children().end());
+}
+
+TEST_CASE("Crawler seeds a limited number of sitemap pages")
+{
+  MemoryCrawler crawler;
+  crawler.set_verbose(false);
+  crawler.set_max_sitemap_pages(2);
+  MemoryFetcher& fetcher = crawler.fetcher();
+  fetcher.pages["https://a.test/"] = "";
+  fetcher.pages["https://a.test/robots.txt"] = "Sitemap: https://a.test/sitemap.xml\n";
+  std::string sitemap = "<urlset>";
+  for(int i = 0; i < 10; ++i) {
+    sitemap += "<url><loc>https://a.test/" + std::to_string(i) + "</loc></url>";
+  }
+  fetcher.pages["https://a.test/sitemap.xml"] = sitemap + "</urlset>";
+
+  crawler.crawl("https://a.test/", 2);
+
+  CHECK(crawler.graph().node_count() == 3);
+  CHECK(fetcher.count("https://a.test/1") == 1);
+  CHECK_FALSE(crawler.graph().exists("https://a.test/2"));
+}
+
+TEST_CASE("Crawler merges duplicate pages when the extractor fingerprints them")
+{
+  Crawler<MemoryFetcher, FingerprintExtractor, Canonicalizer, PageGraph> crawler;
+  crawler.set_verbose(false);
+  crawler.set_respect_robots(false);
+  MemoryFetcher& fetcher = crawler.fetcher();
+  fetcher.pages = {
+    {"https://a.test/", "https://a.test/page\nhttps://a.test/print\n"},
+    {"https://a.test/page", "https://a.test/child\n"},
+    {"https://a.test/print", "https://a.test/child\n"},
+    {"https://a.test/child", ""},
+  };
+
+  crawler.crawl("https://a.test/", 3);
+
+  PageGraph const& graph = crawler.graph();
+  CHECK(crawler.stats().merged == 1);
+  int page = graph.get_index("https://a.test/page");
+  int print = graph.get_index("https://a.test/print");
+  CHECK(page == print); // the copy's url now leads to the original
+  CHECK(fetcher.count("https://a.test/child") == 1);
+}
+
+TEST_CASE("Crawler reuses the links of unchanged pages from the page cache")
+{
+  std::filesystem::path path = std::filesystem::temp_directory_path() / "crawler-refresh-test.txt";
+  std::filesystem::remove(path);
+
+  auto crawl = [&](std::string const& changed) {
+    Crawler<ConditionalFetcher, LineExtractor, Canonicalizer, PageGraph> crawler;
+    crawler.set_verbose(false);
+    crawler.set_respect_robots(false);
+    crawler.set_cache(std::make_unique<PageCache>(path));
+    ConditionalFetcher& fetcher = crawler.fetcher();
+    fill(fetcher);
+    for(auto const& [url, content] : fetcher.pages) {
+      fetcher.etags[url] = url == changed ? "\"2\"" : "\"1\"";
+    }
+    if(!changed.empty()) {
+      fetcher.pages[changed] += "https://a.test/new\n";
+    }
+
+    LineExtractor::parsed = 0;
+    crawler.crawl("https://a.test/", 3);
+    crawler.cache()->save();
+    return std::make_pair(crawler.stats(), crawler.graph().node_count());
+  };
+
+  auto [first, first_nodes] = crawl("");
+  CHECK(first.not_modified == 0);
+  CHECK(LineExtractor::parsed == 5);
+
+  // nothing changed: every page answers 304 and the same graph comes out
+  auto [second, second_nodes] = crawl("");
+  CHECK(second.not_modified == 5);
+  CHECK(LineExtractor::parsed == 0);
+  CHECK(second_nodes == first_nodes);
+
+  // only the changed page is parsed again, and its new link is followed
+  auto [third, third_nodes] = crawl("https://a.test/one");
+  CHECK(third.not_modified == 4);
+  CHECK(LineExtractor::parsed == 1);
+  CHECK(third_nodes == first_nodes + 1);
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("Crawler keeps duplicates merged across cached crawls")
+{
+  std::filesystem::path path = std::filesystem::temp_directory_path() / "crawler-refresh-duplicates-test.txt";
+  std::filesystem::remove(path);
+
+  auto crawl = [&](std::string const& etag) {
+    Crawler<ConditionalFetcher, FingerprintExtractor, Canonicalizer, PageGraph> crawler;
+    crawler.set_verbose(false);
+    crawler.set_respect_robots(false);
+    crawler.set_cache(std::make_unique<PageCache>(path));
+    ConditionalFetcher& fetcher = crawler.fetcher();
+    fetcher.pages = {
+      {"https://a.test/", "https://a.test/page\nhttps://a.test/print\n"},
+      {"https://a.test/page", "https://a.test/child\n"},
+      {"https://a.test/print", "https://a.test/child\n"},
+      {"https://a.test/child", ""},
+    };
+    for(auto const& [url, content] : fetcher.pages) {
+      fetcher.etags[url] = etag;
+    }
+
+    crawler.crawl("https://a.test/", 3);
+    crawler.cache()->save();
+
+    PageGraph const& graph = crawler.graph();
+    CHECK(crawler.stats().merged == 1);
+    CHECK(graph.get_index("https://a.test/page") == graph.get_index("https://a.test/print"));
+    CHECK(fetcher.count("https://a.test/child") == 1);
+    return crawler.stats();
+  };
+
+  CrawlStats first = crawl("\"1\"");
+  CHECK(first.not_modified == 0);
+
+  // 304s: the copy is merged from its cached fingerprint
+  CrawlStats second = crawl("\"1\"");
+  CHECK(second.not_modified == 4);
+
+  // same bodies under new etags, which are kept for the next crawl
+  CrawlStats third = crawl("\"2\"");
+  CHECK(third.unchanged == 4);
+  CrawlStats fourth = crawl("\"2\"");
+  CHECK(fourth.not_modified == 4);
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("Crawler tells its listener about every page, link and status")
+{
+  MemoryCrawler crawler;
+  crawler.set_verbose(false);
+  crawler.set_respect_robots(false);
+  fill(crawler.fetcher());
+  crawler.fetcher().pages.erase("https://b.test/");
+  RecordingListener listener;
+  crawler.set_listener(&listener);
+
+  crawler.crawl("https://a.test/", 2);
+
+  PageGraph const& graph = crawler.graph();
+  CHECK(static_cast<int>(listener.pages.size()) == graph.node_count());
+  CHECK((listener.pages.front() == std::pair<int, std::string>{0, "https://a.test/"}));
+
+  std::size_t edges = 0;
+  for(PageNode const& node : graph.nodes()) {
+    edges += node.children().size();
+  }
+  CHECK(listener.links.size() == edges);
+
+  CHECK(listener.status[graph.get_index("https://a.test/")] == PageStatus::fetched);
+  CHECK(listener.status[graph.get_index("https://b.test/")] == PageStatus::failed);
+  CHECK_FALSE(listener.status.contains(graph.get_index("https://a.test/deep"))); // found, never fetched
+}
+
+TEST_CASE("Crawler rebuilds the crawled graph from its archive, robots.txt and sitemaps aside")
+{
+  std::filesystem::path dir = std::filesystem::temp_directory_path() / "crawler-rebuild-test";
+  std::filesystem::remove_all(dir);
+
+  Crawler<ArchivingFetcher, LineExtractor, Canonicalizer, PageGraph> crawler;
+  crawler.set_verbose(false);
+  ArchivingFetcher& fetcher = crawler.fetcher();
+  fill(fetcher);
+  fetcher.pages["https://a.test/robots.txt"] = "User-agent: *\nSitemap: https://a.test/sitemap.xml\n";
+  fetcher.pages["https://a.test/sitemap.xml"] = "<urlset><url><loc>https://a.test/one</loc></url></urlset>";
+  fetcher.archive = std::make_unique<ArchiveWriter>(dir / "crawl.warc");
+
+  crawler.crawl("https://a.test/", 2);
+  fetcher.archive.reset();
+
+  ArchiveReader archive(dir / "crawl.warc");
+  std::vector<int> kinds(4);
+  for(std::size_t i = 0; i < archive.size(); ++i) {
+    ++kinds[static_cast<std::size_t>(archive.record(i).kind)];
+  }
+  CHECK(kinds[static_cast<std::size_t>(RecordKind::page)] == 4);
+  CHECK(kinds[static_cast<std::size_t>(RecordKind::robots)] == 2); // b.test has none, archived as a 404
+  CHECK(kinds[static_cast<std::size_t>(RecordKind::sitemap)] == 1);
+
+  MemoryCrawler rebuilt;
+  rebuilt.set_verbose(false);
+  CHECK(rebuilt.rebuild(archive, 2) == 4);
+  CHECK(urls(rebuilt.graph()) == urls(crawler.graph()));
+  CHECK(url_links(rebuilt.graph()) == url_links(crawler.graph()));
+
+  std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,142 @@
+#include "fetcher.hpp" // The header you're testing
+
+#include <doctest/doctest.h>
+//
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+//
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+// http on 127.0.0.1 that leaves its first connection hanging and answers
+// every later one right away
+class SlowServer
+{
+public:
+  SlowServer()
+  {
+    m_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    REQUIRE(::bind(m_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+    REQUIRE(::listen(m_fd, 8) == 0);
+    socklen_t length = sizeof(address);
+    ::getsockname(m_fd, reinterpret_cast<sockaddr*>(&address), &length);
+    m_port = ntohs(address.sin_port);
+    m_thread = std::thread([this]() { serve(); });
+  }
+
+  ~SlowServer()
+  {
+    m_stop = true;
+    m_thread.join();
+    ::close(m_fd);
+  }
+
+  auto url() const -> std::string { return "http://127.0.0.1:" + std::to_string(m_port) + "/"; }
+  auto connections() const -> int { return m_connections.load(); }
+  auto slow_closed() const -> bool { return m_slow_closed.load(); } // the client hung up on the slow one
+
+private:
+  void serve()
+  {
+    std::vector<std::thread> handlers;
+    while(!m_stop) {
+      pollfd fd{.fd = m_fd, .events = POLLIN};
+      if(::poll(&fd, 1, 20) <= 0) {
+        continue;
+      }
+      int client = ::accept(m_fd, nullptr, nullptr);
+      if(client < 0) {
+        continue;
+      }
+      bool slow = m_connections++ == 0;
+      handlers.emplace_back([this, client, slow]() { handle(client, slow); });
+    }
+    for(std::thread& handler : handlers) {
+      handler.join();
+    }
+  }
+
+  void handle(int client, bool slow)
+  {
+    std::string request;
+    char buffer[4096];
+    while(request.find("\r\n\r\n") == std::string::npos) {
+      ssize_t received = ::recv(client, buffer, sizeof(buffer), 0);
+      if(received <= 0) {
+        ::close(client);
+        return;
+      }
+      request.append(buffer, static_cast<std::size_t>(received));
+    }
+
+    if(slow) {
+      // never answers, only waits to see the client give up on it
+      auto deadline = std::chrono::steady_clock::now() + 3s;
+      while(!m_stop && std::chrono::steady_clock::now() < deadline) {
+        pollfd fd{.fd = client, .events = POLLIN};
+        if(::poll(&fd, 1, 20) > 0 && ::recv(client, buffer, sizeof(buffer), 0) <= 0) {
+          m_slow_closed = true;
+          break;
+        }
+      }
+    } else {
+      std::string response = "HTTP/1.1 200 OK\r\nContent-Length: 4\r\nConnection: close\r\n\r\nfast";
+      ::send(client, response.data(), response.size(), MSG_NOSIGNAL);
+    }
+    ::close(client);
+  }
+
+  int m_fd = -1;
+  std::uint16_t m_port{};
+  std::atomic<int> m_connections{0};
+  std::atomic<bool> m_slow_closed{false};
+  std::atomic<bool> m_stop{false};
+  std::thread m_thread;
+};
+
+} // namespace
+
+TEST_CASE("CurlFetcher hedges a slow request and drops the loser")
+{
+  SlowServer server;
+  CurlFetcher fetcher;
+  fetcher.set_hedging(true);
+  for(int i = 0; i < 3; ++i) {
+    fetcher.latency().record("127.0.0.1", 20ms);
+  }
+
+  CurlFetcher::Response response;
+  auto started = std::chrono::steady_clock::now();
+  fetcher.fetch(server.url(), response);
+  auto elapsed = std::chrono::steady_clock::now() - started;
+
+  CHECK(response.second == "fast");
+  CHECK(fetcher.hedged() == 1);
+  CHECK(server.connections() == 2);
+  CHECK(elapsed < 1s); // long before the slow copy would time out
+
+  // the slow copy's handle is gone, and its connection with it
+  for(int i = 0; i < 100 && !server.slow_closed(); ++i) {
+    std::this_thread::sleep_for(10ms);
+  }
+  CHECK(server.slow_closed());
+
+  // the fetcher carries on as usual
+  fetcher.set_hedging(false);
+  fetcher.fetch(server.url(), response);
+  CHECK(response.second == "fast");
+  CHECK(fetcher.hedged() == 1);
+}
@@ -0,0 +1,171 @@
+#include "frontier.hpp" // The header you're testing
+
+#include <doctest/doctest.h>
+
+TEST_CASE("frontier pops the most linked page first")
+{
+  Frontier frontier;
+  frontier.push(0, 2, "a.test");
+  frontier.push(1, 2, "b.test");
+  frontier.push(2, 2, "c.test");
+
+  frontier.add_in_link(1);
+  frontier.add_in_link(1);
+  frontier.add_in_link(2);
+
+  CHECK(frontier.size() == 3);
+  CHECK(frontier.pop()->index == 1);
+  CHECK(frontier.pop()->index == 2);
+  CHECK(frontier.pop()->index == 0);
+  CHECK(frontier.empty());
+  CHECK_FALSE(frontier.pop().has_value());
+}
+
+TEST_CASE("frontier pushes of a queued page count as links")
+{
+  Frontier frontier;
+  frontier.push(5, 1, "a.test");
+  frontier.push(6, 1, "a.test");
+  frontier.push(6, 1, "a.test");
+
+  CHECK(frontier.size() == 2);
+  std::optional<FrontierEntry> top = frontier.pop();
+  CHECK(top->index == 6);
+  CHECK(top->in_links == 2);
+  CHECK_FALSE(frontier.contains(6));
+
+  frontier.add_in_link(6); // already popped, ignored
+  CHECK(frontier.size() == 1);
+}
+
+TEST_CASE("frontier keeps the larger depth of a page reached twice")
+{
+  Frontier frontier([](FrontierEntry const& entry, Frontier const&) { return -entry.index; });
+  frontier.push(0, 1, "a.test");
+  frontier.push(1, 1, "a.test");
+  frontier.push(1, 3, "a.test"); // found again from a shallower page
+  frontier.add_in_link(0, 4);
+  frontier.add_in_link(0, 2); // deeper, the depth stays
+
+  std::optional<FrontierEntry> first = frontier.pop();
+  std::optional<FrontierEntry> second = frontier.pop();
+  CHECK(first->index == 0);
+  CHECK(first->depth == 4);
+  CHECK(first->in_links == 3);
+  CHECK(second->depth == 3);
+}
+
+TEST_CASE("frontier keeps the links of a deferred entry")
+{
+  Frontier frontier;
+  frontier.push(0, 1, "a.test");
+  frontier.push(0, 1, "a.test");
+  frontier.push(0, 1, "a.test");
+  frontier.push(1, 1, "b.test");
+  frontier.push(1, 1, "b.test");
+
+  std::optional<FrontierEntry> entry = frontier.pop();
+  REQUIRE(entry->index == 0);
+  frontier.defer(*entry);
+  CHECK(frontier.size() == 2);
+
+  std::optional<FrontierEntry> again = frontier.pop();
+  CHECK(again->index == 0);
+  CHECK(again->in_links == 3);
+}
+
+TEST_CASE("frontier prefers shallow pages on equal links")
+{
+  Frontier frontier;
+  frontier.push(0, 1, "a.test");
+  frontier.push(1, 3, "b.test");
+  CHECK(frontier.pop()->index == 1);
+}
+
+TEST_CASE("frontier spreads fetches across hosts")
+{
+  Frontier frontier;
+  for(int i = 0; i < 4; ++i) {
+    frontier.push(i, 1, "busy.test");
+  }
+  frontier.push(10, 1, "quiet.test");
+  frontier.push(11, 1, "other.test");
+
+  // the first pick is arbitrary, but after it every host gets a turn
+  // before busy.test is visited again
+  std::vector<int> order;
+  while(auto entry = frontier.pop()) {
+    order.push_back(entry->index);
+  }
+
+  REQUIRE(order.size() == 6);
+  int busy_in_first_three = 0;
+  for(int i = 0; i < 3; ++i) {
+    busy_in_first_three += order[i] < 4;
+  }
+  CHECK(busy_in_first_three == 1);
+}
+
+TEST_CASE("frontier accepts a custom scorer")
+{
+  Frontier frontier([](FrontierEntry const& entry, Frontier const&) { return -entry.index; });
+  for(int i : {3, 1, 2}) {
+    frontier.push(i, 1, "a.test");
+  }
+  CHECK(frontier.pop()->index == 1);
+  CHECK(frontier.pop()->index == 2);
+  CHECK(frontier.pop()->index == 3);
+}
+
+TEST_CASE("frontier pops around entries that are not ready")
+{
+  Frontier frontier([](FrontierEntry const& entry, Frontier const&) { return -entry.index; });
+  for(int i : {0, 1, 2, 3}) {
+    frontier.push(i, 1, "a.test");
+  }
+
+  // passed over entries stay queued, in order
+  CHECK(frontier.pop_ready([](FrontierEntry const& entry) { return entry.index >= 2; }, 8)->index == 2);
+  CHECK_FALSE(frontier.pop_ready([](FrontierEntry const& entry) { return entry.index >= 3; }, 2).has_value());
+  CHECK(frontier.size() == 3);
+  CHECK(frontier.pop()->index == 0);
+  CHECK(frontier.pop()->index == 1);
+  CHECK(frontier.pop()->index == 3);
+}
+
+TEST_CASE("frontier keeps its heap consistent")
+{
+  Frontier frontier([](FrontierEntry const& entry, Frontier const&) { return entry.in_links * 1000 - entry.index; });
+  for(int i = 0; i < 200; ++i) {
+    frontier.push(i, 1, "a.test");
+  }
+  for(int i = 0; i < 200; i += 3) {
+    frontier.add_in_link(i);
+  }
+
+  double last = 1e18;
+  int count = 0;
+  while(auto entry = frontier.pop()) {
+    CHECK(entry->score <= last);
+    last = entry->score;
+    ++count;
+  }
+  CHECK(count == 200);
+}
+
+TEST_CASE("crawl budget")
+{
+  CrawlBudget unlimited;
+  CHECK_FALSE(unlimited.exhausted(1'000'000, 1ull << 40, std::chrono::hours(100)));
+
+  CrawlBudget pages{.max_pages = 10};
+  CHECK_FALSE(pages.exhausted(9, 0, {}));
+  CHECK(pages.exhausted(10, 0, {}));
+
+  CrawlBudget bytes{.max_bytes = 1024};
+  CHECK(bytes.exhausted(0, 2048, {}));
+
+  CrawlBudget time{.max_time = std::chrono::seconds(1)};
+  CHECK_FALSE(time.exhausted(0, 0, std::chrono::milliseconds(10)));
+  CHECK(time.exhausted(0, 0, std::chrono::seconds(2)));
+}
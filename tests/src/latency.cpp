@@ -0,0 +1,87 @@
+#include "latency.hpp" // The header you're testing
+
+#include <doctest/doctest.h>
+
+using namespace std::chrono_literals;
+
+TEST_CASE("latency unseen hosts use the default timeouts")
+{
+  LatencyTracker tracker;
+  CHECK(tracker.timeout("a.test") == 10000ms);
+  CHECK(tracker.connect_timeout("a.test") == 5000ms);
+  CHECK_FALSE(tracker.hedge_delay("a.test").has_value());
+  CHECK_FALSE(tracker.stats("a.test").has_value());
+}
+
+TEST_CASE("latency timeouts follow a fast host down to the floor")
+{
+  LatencyTracker tracker;
+  for(int i = 0; i < 20; ++i) {
+    tracker.record("fast.test", 100ms);
+  }
+
+  auto stats = tracker.stats("fast.test");
+  REQUIRE(stats.has_value());
+  CHECK(stats->samples == 20);
+  CHECK(stats->mean_ms == doctest::Approx(100.0));
+  CHECK(tracker.timeout("fast.test") == 2000ms);
+  CHECK(tracker.connect_timeout("fast.test") == 1000ms);
+  CHECK(tracker.timeout("slow.test") == 10000ms); // hosts are tracked apart
+}
+
+TEST_CASE("latency variance widens the timeout")
+{
+  LatencyTracker steady;
+  LatencyTracker jittery;
+  for(int i = 0; i < 20; ++i) {
+    steady.record("a.test", 3000ms);
+    jittery.record("a.test", i % 2 ? 1000ms : 5000ms);
+  }
+
+  CHECK(steady.timeout("a.test") < jittery.timeout("a.test"));
+  CHECK(jittery.timeout("a.test") <= 10000ms);
+}
+
+TEST_CASE("latency timeouts raise the mean, not the timeout")
+{
+  LatencyTracker tracker;
+  tracker.record("a.test", 3000ms);
+  auto before = tracker.timeout("a.test");
+  double mean = tracker.stats("a.test")->mean_ms;
+
+  tracker.record_timeout("a.test");
+  CHECK(tracker.stats("a.test")->mean_ms > mean);
+  CHECK(tracker.timeout("a.test") <= before);
+}
+
+TEST_CASE("latency a timed out host never waits longer than the fixed timeout did")
+{
+  constexpr auto baseline = 10000ms;
+
+  LatencyTracker fresh;
+  for(int i = 0; i < 10; ++i) {
+    fresh.record_timeout("new.test");
+    CHECK(fresh.timeout("new.test") <= baseline);
+  }
+
+  LatencyTracker slow;
+  for(int i = 0; i < 20; ++i) {
+    slow.record("slow.test", i % 2 ? 9000ms : 200ms);
+    slow.record_timeout("slow.test");
+    CHECK(slow.timeout("slow.test") <= baseline);
+  }
+}
+
+TEST_CASE("latency hedges after enough samples, before the timeout")
+{
+  LatencyTracker tracker;
+  tracker.record("a.test", 400ms);
+  tracker.record("a.test", 600ms);
+  CHECK_FALSE(tracker.hedge_delay("a.test").has_value());
+
+  tracker.record("a.test", 500ms);
+  auto delay = tracker.hedge_delay("a.test");
+  REQUIRE(delay.has_value());
+  CHECK(*delay > 500ms);
+  CHECK(*delay <= tracker.timeout("a.test"));
+}
@@ -0,0 +1,187 @@
+#include "live_view.hpp" // The header you're testing
+
+#include <doctest/doctest.h>
+//
+#include <chrono>
+#include <string>
+//
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+// a plain http client on 127.0.0.1, reading until it has seen what it waits for
+class TestClient
+{
+public:
+  TestClient(std::uint16_t port, std::string_view path)
+  {
+    m_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    REQUIRE(::connect(m_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+
+    std::string request = "GET " + std::string(path) + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    ::send(m_fd, request.data(), request.size(), 0);
+  }
+
+  ~TestClient() { ::close(m_fd); }
+
+  // false if {text} did not show up in time
+  auto wait_for(std::string_view text, std::chrono::milliseconds timeout = 3000ms) -> bool
+  {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while(m_received.find(text) == std::string::npos) {
+      auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+      pollfd fd{.fd = m_fd, .events = POLLIN};
+      if(left.count() <= 0 || ::poll(&fd, 1, static_cast<int>(left.count())) <= 0) {
+        return false;
+      }
+      char buffer[4096];
+      ssize_t received = ::recv(m_fd, buffer, sizeof(buffer), 0);
+      if(received <= 0) {
+        return m_received.find(text) != std::string::npos;
+      }
+      m_received.append(buffer, static_cast<std::size_t>(received));
+    }
+    return true;
+  }
+
+  auto received() const -> std::string const& { return m_received; }
+
+private:
+  int m_fd = -1;
+  std::string m_received;
+};
+
+auto test_options() -> LiveView::Options
+{
+  return LiveView::Options{.port = 0, .interval = 20ms};
+}
+
+} // namespace
+
+TEST_CASE("GraphDeltas keeps only the latest status of a page")
+{
+  GraphDeltas deltas;
+  deltas.page(0, "https://a.test/", 2);
+  deltas.link(0, 1);
+  deltas.status(0, PageStatus::retrying);
+  deltas.status(0, PageStatus::fetched); // folded into the new page
+  deltas.status(7, PageStatus::failed);
+  deltas.status(7, PageStatus::merged); // a page from an earlier batch
+
+  CHECK(deltas.pages() == 1);
+  CHECK(deltas.statuses() == 1);
+  CHECK(deltas.links() == 1);
+  CHECK(deltas.to_json() == R"({"pages":[[0,"https://a.test/",2,1]],"status":[[7,5]],"links":[[0,1]]})");
+
+  deltas.clear();
+  CHECK(deltas.empty());
+  CHECK(deltas.to_json() == R"({"pages":[],"status":[],"links":[]})");
+}
+
+TEST_CASE("GraphDeltas escapes urls and ignores pages it already holds")
+{
+  GraphDeltas deltas;
+  deltas.page(3, "https://a.test/\"q\"\\\n", 1);
+  deltas.page(3, "https://a.test/other", 0);
+  CHECK(deltas.to_json() == R"({"pages":[[3,"https://a.test/\"q\"\\\n",1,0]],"status":[],"links":[]})");
+}
+
+TEST_CASE("GraphDeltas holds a link once")
+{
+  GraphDeltas seen;
+  GraphDeltas batch;
+  batch.link(0, 1);
+  batch.link(0, 1);
+  batch.link(1, 0);
+  CHECK(batch.links() == 2);
+
+  seen.append(batch);
+  seen.append(batch); // linked again in a later batch
+  CHECK(seen.links() == 2);
+  CHECK(seen.to_json() == R"({"pages":[],"status":[],"links":[[0,1],[1,0]]})");
+
+  batch.clear();
+  batch.link(0, 1);
+  CHECK(batch.links() == 1);
+}
+
+TEST_CASE("GraphDeltas append builds the whole graph from batches")
+{
+  GraphDeltas seen;
+  GraphDeltas batch;
+  batch.page(0, "https://a.test/", 2);
+  batch.page(1, "https://a.test/one", 1);
+  batch.link(0, 1);
+  seen.append(batch);
+
+  batch.clear();
+  batch.status(0, PageStatus::fetched);
+  batch.status(1, PageStatus::failed);
+  batch.page(2, "https://a.test/two", 1);
+  batch.link(0, 2);
+  seen.append(batch);
+
+  // statuses land on the pages, nothing is left over
+  CHECK(seen.pages() == 3);
+  CHECK(seen.statuses() == 0);
+  CHECK(seen.links() == 2);
+  CHECK(seen.to_json() ==
+    R"({"pages":[[0,"https://a.test/",2,1],[1,"https://a.test/one",1,4],[2,"https://a.test/two",1,0]],"status":[],"links":[[0,1],[0,2]]})");
+}
+
+TEST_CASE("LiveView serves the viewer and answers 404 otherwise")
+{
+  LiveView live(test_options());
+  CHECK(live.port() != 0);
+  CHECK(live.url() == "http://127.0.0.1:" + std::to_string(live.port()) + "/");
+
+  TestClient page(live.port(), "/");
+  REQUIRE(page.wait_for("</html>"));
+  CHECK(page.received().starts_with("HTTP/1.1 200 OK\r\n"));
+  CHECK(page.received().find("new EventSource('events')") != std::string::npos);
+
+  TestClient missing(live.port(), "/nothing");
+  REQUIRE(missing.wait_for("not found"));
+  CHECK(missing.received().starts_with("HTTP/1.1 404"));
+
+  // headers that never end are cut off
+  TestClient endless(live.port(), "/" + std::string(64 << 10, 'x'));
+  REQUIRE(endless.wait_for("request too large"));
+  CHECK(endless.received().starts_with("HTTP/1.1 400"));
+}
+
+TEST_CASE("LiveView streams a snapshot, then batches of changes")
+{
+  LiveView live(test_options());
+  live.page_added(0, "https://a.test/", 2);
+  live.page_status(0, PageStatus::fetched);
+
+  // a batch goes out before the viewer connects, so the snapshot has it
+  for(int i = 0; i < 100 && live.batches() == 0; ++i) {
+    std::this_thread::sleep_for(10ms);
+  }
+  REQUIRE(live.batches() == 1);
+
+  TestClient viewer(live.port(), "/events");
+  REQUIRE(viewer.wait_for("event: snapshot\ndata: {\"pages\":[[0,\"https://a.test/\",2,1]]"));
+  CHECK(viewer.received().find("Content-Type: text/event-stream") != std::string::npos);
+
+  // many updates in one interval make a single event
+  live.page_added(1, "https://a.test/one", 1);
+  live.link_added(0, 1);
+  for(int i = 0; i < 50; ++i) {
+    live.page_status(1, i % 2 ? PageStatus::retrying : PageStatus::failed);
+  }
+  REQUIRE(viewer.wait_for("data: {\"pages\":[[1,\"https://a.test/one\",1,3]],\"status\":[],\"links\":[[0,1]]}\n\n"));
+  CHECK(live.viewers() == 1);
+}
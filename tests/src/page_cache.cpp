@@ -0,0 +1,82 @@
+#include "page_cache.hpp" // The header you're testing
+
+#include <doctest/doctest.h>
+#include <filesystem>
+#include <fstream>
+
+TEST_CASE("parse_validators reads ETag and Last-Modified")
+{
+  Validators validators = parse_validators(
+    "HTTP/2 200\r\n"
+    "content-type: text/html\r\n"
+    "ETag: \"33a64df5\"\r\n"
+    "last-modified:  Wed, 21 Oct 2015 07:28:00 GMT \r\n"
+    "\r\n");
+
+  CHECK(validators.etag == "\"33a64df5\"");
+  CHECK(validators.last_modified == "Wed, 21 Oct 2015 07:28:00 GMT");
+  CHECK(parse_validators("HTTP/1.1 200 OK\r\n\r\n").empty());
+}
+
+TEST_CASE("PageCache survives a save and a load")
+{
+  std::filesystem::path path = std::filesystem::temp_directory_path() / "crawler-page-cache-test" / "cache.txt";
+  std::filesystem::remove_all(path.parent_path());
+
+  {
+    PageCache cache(path);
+    CHECK(cache.size() == 0);
+    cache.store("https://a.test/", CachedPage{
+      .final_url = "https://a.test/home",
+      .validators = {.etag = "W/\"1\"", .last_modified = "Wed, 21 Oct 2015 07:28:00 GMT"},
+      .content_hash = 1234567890123ull,
+      .fingerprint = {.exact = 11, .simhash = 0xF0F0F0F0F0F0F0F0ull, .words = 40},
+      .links = {"https://a.test/one", "https://b.test/"},
+    });
+    cache.store("https://a.test/empty", CachedPage{.final_url = "https://a.test/empty", .duplicate_of = "https://a.test/"});
+    cache.save();
+  }
+
+  PageCache cache(path);
+  REQUIRE(cache.size() == 2);
+  CachedPage const* page = cache.find("https://a.test/");
+  REQUIRE(page != nullptr);
+  CHECK(page->final_url == "https://a.test/home");
+  CHECK(page->validators.etag == "W/\"1\"");
+  CHECK(page->validators.last_modified == "Wed, 21 Oct 2015 07:28:00 GMT");
+  CHECK(page->content_hash == 1234567890123ull);
+  CHECK(page->fingerprint.exact == 11);
+  CHECK(page->fingerprint.simhash == 0xF0F0F0F0F0F0F0F0ull);
+  CHECK(page->fingerprint.words == 40);
+  CHECK(page->duplicate_of.empty());
+  CHECK((page->links == std::vector<std::string>{"https://a.test/one", "https://b.test/"}));
+  CHECK(cache.find("https://a.test/empty")->links.empty());
+  CHECK(cache.find("https://a.test/empty")->duplicate_of == "https://a.test/");
+  CHECK(cache.find("https://a.test/missing") == nullptr);
+
+  std::filesystem::remove_all(path.parent_path());
+}
+
+TEST_CASE("PageCache refuses a line with missing fields")
+{
+  std::filesystem::path path = std::filesystem::temp_directory_path() / "crawler-page-cache-short.txt";
+  {
+    std::ofstream out(path);
+    out << "1\nhttps://a.test/\thttps://a.test/\t\"1\"\t\t7\t1\nhttps://a.test/one\n";
+  }
+
+  CHECK_THROWS_AS(PageCache{path}, std::runtime_error);
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("PageCache refuses a truncated file")
+{
+  std::filesystem::path path = std::filesystem::temp_directory_path() / "crawler-page-cache-truncated.txt";
+  {
+    std::ofstream out(path);
+    out << "2\nhttps://a.test/\thttps://a.test/\t\t\t1\t0\t0\t0\t\t3\nhttps://a.test/one\n";
+  }
+
+  CHECK_THROWS_AS(PageCache{path}, std::runtime_error);
+  std::filesystem::remove(path);
+}
@@ -0,0 +1,81 @@
+#include "page_graph.hpp" // The header you're testing
+
+#include <doctest/doctest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("PageGraph adds nodes and links")
+{
+  PageGraph graph;
+  int root = graph.add_node("https://a.test/", 2);
+  int child = graph.add_node("https://a.test/b", 1);
+  graph.add_link(root, child);
+
+  CHECK(graph.add_node("https://a.test/b", 0) == child);
+  CHECK(graph.node_count() == 2);
+  CHECK(graph.get_node(child).depth() == 1);
+  CHECK(graph.get_index("https://a.test/b") == child);
+  CHECK_THROWS_AS(graph.get_index("https://a.test/c"), std::out_of_range);
+  CHECK(graph.get_node(root).children() == std::vector<int>{child});
+
+  graph.merge(child, root);
+  CHECK(graph.find("https://a.test/b") == root);
+  CHECK(graph.resolve_node(child) == root);
+}
+
+TEST_CASE("PageGraph commits links interned by many threads")
+{
+  constexpr int threads = 4;
+  constexpr int pages = 500;
+  PageGraph graph;
+
+  // page n links to n + 1 and n + 2, each thread parses every 4th page
+  std::vector<std::thread> pool;
+  for(int t = 0; t < threads; ++t) {
+    pool.emplace_back([&, t]() {
+      EdgeBuffer edges;
+      for(int n = t; n < pages; n += threads) {
+        int index = graph.intern("https://a.test/" + std::to_string(n), 1, edges);
+        edges.link(index, graph.intern("https://a.test/" + std::to_string(n + 1), 0, edges));
+        edges.link(index, graph.intern("https://a.test/" + std::to_string(n + 2), 0, edges));
+        if(edges.size() >= 64) {
+          graph.commit(edges);
+        }
+      }
+      graph.commit(edges);
+      CHECK(edges.empty());
+    });
+  }
+  for(std::thread& thread : pool) {
+    thread.join();
+  }
+
+  CHECK(graph.node_count() == pages + 2);
+  for(int n = 0; n < pages; ++n) {
+    PageNode const& node = graph.get_node(graph.get_index("https://a.test/" + std::to_string(n)));
+    REQUIRE(node.children().size() == 2);
+    CHECK(graph.get_url(node.children()[0]) == "https://a.test/" + std::to_string(n + 1));
+    CHECK(graph.get_url(node.children()[1]) == "https://a.test/" + std::to_string(n + 2));
+  }
+  CHECK(graph.get_node(graph.get_index("https://a.test/501")).children().empty());
+}
+
+TEST_CASE("PageGraph keeps merged duplicates through an export")
+{
+  PageGraph graph;
+  int root = graph.add_node("https://a.test/", 2);
+  int page = graph.add_node("https://a.test/page", 1);
+  int print = graph.add_node("https://a.test/print", 1);
+  graph.add_link(root, page);
+  graph.add_link(root, print);
+  graph.merge(print, page);
+
+  ShardGraph exported = graph.export_graph();
+  CHECK((exported.merged == std::vector<std::pair<int, int>>{{print, page}}));
+
+  PageGraph loaded;
+  loaded.load_graph(exported);
+  CHECK(loaded.get_node(print).duplicate_of() == page);
+  CHECK(loaded.find("https://a.test/print") == page);
+}
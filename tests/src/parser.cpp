@@ -0,0 +1,234 @@
+#include "parser.hpp" // The header you're testing
+
+#include <doctest/doctest.h>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+//
+#include <curl/curl.h>
+#include <lexbor/core/lexbor.h>
+
+// counts every allocation of the test binary: operator new, plus the
+// mallocs of curl and lexbor, routed here by their allocator hooks
+static std::atomic<std::size_t> allocations{0};
+static std::atomic<std::size_t> lexbor_allocations{0};
+
+void* operator new(std::size_t size)
+{
+  ++allocations;
+  if(void* ptr = std::malloc(size ? size : 1)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace {
+
+void* counted_malloc(std::size_t size)
+{
+  ++allocations;
+  return std::malloc(size);
+}
+
+void* counted_calloc(std::size_t count, std::size_t size)
+{
+  ++allocations;
+  return std::calloc(count, size);
+}
+
+void* counted_realloc(void* ptr, std::size_t size)
+{
+  ++allocations;
+  return std::realloc(ptr, size);
+}
+
+char* counted_strdup(char const* text)
+{
+  ++allocations;
+  return strdup(text);
+}
+
+void* lexbor_malloc_hook(std::size_t size)
+{
+  ++lexbor_allocations;
+  return std::malloc(size);
+}
+
+void* lexbor_calloc_hook(std::size_t count, std::size_t size)
+{
+  ++lexbor_allocations;
+  return std::calloc(count, size);
+}
+
+void* lexbor_realloc_hook(void* ptr, std::size_t size)
+{
+  ++lexbor_allocations;
+  return std::realloc(ptr, size);
+}
+
+void lexbor_free_hook(void* ptr)
+{
+  std::free(ptr);
+}
+
+// before main, so ahead of any curl or lexbor use
+bool const hooks_installed = []() {
+  bool curl = curl_global_init_mem(CURL_GLOBAL_DEFAULT, counted_malloc, std::free, counted_realloc, counted_strdup, counted_calloc) == CURLE_OK;
+  bool lexbor = lexbor_memory_setup(lexbor_malloc_hook, lexbor_realloc_hook, lexbor_calloc_hook, lexbor_free_hook) == LXB_STATUS_OK;
+  return curl && lexbor;
+}();
+
+} // namespace
+
+namespace {
+
+std::string sample_page(int links)
+{
+  std::string html = "<html><head><title>t</title></head><body><ul>";
+  for(int i = 0; i < links; ++i) {
+    // relative, absolute, with query and fragment, and some duplicates
+    html += "<li><a href=\"/wiki/Page_" + std::to_string(i % (links / 2)) + "\">x</a></li>";
+    html += "<li><a href=\"https://other.test/p" + std::to_string(i) + "?q=1#frag\">y</a></li>";
+  }
+  return html + "</ul></body></html>";
+}
+
+} // namespace
+
+TEST_CASE("LinkBuffer deduplicates in insertion order")
+{
+  LinkBuffer buffer;
+  for(std::string link : {"b", "a", "b", "c", "a"}) {
+    buffer.next() = link;
+    buffer.commit();
+  }
+
+  REQUIRE(buffer.size() == 3);
+  CHECK(buffer[0] == "b");
+  CHECK(buffer[1] == "a");
+  CHECK(buffer[2] == "c");
+
+  buffer.clear();
+  CHECK(buffer.empty());
+  buffer.next() = "a";
+  CHECK(buffer.commit());
+  CHECK(buffer.size() == 1);
+}
+
+TEST_CASE("LinkBuffer grows past its first table")
+{
+  LinkBuffer buffer;
+  for(int round = 0; round < 2; ++round) {
+    for(int i = 0; i < 1000; ++i) {
+      buffer.next() = "https://a.test/" + std::to_string(i % 700);
+      buffer.commit();
+    }
+    CHECK(buffer.size() == 700);
+    buffer.clear();
+  }
+}
+
+TEST_CASE("LinkBuffer refills without allocating")
+{
+  LinkBuffer buffer;
+  std::string link = "https://a.test/a/fairly/long/path/that/does/not/fit/in/sso/";
+
+  auto fill = [&]() {
+    buffer.clear();
+    for(int i = 0; i < 300; ++i) {
+      std::string& slot = buffer.next();
+      slot.assign(link);
+      slot.push_back(static_cast<char>('a' + i % 26));
+      slot.push_back(static_cast<char>('a' + i / 26));
+      buffer.commit();
+    }
+  };
+
+  fill();
+  std::size_t before = allocations;
+  fill();
+  CHECK(allocations - before == 0);
+}
+
+TEST_CASE("PageParser extracts canonical links")
+{
+  PageParser parser;
+  LinkBuffer links;
+  parser.parse("https://wiki.test/wiki/Main",
+    "<body><a href=\"/a?x=1\">a</a><a href=\"b/\">b</a><a href=\"/a#top\">a</a><a href=\"/a?utm_source=z\">a</a></body>", links);
+
+  REQUIRE(links.size() == 3);
+  CHECK(links[0] == "https://wiki.test/a?x=1");
+  CHECK(links[1] == "https://wiki.test/wiki/b");
+  CHECK(links[2] == "https://wiki.test/a");
+}
+
+TEST_CASE("PageParser steady state does not allocate")
+{
+  REQUIRE(hooks_installed);
+  PageParser parser;
+  LinkBuffer links;
+  std::string base = "https://wiki.test/wiki/Main";
+  std::string html = sample_page(200);
+
+  // warm up: grows the buffers to the size of the page
+  parser.parse(base, html, links);
+  parser.parse(base, html, links);
+  std::size_t expected = links.size();
+
+  std::size_t before = allocations;
+  std::size_t lexbor_before = lexbor_allocations;
+  parser.parse(base, html, links);
+  std::size_t lexbor_per_page = lexbor_allocations - lexbor_before;
+
+  lexbor_before = lexbor_allocations;
+  for(int i = 0; i < 10; ++i) {
+    parser.parse(base, html, links);
+  }
+  std::size_t total = allocations - before;
+
+  CHECK(links.size() == expected);
+  CHECK(expected == 300);
+  CHECK_MESSAGE(total == 0, total << " allocations by our code and curl over 11 pages");
+
+  // lexbor's pools free all but their first chunk when cleaned, so a big
+  // page costs it the same few chunks each time, never one per node or link
+  CHECK_MESSAGE(lexbor_allocations - lexbor_before == 10 * lexbor_per_page,
+    "lexbor allocations vary between parses of the same page: " << lexbor_per_page << " then "
+                                                                 << lexbor_allocations - lexbor_before << " over 10");
+}
+
+TEST_CASE("PageParser fingerprints the visible text")
+{
+  PageParser parser;
+  LinkBuffer links;
+
+  parser.parse("https://wiki.test/a", "<body><p>Same words on both pages</p><a href=\"/x\">link</a></body>", links);
+  ContentFingerprint first = parser.fingerprint();
+
+  parser.parse("https://m.wiki.test/a",
+    "<body><script>var tracking = 1;</script><p>Same words on both pages</p><a href=\"/x\">link</a></body>", links);
+  ContentFingerprint mirror = parser.fingerprint();
+
+  CHECK(first.words == 6);
+  CHECK(mirror.words == 6);
+  CHECK(first.simhash == mirror.simhash);
+  CHECK(first.exact != mirror.exact);
+}
+
+TEST_CASE("PageParser follows links inside noscript, without their text")
+{
+  PageParser parser;
+  LinkBuffer links;
+
+  parser.parse("https://wiki.test/a",
+    "<body><p>Some words</p><noscript><a href=\"/static\">plain version of the page</a></noscript></body>", links);
+
+  REQUIRE(links.size() == 1);
+  CHECK(links[0] == "https://wiki.test/static");
+  CHECK(parser.fingerprint().words == 2);
+}
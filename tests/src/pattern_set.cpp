@@ -0,0 +1,82 @@
+#include "pattern_set.hpp" // The header you're testing
+
+#include <doctest/doctest.h>
+//
+#include <string>
+
+TEST_CASE("PatternSet matches like regex_search")
+{
+  PatternSet set;
+  CHECK(set.empty());
+  CHECK_FALSE(set.search("anything"));
+
+  set.add(R"(\.(png|jpe?g)$)");
+  CHECK(set.search("https://a.test/x.png"));
+  CHECK(set.search("https://a.test/x.jpeg"));
+  CHECK(set.search("https://a.test/x.jpg"));
+  CHECK_FALSE(set.search("https://a.test/x.png?size=2"));
+  CHECK_FALSE(set.search("https://a.test/xpng"));
+
+  set.add("^https://b\\.test/");
+  CHECK(set.search("https://b.test/page"));
+  CHECK_FALSE(set.search("http://x.test/?u=https://b.test/"));
+  CHECK(set.search("https://a.test/y.png")); // the first pattern still holds
+}
+
+TEST_CASE("PatternSet classes, escapes and repeats")
+{
+  PatternSet set;
+  set.add(R"(/page/\d{2,3}$)");
+  CHECK(set.search("https://a.test/page/12"));
+  CHECK(set.search("https://a.test/page/123"));
+  CHECK_FALSE(set.search("https://a.test/page/1"));
+  CHECK_FALSE(set.search("https://a.test/page/1234"));
+
+  PatternSet classes;
+  classes.add("[?&]id=[^&]+&");
+  CHECK(classes.search("https://a.test/?a=1&id=7&b"));
+  CHECK_FALSE(classes.search("https://a.test/?id=&b"));
+
+  PatternSet ranges;
+  ranges.add("^[a-c]+(?:x|y)*?z$");
+  CHECK(ranges.search("abcz"));
+  CHECK(ranges.search("cxyxz"));
+  CHECK_FALSE(ranges.search("dz"));
+  CHECK_FALSE(ranges.search("abczz"));
+
+  PatternSet empty;
+  empty.add("");
+  CHECK(empty.search(""));
+  CHECK(empty.search("x"));
+}
+
+TEST_CASE("PatternSet refuses what has no DFA")
+{
+  PatternSet set;
+  set.add("keep");
+  CHECK_THROWS(set.add("(unclosed"));
+  CHECK_THROWS(set.add(R"((a)\1)")); // backreference
+  CHECK_THROWS(set.add("a(?=b)")); // lookahead
+  CHECK_THROWS(set.add("a{3,1}"));
+  CHECK_THROWS(set.add("*a"));
+  CHECK_THROWS(set.add("[z-a]"));
+  CHECK_THROWS(set.add(".*a.{100}")); // too many states
+  CHECK_THROWS(set.add("((a{100}){100}){100}"));
+
+  // a refused pattern leaves the set as it was
+  CHECK(set.search("keep it"));
+  CHECK_FALSE(set.search("a"));
+}
+
+TEST_CASE("PatternSet is linear in the text")
+{
+  // (a|aa)*b backtracks exponentially, here it is one pass
+  PatternSet set;
+  set.add("^(a|aa)*b$");
+  set.add("(x+x+)+y");
+  std::string text(100000, 'a');
+  CHECK_FALSE(set.search(text));
+  CHECK_FALSE(set.search(std::string(100000, 'x')));
+  CHECK(set.search(text + "b"));
+  CHECK(set.states() < 16);
+}
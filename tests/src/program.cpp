@@ -21,7 +21,7 @@ TEST_CASE("request_html")
   Program p{};
 
   for(auto& url : urls) {
-    auto [final_url, content] = p.request_html(url);
+    auto [final_url, content] = p.crawler().fetcher().fetch(url);
 
     lxb_html_document_t* doc = lxb_html_document_create();
     REQUIRE(doc != nullptr); // sanity check
@@ -43,7 +43,7 @@ TEST_CASE("parse_url")
 
   int index = 0;
   for(auto& url : urls) {
-    auto [final_url, content] = p.request_html(url);
+    auto [final_url, content] = p.crawler().fetcher().fetch(url);
 
     CHECK(!content.empty());
 
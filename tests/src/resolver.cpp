@@ -0,0 +1,393 @@
+#include "resolver.hpp" // The header you're testing
+
+#include <doctest/doctest.h>
+//
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <thread>
+//
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+// Answers A and AAAA queries on 127.0.0.1, over udp and tcp, from a fixed
+// table, NXDOMAIN for names it does not know
+class StubDns
+{
+public:
+  using Records = std::multimap<std::string, std::pair<std::string, std::uint32_t>>; // name: address, ttl
+
+  struct Behaviour
+  {
+    bool truncate; // udp answers come without records and the TC bit
+    bool spoof;    // each answer follows one to another question
+  };
+
+  explicit StubDns(Records records, Behaviour behaviour = {}) :
+    m_records{std::move(records)}, m_behaviour{behaviour}
+  {
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    m_udp = ::socket(AF_INET, SOCK_DGRAM, 0);
+    ::bind(m_udp, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    socklen_t length = sizeof(address);
+    ::getsockname(m_udp, reinterpret_cast<sockaddr*>(&address), &length);
+    m_port = ntohs(address.sin_port);
+
+    m_tcp = ::socket(AF_INET, SOCK_STREAM, 0);
+    int reuse = 1;
+    ::setsockopt(m_tcp, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    ::bind(m_tcp, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    ::listen(m_tcp, 8);
+
+    m_thread = std::thread([this]() { serve(); });
+  }
+
+  ~StubDns()
+  {
+    m_stop = true;
+    m_thread.join();
+    ::close(m_udp);
+    ::close(m_tcp);
+  }
+
+  auto port() const -> std::uint16_t { return m_port; }
+  auto queries() const -> int { return m_queries; }
+  auto tcp_queries() const -> int { return m_tcp_queries; }
+
+private:
+  void serve()
+  {
+    std::uint8_t buffer[512];
+    while(!m_stop) {
+      pollfd pollers[2] = {{.fd = m_udp, .events = POLLIN, .revents = 0}, {.fd = m_tcp, .events = POLLIN, .revents = 0}};
+      if(::poll(pollers, 2, 20) <= 0) {
+        continue;
+      }
+
+      if(pollers[1].revents & POLLIN) {
+        serve_tcp();
+      }
+      if(!(pollers[0].revents & POLLIN)) {
+        continue;
+      }
+
+      sockaddr_in from{};
+      socklen_t from_length = sizeof(from);
+      ssize_t size = ::recvfrom(m_udp, buffer, sizeof(buffer), 0, reinterpret_cast<sockaddr*>(&from), &from_length);
+      if(size < 12) {
+        continue;
+      }
+      ++m_queries;
+
+      std::vector<std::uint8_t> query(buffer, buffer + size);
+      if(m_behaviour.spoof) {
+        // same id and type, but the question of someone else
+        std::vector<std::uint8_t> other = query;
+        other[13] = other[13] == 'x' ? 'y' : 'x';
+        std::vector<std::uint8_t> reply = answer(other, "10.6.6.6");
+        ::sendto(m_udp, reply.data(), reply.size(), 0, reinterpret_cast<sockaddr*>(&from), from_length);
+      }
+      std::vector<std::uint8_t> reply = answer(query);
+      if(m_behaviour.truncate) {
+        reply[2] |= 0x02;
+        reply[7] = 0;
+        reply.resize(query.size());
+      }
+      ::sendto(m_udp, reply.data(), reply.size(), 0, reinterpret_cast<sockaddr*>(&from), from_length);
+    }
+  }
+
+  void serve_tcp()
+  {
+    int client = ::accept(m_tcp, nullptr, nullptr);
+    if(client < 0) {
+      return;
+    }
+    std::uint8_t length[2];
+    if(::recv(client, length, 2, MSG_WAITALL) == 2) {
+      std::vector<std::uint8_t> query(static_cast<std::size_t>(length[0] << 8 | length[1]));
+      if(::recv(client, query.data(), query.size(), MSG_WAITALL) == static_cast<ssize_t>(query.size())) {
+        ++m_queries;
+        ++m_tcp_queries;
+        std::vector<std::uint8_t> reply = answer(query);
+        std::vector<std::uint8_t> framed = {static_cast<std::uint8_t>(reply.size() >> 8), static_cast<std::uint8_t>(reply.size())};
+        framed.insert(framed.end(), reply.begin(), reply.end());
+        ::send(client, framed.data(), framed.size(), MSG_NOSIGNAL);
+      }
+    }
+    ::close(client);
+  }
+
+  // the reply to {query}, with {forced} as the one address if given
+  auto answer(std::vector<std::uint8_t> const& query, std::string const& forced = "") const -> std::vector<std::uint8_t>
+  {
+    // the question name, as dotted text
+    std::string name;
+    std::size_t pos = 12;
+    while(pos < query.size() && query[pos] != 0) {
+      if(!name.empty()) {
+        name += '.';
+      }
+      name.append(reinterpret_cast<char const*>(query.data() + pos + 1), query[pos]);
+      pos += 1 + query[pos];
+    }
+    bool ipv6 = query[pos + 2] == 28;
+    std::size_t question_end = pos + 5;
+
+    std::vector<std::uint8_t> reply(query.begin(), query.begin() + static_cast<std::ptrdiff_t>(question_end));
+    reply[2] = 0x81; // response, recursion desired
+    reply[3] = 0x80; // recursion available
+
+    std::vector<std::pair<std::string, std::uint32_t>> found;
+    if(!forced.empty()) {
+      found.emplace_back(forced, 600);
+    }
+    auto [first, last] = m_records.equal_range(name);
+    if(forced.empty() && first == last) {
+      reply[3] |= 3; // NXDOMAIN
+      return reply;
+    }
+    for(auto it = first; forced.empty() && it != last; ++it) {
+      if((it->second.first.find(':') != std::string::npos) == ipv6) {
+        found.push_back(it->second);
+      }
+    }
+
+    for(auto const& [text, ttl] : found) {
+      std::uint8_t ip[16] = {};
+      inet_pton(ipv6 ? AF_INET6 : AF_INET, text.c_str(), ip);
+      reply.insert(reply.end(), {0xC0, 0x0C, 0x00, static_cast<std::uint8_t>(ipv6 ? 28 : 1), 0x00, 0x01,
+        static_cast<std::uint8_t>(ttl >> 24), static_cast<std::uint8_t>(ttl >> 16),
+        static_cast<std::uint8_t>(ttl >> 8), static_cast<std::uint8_t>(ttl),
+        0x00, static_cast<std::uint8_t>(ipv6 ? 16 : 4)});
+      reply.insert(reply.end(), ip, ip + (ipv6 ? 16 : 4));
+    }
+    reply[7] = static_cast<std::uint8_t>(found.size());
+    return reply;
+  }
+
+  Records m_records;
+  Behaviour m_behaviour;
+  int m_udp = -1;
+  int m_tcp = -1;
+  std::uint16_t m_port{};
+  std::atomic<int> m_queries{};
+  std::atomic<int> m_tcp_queries{};
+  std::atomic<bool> m_stop{};
+  std::thread m_thread;
+};
+
+auto options(StubDns const& stub) -> DnsResolver::Options
+{
+  return DnsResolver::Options{.server = "127.0.0.1", .port = stub.port(), .timeout = 500ms, .min_ttl = 0s, .hosts_file = ""};
+}
+
+// prefetching is asynchronous, give it a moment
+auto wait_for(DnsResolver const& resolver, std::string_view host) -> std::optional<DnsResolver::Addresses>
+{
+  for(int i = 0; i < 200; ++i) {
+    if(auto found = resolver.lookup(host)) {
+      return found;
+    }
+    std::this_thread::sleep_for(5ms);
+  }
+  return std::nullopt;
+}
+
+} // namespace
+
+TEST_CASE("resolver answers from the nameserver, then from its cache")
+{
+  StubDns stub({{"example.test", {"10.1.2.3", 600}}});
+  DnsResolver resolver(options(stub));
+
+  auto first = resolver.resolve("example.test");
+  REQUIRE(first.has_value());
+  REQUIRE(first->size() == 1);
+  CHECK((*first)[0] == "10.1.2.3");
+
+  auto second = resolver.resolve("example.test");
+  REQUIRE(second.has_value());
+  CHECK(stub.queries() == 2); // A and AAAA
+  CHECK(resolver.queries() == 2);
+}
+
+TEST_CASE("resolver prefetches in the background")
+{
+  StubDns stub({{"a.test", {"10.0.0.1", 600}}, {"b.test", {"10.0.0.2", 600}}});
+  DnsResolver resolver(options(stub));
+
+  CHECK_FALSE(resolver.lookup("a.test").has_value());
+  resolver.prefetch("a.test");
+  resolver.prefetch("b.test");
+  resolver.prefetch("a.test"); // already queued or cached
+
+  auto a = wait_for(resolver, "a.test");
+  auto b = wait_for(resolver, "b.test");
+  REQUIRE(a.has_value());
+  REQUIRE(b.has_value());
+  CHECK((*a)[0] == "10.0.0.1");
+  CHECK((*b)[0] == "10.0.0.2");
+  CHECK(stub.queries() == 4);
+
+  resolver.prefetch("10.9.9.9"); // ip literals need no lookup
+  resolver.prefetch("[::1]");
+  std::this_thread::sleep_for(50ms);
+  CHECK(stub.queries() == 4);
+}
+
+TEST_CASE("resolver remembers hosts that do not exist")
+{
+  StubDns stub({});
+  DnsResolver resolver(options(stub));
+
+  auto missing = resolver.resolve("missing.test");
+  REQUIRE(missing.has_value());
+  CHECK(missing->empty());
+  CHECK(resolver.resolve("missing.test")->empty());
+  CHECK(resolver.queries() == 2);
+  CHECK_FALSE(resolver.curl_resolve_entry("missing.test", 443).has_value());
+}
+
+TEST_CASE("resolver answers expire with their ttl")
+{
+  StubDns stub({{"short.test", {"10.0.0.3", 0}}});
+  DnsResolver resolver(options(stub));
+
+  CHECK(resolver.resolve("short.test").has_value());
+  CHECK_FALSE(resolver.lookup("short.test").has_value());
+  CHECK(resolver.resolve("short.test").has_value());
+  CHECK(stub.queries() == 4);
+}
+
+TEST_CASE("resolver builds CURLOPT_RESOLVE entries")
+{
+  StubDns stub({{"example.test", {"10.1.2.3", 600}}});
+  DnsResolver resolver(options(stub));
+
+  CHECK_FALSE(resolver.curl_resolve_entry("example.test", 443).has_value());
+  resolver.resolve("example.test");
+  CHECK(resolver.curl_resolve_entry("example.test", 443) == "+example.test:443:10.1.2.3");
+}
+
+TEST_CASE("resolver leaves the names of the hosts file to curl")
+{
+  std::filesystem::path hosts = std::filesystem::temp_directory_path() / "resolver_test_hosts";
+  std::ofstream(hosts) << "# local names\n10.0.0.9 Local.test alias.test # comment\n";
+
+  StubDns stub({{"local.test", {"10.1.2.3", 600}}, {"alias.test", {"10.1.2.3", 600}}});
+  DnsResolver::Options local = options(stub);
+  local.hosts_file = hosts.string();
+  DnsResolver resolver(local);
+
+  CHECK_FALSE(resolver.resolve("local.test").has_value());
+  resolver.prefetch("alias.test");
+  std::this_thread::sleep_for(50ms);
+  CHECK_FALSE(resolver.curl_resolve_entry("alias.test", 443).has_value());
+  CHECK(stub.queries() == 0);
+  std::filesystem::remove(hosts);
+}
+
+TEST_CASE("resolver gives up on a silent nameserver")
+{
+  // a bound socket that never answers
+  int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  ::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+  socklen_t length = sizeof(address);
+  ::getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length);
+
+  DnsResolver resolver(DnsResolver::Options{.server = "127.0.0.1", .port = ntohs(address.sin_port), .timeout = 50ms});
+  CHECK_FALSE(resolver.resolve("example.test").has_value());
+  CHECK(resolver.queries() == 4); // A and AAAA, twice
+  ::close(fd);
+}
+
+TEST_CASE("resolver asks for ipv6 addresses too")
+{
+  StubDns stub({{"dual.test", {"10.0.0.4", 600}}, {"dual.test", {"2001:db8::4", 600}}, {"six.test", {"2001:db8::6", 600}}});
+  DnsResolver resolver(options(stub));
+
+  auto dual = resolver.resolve("dual.test");
+  REQUIRE(dual.has_value());
+  CHECK((*dual == DnsResolver::Addresses{"10.0.0.4", "2001:db8::4"}));
+  CHECK(resolver.curl_resolve_entry("dual.test", 443) == "+dual.test:443:10.0.0.4,[2001:db8::4]");
+
+  auto six = resolver.resolve("six.test");
+  REQUIRE(six.has_value());
+  CHECK((*six == DnsResolver::Addresses{"2001:db8::6"}));
+}
+
+TEST_CASE("resolver asks again over tcp when the answer is truncated")
+{
+  StubDns stub({{"big.test", {"10.0.0.5", 600}}}, {.truncate = true});
+  DnsResolver resolver(options(stub));
+
+  auto big = resolver.resolve("big.test");
+  REQUIRE(big.has_value());
+  CHECK((*big == DnsResolver::Addresses{"10.0.0.5"}));
+  CHECK(stub.tcp_queries() == 2);
+}
+
+TEST_CASE("resolver ignores answers to another question")
+{
+  StubDns stub({{"example.test", {"10.1.2.3", 600}}}, {.spoof = true});
+  DnsResolver resolver(options(stub));
+
+  auto found = resolver.resolve("example.test");
+  REQUIRE(found.has_value());
+  CHECK((*found == DnsResolver::Addresses{"10.1.2.3"}));
+}
+
+TEST_CASE("resolver tries the search domains like the system resolver")
+{
+  StubDns stub({{"intranet.other.test", {"10.0.0.7", 600}}, {"wiki.test", {"10.0.0.8", 600}}});
+  DnsResolver::Options searching = options(stub);
+  searching.search = {"corp.test", "other.test"};
+  DnsResolver resolver(searching);
+
+  // too few dots: the search domains first, in order
+  auto intranet = resolver.resolve("intranet");
+  REQUIRE(intranet.has_value());
+  CHECK((*intranet == DnsResolver::Addresses{"10.0.0.7"}));
+  CHECK(resolver.queries() == 4);
+
+  // enough dots: the name itself first
+  auto wiki = resolver.resolve("wiki.test");
+  REQUIRE(wiki.has_value());
+  CHECK((*wiki == DnsResolver::Addresses{"10.0.0.8"}));
+  CHECK(resolver.queries() == 6);
+
+  // a trailing dot: the name alone
+  CHECK(resolver.resolve("absent.test.")->empty());
+  CHECK(resolver.queries() == 8);
+}
+
+TEST_CASE("resolver reads its options from resolv.conf")
+{
+  std::filesystem::path path = std::filesystem::temp_directory_path() / "resolver_test_resolv.conf";
+  std::ofstream(path) << "nameserver ::1\nnameserver 10.0.0.53\nnameserver 10.0.0.54\n"
+                         "domain first.test\nsearch Corp.test other.test\noptions timeout:1 ndots:2\n";
+
+  auto options = DnsResolver::system_options(path.string());
+  REQUIRE(options.has_value());
+  CHECK(options->server == "10.0.0.53");
+  CHECK((options->search == std::vector<std::string>{"corp.test", "other.test"}));
+  CHECK(options->ndots == 2);
+
+  std::ofstream(path) << "nameserver ::1\n";
+  CHECK_FALSE(DnsResolver::system_options(path.string()).has_value());
+  std::filesystem::remove(path);
+}
@@ -0,0 +1,69 @@
+#include "retry.hpp" // The header you're testing
+
+#include <doctest/doctest.h>
+
+using namespace std::chrono_literals;
+
+TEST_CASE("retry delays double up to the cap")
+{
+  RetryQueue queue(RetryPolicy{.max_attempts = 10, .base_delay = 100ms, .max_delay = 1000ms, .jitter = 0.0});
+  CHECK(queue.delay(1) == 100ms);
+  CHECK(queue.delay(2) == 200ms);
+  CHECK(queue.delay(3) == 400ms);
+  CHECK(queue.delay(4) == 800ms);
+  CHECK(queue.delay(5) == 1000ms);
+}
+
+TEST_CASE("retry jitter stays in its band")
+{
+  RetryQueue queue(RetryPolicy{.base_delay = 1000ms, .jitter = 0.2}, 42);
+  for(int i = 0; i < 100; ++i) {
+    auto delay = queue.delay(1);
+    CHECK(delay >= 800ms);
+    CHECK(delay <= 1200ms);
+  }
+}
+
+TEST_CASE("retry entries come out once due, earliest first")
+{
+  RetryQueue queue(RetryPolicy{.max_attempts = 5, .base_delay = 100ms, .jitter = 0.0});
+  auto now = RetryQueue::Clock::now();
+
+  CHECK(queue.schedule(1, 3, 2, now)); // due in 200ms
+  CHECK(queue.schedule(2, 3, 1, now)); // due in 100ms
+  CHECK(queue.size() == 2);
+  CHECK(*queue.next_ready() == now + 100ms);
+
+  CHECK_FALSE(queue.pop_ready(now + 50ms).has_value());
+
+  auto first = queue.pop_ready(now + 150ms);
+  REQUIRE(first.has_value());
+  CHECK(first->index == 2);
+  CHECK(first->attempt == 1);
+  CHECK_FALSE(queue.pop_ready(now + 150ms).has_value());
+
+  auto second = queue.pop_ready(now + 1s);
+  REQUIRE(second.has_value());
+  CHECK(second->index == 1);
+  CHECK(second->depth == 3);
+  CHECK(queue.empty());
+  CHECK_FALSE(queue.next_ready().has_value());
+}
+
+TEST_CASE("retry gives up after the last attempt")
+{
+  RetryQueue queue(RetryPolicy{.max_attempts = 3});
+  auto now = RetryQueue::Clock::now();
+  CHECK(queue.schedule(0, 1, 1, now));
+  CHECK(queue.schedule(0, 1, 2, now));
+  CHECK_FALSE(queue.schedule(0, 1, 3, now));
+  CHECK(queue.size() == 2);
+}
+
+TEST_CASE("retry errors carry their status")
+{
+  FetchError error("HTTP 503", 503, true);
+  CHECK(error.status() == 503);
+  CHECK(error.retryable());
+  CHECK(std::string(error.what()) == "HTTP 503");
+}
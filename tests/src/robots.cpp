@@ -0,0 +1,155 @@
+#include "robots.hpp" // The header you're testing
+
+#include <doctest/doctest.h>
+//
+#include <zlib.h>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+constexpr std::string_view robots_txt =
+  "# comment\n"
+  "User-agent: *\n"
+  "Disallow: /private\n"
+  "Allow: /private/open\n"
+  "Disallow: /*.pdf$\n"
+  "Disallow: /search*q=\n"
+  "Crawl-delay: 2.5\n"
+  "\n"
+  "User-agent: crawler\n"
+  "User-agent: other\n"
+  "Disallow: /crawler-only\n"
+  "Crawl-delay: 1\n"
+  "\n"
+  "Sitemap: https://example.com/sitemap.xml\n";
+
+} // namespace
+
+TEST_CASE("robots falls back to the '*' group")
+{
+  RobotsRules rules = RobotsRules::parse(robots_txt, "somebot");
+  CHECK(rules.allowed("/"));
+  CHECK(rules.allowed("/public/page"));
+  CHECK_FALSE(rules.allowed("/private"));
+  CHECK_FALSE(rules.allowed("/private/secret"));
+  CHECK(rules.allowed("/private/open/page")); // longer allow wins
+  CHECK(rules.allowed("/crawler-only"));
+  CHECK(rules.crawl_delay() == 2500ms);
+  REQUIRE(rules.sitemaps().size() == 1);
+  CHECK(rules.sitemaps()[0] == "https://example.com/sitemap.xml");
+}
+
+TEST_CASE("robots prefers the group naming us")
+{
+  RobotsRules rules = RobotsRules::parse(robots_txt, "Crawler");
+  CHECK_FALSE(rules.allowed("/crawler-only/x"));
+  CHECK(rules.allowed("/private")); // the '*' group no longer applies
+  CHECK(rules.crawl_delay() == 1000ms);
+  CHECK(rules.rule_count() == 1);
+}
+
+TEST_CASE("robots wildcards and anchors")
+{
+  RobotsRules rules = RobotsRules::parse(robots_txt, "somebot");
+  CHECK_FALSE(rules.allowed("/docs/manual.pdf"));
+  CHECK(rules.allowed("/docs/manual.pdf?download=1")); // '$' anchors the end
+  CHECK_FALSE(rules.allowed("/search?lang=en&q=crawler"));
+  CHECK(rules.allowed("/search?lang=en"));
+}
+
+TEST_CASE("robots ties go to allow")
+{
+  RobotsRules rules;
+  rules.disallow("/page");
+  rules.allow("/page");
+  rules.disallow("/*x");
+  rules.allow("/a*");
+  CHECK(rules.allowed("/page"));
+  CHECK(rules.allowed("/ax"));
+  CHECK_FALSE(rules.allowed("/bx"));
+}
+
+TEST_CASE("robots disallow all still allows robots.txt")
+{
+  RobotsRules rules = RobotsRules::disallow_all();
+  CHECK_FALSE(rules.allowed("/"));
+  CHECK_FALSE(rules.allowed("/anything"));
+  CHECK(rules.allowed("/robots.txt"));
+  CHECK(RobotsRules::parse("", "crawler").allowed("/anything"));
+  CHECK(RobotsRules::parse("User-agent: *\nDisallow:\n", "crawler").allowed("/anything"));
+}
+
+TEST_CASE("robots cache keys on the origin")
+{
+  RobotsCache cache;
+  CHECK(cache.find("https://example.com") == nullptr);
+
+  cache.insert("https://example.com", RobotsRules::disallow_all());
+  REQUIRE(cache.find("https://example.com") != nullptr);
+  CHECK_FALSE(cache.find("https://example.com")->allowed("/"));
+  CHECK(cache.find("http://example.com") == nullptr);
+  CHECK(cache.size() == 1);
+}
+
+TEST_CASE("host scheduler spaces requests per host")
+{
+  HostScheduler scheduler(300ms, 10s);
+  auto now = HostScheduler::Clock::now();
+
+  CHECK(scheduler.ready_at("a.test") <= now); // never visited
+  scheduler.visited("a.test", now);
+  CHECK(scheduler.ready_at("a.test") == now + 300ms);
+  CHECK(scheduler.ready_at("b.test") <= now);
+
+  scheduler.set_delay("a.test", 2s);
+  CHECK(scheduler.ready_at("a.test") == now + 2s);
+
+  scheduler.set_delay("b.test", 1h);
+  CHECK(scheduler.delay("b.test") == 10s);
+  CHECK(scheduler.delay("c.test") == 300ms);
+}
+
+TEST_CASE("sitemap urls and indexes")
+{
+  Sitemap sitemap = parse_sitemap(
+    "<?xml version=\"1.0\"?>\n"
+    "<urlset xmlns=\"http://www.sitemaps.org/schemas/sitemap/0.9\">\n"
+    "  <url><loc>https://example.com/a?x=1&amp;y=2</loc></url>\n"
+    "  <url><loc>\n    https://example.com/b\n  </loc><lastmod>2024-01-01</lastmod></url>\n"
+    "  <url><loc><![CDATA[https://example.com/c]]></loc></url>\n"
+    "</urlset>\n");
+
+  REQUIRE(sitemap.urls.size() == 3);
+  CHECK(sitemap.urls[0] == "https://example.com/a?x=1&y=2");
+  CHECK(sitemap.urls[1] == "https://example.com/b");
+  CHECK(sitemap.urls[2] == "https://example.com/c");
+  CHECK(sitemap.sitemaps.empty());
+
+  Sitemap index = parse_sitemap(
+    "<sitemapindex><sitemap><loc>https://example.com/s1.xml.gz</loc></sitemap></sitemapindex>");
+  CHECK(index.urls.empty());
+  REQUIRE(index.sitemaps.size() == 1);
+  CHECK(index.sitemaps[0] == "https://example.com/s1.xml.gz");
+}
+
+TEST_CASE("gunzip inflates gzip and passes anything else through")
+{
+  std::string plain = "<urlset><url><loc>https://example.com/</loc></url></urlset>";
+  CHECK(gunzip(plain) == plain);
+
+  // gzip it with zlib's own deflate
+  z_stream stream{};
+  REQUIRE(deflateInit2(&stream, Z_BEST_SPEED, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK);
+  std::string packed(deflateBound(&stream, plain.size()) + 32, '\0');
+  stream.next_in = reinterpret_cast<Bytef*>(plain.data());
+  stream.avail_in = static_cast<uInt>(plain.size());
+  stream.next_out = reinterpret_cast<Bytef*>(packed.data());
+  stream.avail_out = static_cast<uInt>(packed.size());
+  REQUIRE(deflate(&stream, Z_FINISH) == Z_STREAM_END);
+  packed.resize(stream.total_out);
+  deflateEnd(&stream);
+
+  CHECK(gunzip(packed) == plain);
+  CHECK_THROWS(gunzip(packed.substr(0, packed.size() / 2)));
+}
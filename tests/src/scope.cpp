@@ -0,0 +1,91 @@
+#include "scope.hpp" // The header you're testing
+
+#include <doctest/doctest.h>
+//
+#include <string>
+
+TEST_CASE("empty scope allows every http link")
+{
+  CrawlScope scope;
+  CHECK(scope.empty());
+  CHECK(scope.allows("https://anything.test/x", 100));
+  CHECK(scope.allows("http://anything.test", 0));
+  CHECK_FALSE(scope.allows("mailto:someone@anything.test", 0));
+  CHECK_FALSE(scope.allows("ftp://anything.test/", 0));
+  CHECK_FALSE(scope.allows("not a url", 0));
+}
+
+TEST_CASE("host rules match whole labels")
+{
+  CrawlScope scope;
+  scope.allow_host("Example.com");
+
+  CHECK(scope.allows("https://example.com/", 1));
+  CHECK(scope.allows("https://en.example.com/wiki", 1));
+  CHECK_FALSE(scope.allows("https://badexample.com/", 1));
+  CHECK_FALSE(scope.allows("https://example.org/", 1));
+}
+
+TEST_CASE("the most specific host rule wins")
+{
+  CrawlScope scope;
+  scope.allow_host("wiki.test");
+  scope.deny_host("ads.wiki.test");
+  scope.allow_host("ok.ads.wiki.test");
+
+  CHECK(scope.allows("https://en.wiki.test/", 1));
+  CHECK_FALSE(scope.allows("https://ads.wiki.test/", 1));
+  CHECK_FALSE(scope.allows("https://x.ads.wiki.test/", 1));
+  CHECK(scope.allows("https://ok.ads.wiki.test/", 1));
+}
+
+TEST_CASE("deny only host rules keep everything else")
+{
+  CrawlScope scope;
+  scope.deny_host("facebook.com");
+
+  CHECK(scope.allows("https://example.com/", 1));
+  CHECK_FALSE(scope.allows("https://www.facebook.com/share", 1));
+}
+
+TEST_CASE("per host level limits")
+{
+  CrawlScope scope;
+  scope.allow_host("wiki.test");
+  scope.allow_host("news.test", 1);
+
+  CHECK(scope.allows("https://news.test/a", 1));
+  CHECK_FALSE(scope.allows("https://news.test/a", 2));
+  CHECK(scope.allows("https://wiki.test/a", 5));
+}
+
+TEST_CASE("path prefix rules")
+{
+  CrawlScope scope;
+  scope.allow_path("/wiki/");
+  scope.deny_path("/wiki/Special:");
+
+  CHECK(scope.allows("https://wiki.test/wiki/Web_crawler", 1));
+  CHECK_FALSE(scope.allows("https://wiki.test/wiki/Special:Random", 1));
+  CHECK_FALSE(scope.allows("https://wiki.test/w/index.php?title=X", 1));
+  CHECK_FALSE(scope.allows("https://wiki.test", 1));
+}
+
+TEST_CASE("regex rules are combined")
+{
+  CrawlScope scope;
+  scope.deny_pattern(R"(\.(png|jpe?g|pdf)$)");
+  scope.deny_pattern("[?&]action=edit");
+
+  CHECK(scope.allows("https://a.test/page", 1));
+  CHECK_FALSE(scope.allows("https://a.test/file.pdf", 1));
+  CHECK_FALSE(scope.allows("https://a.test/img.jpeg", 1));
+  CHECK_FALSE(scope.allows("https://a.test/w?title=X&action=edit", 1));
+
+  CHECK_THROWS(scope.allow_pattern("(unclosed"));
+  CHECK(scope.allows("https://a.test/page", 1)); // still usable
+
+  scope.allow_pattern("^https://a\\.test/");
+  CHECK_FALSE(scope.allows("https://b.test/page", 1));
+  CHECK(scope.allows("https://a.test/" + std::string(100000, 'x'), 1));
+}
@@ -0,0 +1,167 @@
+#include "shard.hpp" // The header you're testing
+
+#include <doctest/doctest.h>
+#include <set>
+#include <utility>
+//
+#include <canonical.hpp>
+#include <crawler.hpp>
+#include <page_graph.hpp>
+//
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+// a small fake web spread over a few hosts
+constexpr int page_count = 60;
+
+std::string page_url(int i)
+{
+  return "https://host" + std::to_string(i % 7) + ".test/page" + std::to_string(i);
+}
+
+std::vector<std::string> page_links(std::string const& url)
+{
+  int i = std::stoi(url.substr(url.rfind("page") + 4));
+  return {page_url((i * 3 + 1) % page_count), page_url((i * 5 + 2) % page_count), page_url((i + 11) % page_count)};
+}
+
+// serves the fake web, every page links to three others
+struct FakeWebFetcher
+{
+  using Response = std::pair<std::string, std::string>;
+
+  void fetch(std::string const& url, Response& out)
+  {
+    out.first = url;
+    out.second.clear();
+    for(std::string const& link : page_links(url)) {
+      out.second += link + "\n";
+    }
+  }
+
+  auto live() const -> bool { return false; }
+};
+
+// one absolute link per line
+struct LineExtractor
+{
+  void parse(std::string const&, std::string const& content, LinkBuffer& out)
+  {
+    out.clear();
+    std::size_t begin = 0;
+    while(begin < content.size()) {
+      std::size_t end = content.find('\n', begin);
+      out.next().assign(content, begin, end - begin);
+      out.commit();
+      begin = end + 1;
+    }
+  }
+};
+
+using FakeCrawler = Crawler<FakeWebFetcher, LineExtractor, Canonicalizer, PageGraph>;
+
+void configure(FakeCrawler& crawler)
+{
+  crawler.set_verbose(false);
+  crawler.set_respect_robots(false);
+}
+
+using EdgeSet = std::set<std::pair<std::string, std::string>>;
+
+EdgeSet edge_set(ShardGraph const& graph)
+{
+  EdgeSet edges;
+  for(auto const& [from, to] : graph.edges) {
+    edges.emplace(graph.urls[from], graph.urls[to]);
+  }
+  return edges;
+}
+
+} // namespace
+
+TEST_CASE("shard_of")
+{
+  CHECK(shard_of("https://example.com/a", 1) == 0);
+  CHECK(shard_of("https://example.com/a", 8) == shard_of("https://EXAMPLE.com/b?c", 8));
+
+  std::vector<int> hits(4, 0);
+  for(int i = 0; i < 400; ++i) {
+    int shard = shard_of("https://host" + std::to_string(i) + ".test/", 4);
+    REQUIRE(shard >= 0);
+    REQUIRE(shard < 4);
+    ++hits[shard];
+  }
+  for(int count : hits) {
+    CHECK(count > 50); // roughly uniform
+  }
+}
+
+TEST_CASE("shard graph roundtrip")
+{
+  auto dir = std::filesystem::temp_directory_path() / ("crawler-shard-io-" + std::to_string(getpid()));
+  std::filesystem::create_directories(dir);
+
+  ShardGraph graph{
+    .urls = {"https://a.test/", "https://b.test/x", "https://b.test/y"},
+    .depths = {2, 1, 1},
+    .edges = {{0, 1}, {1, 0}},
+    .merged = {{2, 1}},
+  };
+  write_shard_graph(dir / "g.graph", graph);
+  ShardGraph read = read_shard_graph(dir / "g.graph");
+
+  CHECK(read.urls == graph.urls);
+  CHECK(read.depths == graph.depths);
+  CHECK(read.edges == graph.edges);
+  CHECK(read.merged == graph.merged);
+
+  std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("sharded crawl across processes matches a single crawl")
+{
+  constexpr int shards = 3;
+  constexpr int depth = page_count; // deep enough for the result not to depend on visit order
+  std::string root = page_url(0);
+
+  auto dir = std::filesystem::temp_directory_path() / ("crawler-shard-" + std::to_string(getpid()));
+  std::filesystem::remove_all(dir);
+
+  std::vector<pid_t> children;
+  for(int id = 0; id < shards; ++id) {
+    pid_t pid = fork();
+    REQUIRE(pid >= 0);
+    if(pid == 0) {
+      // the same steps as Program::run_shard
+      ShardConfig config{.id = id, .count = shards, .dir = dir};
+      FakeCrawler crawler;
+      configure(crawler);
+      crawler.set_spool(std::make_unique<ShardSpool>(config));
+      crawler.crawl_shard(root, depth);
+      write_shard_graph(shard_graph_path(config, id), crawler.graph().export_graph());
+      _exit(0);
+    }
+    children.push_back(pid);
+  }
+
+  for(pid_t pid : children) {
+    int status = 0;
+    waitpid(pid, &status, 0);
+    CHECK(WIFEXITED(status));
+  }
+
+  ShardGraph merged = merge_shards(dir, shards);
+
+  FakeCrawler crawler;
+  configure(crawler);
+  crawler.crawl(root, depth);
+  ShardGraph single = crawler.graph().export_graph();
+
+  CHECK(merged.urls.size() == page_count);
+  CHECK(std::set<std::string>(merged.urls.begin(), merged.urls.end()) == std::set<std::string>(single.urls.begin(), single.urls.end()));
+  CHECK(edge_set(merged) == edge_set(single));
+
+  std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,116 @@
+#include "simhash.hpp" // The header you're testing
+
+#include <doctest/doctest.h>
+//
+#include <string>
+
+namespace {
+
+// deterministic filler text, {seed} picks the words
+auto make_text(unsigned seed, int words) -> std::string
+{
+  static constexpr std::string_view vocabulary[] = {"crawler", "graph", "page", "link", "node", "host", "depth",
+    "budget", "frontier", "archive", "shard", "scope", "robots", "sitemap", "layout", "render", "queue", "fetch",
+    "parse", "merge"};
+
+  std::string out;
+  for(int i = 0; i < words; ++i) {
+    seed = seed * 1103515245u + 12345u;
+    out += vocabulary[(seed >> 16) % std::size(vocabulary)];
+    out += ' ';
+  }
+  return out;
+}
+
+auto fingerprint(std::string const& text) -> ContentFingerprint
+{
+  SimHasher hasher;
+  hasher.add_text(text);
+  return ContentFingerprint{.exact = std::hash<std::string>{}(text), .simhash = hasher.value(), .words = hasher.words()};
+}
+
+} // namespace
+
+TEST_CASE("simhash ignores case, punctuation and how the text is split")
+{
+  SimHasher whole;
+  whole.add_text("The quick brown fox jumps over the lazy dog");
+
+  SimHasher pieces;
+  pieces.add_text("the QUICK, brown ");
+  pieces.add_text("fox jumps over -- the lazy dog!");
+
+  CHECK(whole.words() == 9);
+  CHECK(pieces.words() == 9);
+  CHECK(whole.value() == pieces.value());
+}
+
+TEST_CASE("simhash of near identical text is close, of other text far")
+{
+  std::string text = make_text(1, 400);
+  std::string edited = text;
+  edited.replace(edited.find("graph"), 5, "chart");
+
+  auto a = fingerprint(text);
+  auto b = fingerprint(edited);
+  auto c = fingerprint(make_text(2, 400));
+
+  CHECK(hamming(a.simhash, b.simhash) <= 6);
+  CHECK(hamming(a.simhash, c.simhash) > 16);
+}
+
+TEST_CASE("simhash short text still hashes")
+{
+  SimHasher hasher;
+  CHECK(hasher.value() == 0);
+  hasher.add_text("hello");
+  CHECK(hasher.value() != 0);
+
+  hasher.clear();
+  CHECK(hasher.words() == 0);
+  CHECK(hasher.value() == 0);
+}
+
+TEST_CASE("simhash index finds exact and near duplicates")
+{
+  SimHashIndex index;
+  std::string text = make_text(7, 300);
+  index.insert(fingerprint(text), 1);
+  index.insert(fingerprint(make_text(8, 300)), 2);
+  CHECK(index.size() == 2);
+
+  auto exact = index.find(fingerprint(text));
+  REQUIRE(exact.has_value());
+  CHECK(exact->id == 1);
+  CHECK(exact->distance == 0);
+
+  std::string mirrored = "Print view " + text;
+  auto near = index.find(fingerprint(mirrored));
+  REQUIRE(near.has_value());
+  CHECK(near->id == 1);
+  CHECK(near->distance <= 3);
+
+  CHECK_FALSE(index.find(fingerprint(make_text(9, 300))).has_value());
+}
+
+TEST_CASE("simhash index matches short pages only exactly")
+{
+  SimHashIndex index(3, 32);
+  index.insert(fingerprint("about us"), 1);
+
+  CHECK(index.find(fingerprint("about us")).has_value());
+  CHECK_FALSE(index.find(fingerprint("about them")).has_value());
+}
+
+TEST_CASE("simhash index distance has to fit the blocks")
+{
+  CHECK_THROWS(SimHashIndex(4));
+  CHECK_THROWS(SimHashIndex(-1));
+}
+
+TEST_CASE("hamming")
+{
+  CHECK(hamming(0, 0) == 0);
+  CHECK(hamming(0, ~std::uint64_t{0}) == 64);
+  CHECK(hamming(0b1011, 0b0001) == 2);
+}
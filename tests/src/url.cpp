@@ -0,0 +1,110 @@
+#include "url.hpp" // The header you're testing
+
+#include <doctest/doctest.h>
+
+TEST_CASE("url_host")
+{
+  CHECK(url_host("https://example.com") == "example.com");
+  CHECK(url_host("https://example.com/a/b?c=d#e") == "example.com");
+  CHECK(url_host("http://user:pw@Example.com:8080/x") == "Example.com");
+  CHECK(url_host("http://[::1]:8080/") == "[::1]");
+  CHECK(url_host("mailto:someone@example.com").empty());
+}
+
+TEST_CASE("fnv1a64")
+{
+  static_assert(fnv1a64("") == 14695981039346656037ull);
+  CHECK(fnv1a64("a") == 0xaf63dc4c8601ec8cull);
+  CHECK(fnv1a64("ab") == fnv1a64("b", fnv1a64("a")));
+}
+
+TEST_CASE("url_origin")
+{
+  CHECK(url_origin("https://example.com") == "https://example.com");
+  CHECK(url_origin("https://example.com:8080/a?b") == "https://example.com:8080");
+  CHECK(url_origin("http://example.com?q#f") == "http://example.com");
+  CHECK(url_origin("mailto:someone@example.com").empty());
+}
+
+TEST_CASE("url_target")
+{
+  CHECK(url_target("https://example.com") == "/");
+  CHECK(url_target("https://example.com/a/b?c=d#e") == "/a/b?c=d");
+  CHECK(url_target("https://example.com/#top") == "/");
+  CHECK(url_target("mailto:someone@example.com").empty());
+}
+
+TEST_CASE("url_port")
+{
+  CHECK(url_port("https://example.com/a") == 443);
+  CHECK(url_port("http://example.com") == 80);
+  CHECK(url_port("http://example.com:8080/x") == 8080);
+  CHECK(url_port("http://user:pw@example.com:81/") == 81);
+  CHECK(url_port("http://[::1]:8080/") == 8080);
+  CHECK(url_port("ftp://example.com/") == 0);
+  CHECK(url_port("mailto:someone@example.com") == 0);
+}
+
+TEST_CASE("resolve_reference follows RFC 3986")
+{
+  std::string base = "http://a/b/c/d;p?q";
+  auto resolve = [&](std::string_view href) {
+    std::string out;
+    REQUIRE(resolve_reference(base, href, out));
+    return out;
+  };
+
+  // section 5.4.1
+  CHECK(resolve("g:h") == "g:h");
+  CHECK(resolve("g") == "http://a/b/c/g");
+  CHECK(resolve("./g") == "http://a/b/c/g");
+  CHECK(resolve("g/") == "http://a/b/c/g/");
+  CHECK(resolve("/g") == "http://a/g");
+  CHECK(resolve("//g") == "http://g");
+  CHECK(resolve("?y") == "http://a/b/c/d;p?y");
+  CHECK(resolve("g?y") == "http://a/b/c/g?y");
+  CHECK(resolve("#s") == "http://a/b/c/d;p?q#s");
+  CHECK(resolve("g#s") == "http://a/b/c/g#s");
+  CHECK(resolve(";x") == "http://a/b/c/;x");
+  CHECK(resolve("") == "http://a/b/c/d;p?q");
+  CHECK(resolve(".") == "http://a/b/c/");
+  CHECK(resolve("./") == "http://a/b/c/");
+  CHECK(resolve("..") == "http://a/b/");
+  CHECK(resolve("../g") == "http://a/b/g");
+  CHECK(resolve("../..") == "http://a/");
+  CHECK(resolve("../../g") == "http://a/g");
+
+  // section 5.4.2
+  CHECK(resolve("../../../g") == "http://a/g");
+  CHECK(resolve("/./g") == "http://a/g");
+  CHECK(resolve("/../g") == "http://a/g");
+  CHECK(resolve("g.") == "http://a/b/c/g.");
+  CHECK(resolve("..g") == "http://a/b/c/..g");
+  CHECK(resolve("./g/.") == "http://a/b/c/g/");
+  CHECK(resolve("g/./h") == "http://a/b/c/g/h");
+  CHECK(resolve("g/../h") == "http://a/b/c/h");
+  CHECK(resolve("g;x=1/../y") == "http://a/b/c/y");
+  CHECK(resolve("g?y/./x") == "http://a/b/c/g?y/./x");
+  CHECK(resolve("http:g") == "http:g");
+
+  // what pages actually contain
+  CHECK(resolve("  /wiki/A B\n ") == "http://a/wiki/A%20B");
+  CHECK(resolve("https://Other.test/x/../y") == "https://Other.test/y");
+  base = "https://a.test";
+  CHECK(resolve("x") == "https://a.test/x");
+
+  std::string out;
+  CHECK_FALSE(resolve_reference("/relative/base", "x", out));
+}
+
+TEST_CASE("resolve_reference reuses its output")
+{
+  std::string out;
+  out.reserve(256);
+  char const* before = out.data();
+  for(int i = 0; i < 100; ++i) {
+    resolve_reference("https://a.test/wiki/Main", "../a/./b/../c?q=1#f", out);
+  }
+  CHECK(out == "https://a.test/a/c?q=1#f");
+  CHECK(out.data() == before);
+}
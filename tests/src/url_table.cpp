@@ -0,0 +1,86 @@
+#include "url_table.hpp" // The header you're testing
+
+#include <doctest/doctest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("UrlTable hands out dense ids")
+{
+  UrlTable table;
+
+  CHECK((table.insert("https://a.test/") == std::pair{0, true}));
+  CHECK((table.insert("https://a.test/b") == std::pair{1, true}));
+  CHECK((table.insert("https://a.test/") == std::pair{0, false}));
+  CHECK(table.size() == 2);
+
+  CHECK(table.find("https://a.test/b") == 1);
+  CHECK_FALSE(table.find("https://a.test/c").has_value());
+  CHECK(table.url(1) == "https://a.test/b");
+  CHECK_THROWS_AS(table.url(2), std::out_of_range);
+}
+
+TEST_CASE("UrlTable grows past its first segment and shard tables")
+{
+  UrlTable table(2);
+
+  for(int i = 0; i < 5000; ++i) {
+    CHECK(table.insert("https://a.test/" + std::to_string(i)).first == i);
+  }
+  for(int i = 0; i < 5000; i += 7) {
+    REQUIRE(table.find("https://a.test/" + std::to_string(i)) == i);
+    REQUIRE(table.url(i) == "https://a.test/" + std::to_string(i));
+  }
+}
+
+TEST_CASE("UrlTable assign leads a url to another id")
+{
+  UrlTable table;
+  table.insert("https://a.test/");
+  table.insert("https://a.test/print");
+
+  table.assign("https://a.test/print", 0);
+  CHECK(table.find("https://a.test/print") == 0);
+  CHECK(table.url(1) == "https://a.test/print");
+  CHECK((table.insert("https://a.test/print") == std::pair{0, false}));
+  CHECK_THROWS_AS(table.assign("https://a.test/missing", 0), std::out_of_range);
+
+  table.clear();
+  CHECK(table.size() == 0);
+  CHECK((table.insert("https://a.test/print") == std::pair{0, true}));
+}
+
+TEST_CASE("UrlTable gives every url one id across threads")
+{
+  constexpr int threads = 8;
+  constexpr int urls = 20000;
+  UrlTable table;
+  std::vector<std::vector<int>> ids(threads, std::vector<int>(urls));
+
+  // every thread inserts the same urls, in a different order
+  std::vector<std::thread> pool;
+  for(int t = 0; t < threads; ++t) {
+    pool.emplace_back([&, t]() {
+      for(int i = 0; i < urls; ++i) {
+        int n = (i * 7919 + t * 104729) % urls;
+        ids[t][n] = table.insert("https://a.test/" + std::to_string(n)).first;
+      }
+    });
+  }
+  for(std::thread& thread : pool) {
+    thread.join();
+  }
+
+  CHECK(table.size() == urls);
+  std::vector<bool> seen(urls);
+  for(int n = 0; n < urls; ++n) {
+    int id = ids[0][n];
+    for(int t = 1; t < threads; ++t) {
+      REQUIRE(ids[t][n] == id);
+    }
+    REQUIRE(id < urls);
+    REQUIRE_FALSE(seen[id]);
+    seen[id] = true;
+    REQUIRE(table.url(id) == "https://a.test/" + std::to_string(n));
+  }
+}